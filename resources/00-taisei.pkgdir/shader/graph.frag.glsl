@@ -3,6 +3,7 @@
 #include "interface/standard.glslh"
 #include "lib/util.glslh"
 
+// Keep in sync with GRAPH_SHADER_POINTS in stagedraw.c
 #define POINTS 120
 // #define INTERPOLATE
 
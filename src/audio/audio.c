@@ -20,9 +20,11 @@
 #define SFX_STOP_FADETIME 0.15
 #define SFX_LOOPSTOP_FADETIME 0.05
 #define SFX_LOOPUNSTOP_FADETIME 0.02
+#define SFX_DELAY_QUEUE_SIZE 64
 
 struct SFX {
 	SFXImpl *impl;
+	SFXHandle handle;
 	int lastplayframe;
 	bool looping;
 
@@ -35,16 +37,31 @@ struct SFX {
 #define B (_a_backend.funcs)
 
 struct enqueued_sound {
-	LIST_INTERFACE(struct enqueued_sound);
-	char *name;
+	SFXHandle sfx;
 	int time;
 	int cooldown;
 	bool replace;
 };
 
+typedef struct SFXHandleData {
+	char *name;
+	SFX *sfx;  // NULL if not resolved since the resource was (re)loaded
+} SFXHandleData;
+
 static struct {
 	ht_str2int_t sfx_volumes;
-	struct enqueued_sound *sound_queue;
+
+	struct {
+		ht_str2int_t lookup;  // name -> handle
+		DYNAMIC_ARRAY(SFXHandleData) data;  // indexed by handle - 1
+	} sfx_handles;
+
+	// Only sounds in here need per-frame bookkeeping.
+	DYNAMIC_ARRAY(SFX*) active_loops;
+
+	// Reserves SFX_DELAY_QUEUE_SIZE entries on first use, and only grows past that if it must.
+	DYNAMIC_ARRAY(struct enqueued_sound) sound_queue;
+
 	uint32_t *chan_play_ids;
 	uint32_t play_counter;
 	int sfx_chan_first, sfx_chan_last;
@@ -79,6 +96,7 @@ static bool store_sfx_volume(const char *key, const char *val, void *data) {
 
 static void load_config_files(void) {
 	ht_create(&audio.sfx_volumes);
+	ht_create(&audio.sfx_handles.lookup);
 	parse_keyvalue_file_cb(SFX_PATH_PREFIX "volumes.conf", store_sfx_volume, NULL);
 }
 
@@ -141,6 +159,15 @@ void audio_shutdown(void) {
 	events_unregister_handler(audio_config_updated);
 	B.shutdown();
 	ht_destroy(&audio.sfx_volumes);
+
+	dynarray_foreach_elem(&audio.sfx_handles.data, SFXHandleData *h, {
+		mem_free(h->name);
+	});
+
+	dynarray_free_data(&audio.sfx_handles.data);
+	ht_destroy(&audio.sfx_handles.lookup);
+	dynarray_free_data(&audio.active_loops);
+	dynarray_free_data(&audio.sound_queue);
 }
 
 bool audio_output_works(void) {
@@ -166,11 +193,76 @@ SFX *audio_sfx_load(const char *name, const char *path) {
 	return ALLOC(SFX, { .impl = impl });
 }
 
+static void remove_active_loop_at(uint idx) {
+	// Order doesn't matter here
+	auto loops = &audio.active_loops;
+	dynarray_get(loops, idx) = dynarray_get(loops, loops->num_elements - 1);
+	--loops->num_elements;
+}
+
+static void remove_active_loop(SFX *sfx) {
+	dynarray_foreach(&audio.active_loops, int i, SFX **loop, {
+		if(*loop == sfx) {
+			remove_active_loop_at(i);
+			return;
+		}
+	});
+}
+
 void audio_sfx_destroy(SFX *sfx) {
+	if(sfx->handle) {
+		dynarray_get_ptr(&audio.sfx_handles.data, sfx->handle - 1)->sfx = NULL;
+	}
+
+	if(sfx->looping) {
+		remove_active_loop(sfx);
+	}
+
 	B.sfx_unload(sfx->impl);
 	mem_free(sfx);
 }
 
+SFXHandle sfx_handle(const char *name) {
+	assert(is_main_thread());
+
+	SFXHandle h = ht_get(&audio.sfx_handles.lookup, name, 0);
+
+	if(!h) {
+		*dynarray_append(&audio.sfx_handles.data) = (SFXHandleData) {
+			.name = strdup(name),
+		};
+
+		h = audio.sfx_handles.data.num_elements;
+		ht_set(&audio.sfx_handles.lookup, name, h);
+	}
+
+	return h;
+}
+
+void audio_sfx_bind_handle(SFX *sfx, const char *name) {
+	SFXHandle h = sfx_handle(name);
+	sfx->handle = h;
+	dynarray_get_ptr(&audio.sfx_handles.data, h - 1)->sfx = sfx;
+}
+
+static SFX *sfx_from_handle(SFXHandle h) {
+	SFXHandleData *data = dynarray_get_ptr(&audio.sfx_handles.data, h - 1);
+
+	if(UNLIKELY(!data->sfx)) {
+		// Not loaded yet. Loading binds the sound to the handle (see audio_sfx_bind_handle).
+		SFX *sfx = res_sfx(data->name);
+
+		if(!sfx) {
+			return NULL;
+		}
+
+		sfx->handle = h;
+		data->sfx = sfx;
+	}
+
+	return data->sfx;
+}
+
 static bool is_skip_mode(void) {
 	return global.frameskip || stage_is_skip_mode();
 }
@@ -243,19 +335,19 @@ static SFXPlayID submit_play_sfx(
 }
 
 static SFXPlayID play_sound_internal(
-	const char *name, bool is_ui, int cooldown, bool replace, int delay
+	SFXHandle h, bool is_ui, int cooldown, bool replace, int delay
 ) {
 	if(!audio_output_works() || is_skip_mode()) {
 		return 0;
 	}
 
 	if(delay > 0) {
-		list_push(&audio.sound_queue, ALLOC(struct enqueued_sound, {
+		*dynarray_append_with_min_capacity(&audio.sound_queue, SFX_DELAY_QUEUE_SIZE) = (struct enqueued_sound) {
 			.time = global.frames + delay,
-			.name = strdup(name),
+			.sfx = h,
 			.cooldown = cooldown,
 			.replace = replace,
-		}));
+		};
 		return 0;
 	}
 
@@ -263,7 +355,7 @@ static SFXPlayID play_sound_internal(
 		return 0;
 	}
 
-	SFX *sfx = res_sfx(name);
+	SFX *sfx = sfx_from_handle(h);
 
 	if(!sfx || (!is_ui && sfx->lastplayframe + 3 + cooldown >= global.frames)) {
 		return 0;
@@ -282,37 +374,53 @@ static SFXPlayID play_sound_internal(
 	return submit_play_sfx(sfx, group, ch, false);
 }
 
-static void *discard_enqueued_sound(List **queue, List *vsnd, void *arg) {
-	struct enqueued_sound *snd = (struct enqueued_sound*)vsnd;
-	mem_free(snd->name);
-	mem_free(list_unlink(queue, vsnd));
-	return NULL;
-}
+static void play_enqueued_sounds(void) {
+	// Newest first, like when this used to be a linked list
+	for(uint i = audio.sound_queue.num_elements; i-- > 0;) {
+		struct enqueued_sound *snd = dynarray_get_ptr(&audio.sound_queue, i);
+
+		if(snd->time > global.frames) {
+			continue;
+		}
+
+		if(!is_skip_mode()) {
+			play_sound_internal(snd->sfx, false, snd->cooldown, snd->replace, 0);
+		}
 
-static void *play_enqueued_sound(struct enqueued_sound **queue, struct enqueued_sound *snd, void *arg) {
-	if(!is_skip_mode()) {
-		play_sound_internal(snd->name, false, snd->cooldown, snd->replace, 0);
+		memmove(snd, snd + 1, (--audio.sound_queue.num_elements - i) * sizeof(*snd));
 	}
+}
 
-	mem_free(snd->name);
-	mem_free(list_unlink(queue, snd));
-	return NULL;
+SFXPlayID (play_sfx)(const char *name) {
+	return play_sfx_handle(sfx_handle(name));
+}
+
+SFXPlayID (play_sfx_ex)(const char *name, int cooldown, bool replace) {
+	return play_sfx_ex_handle(sfx_handle(name), cooldown, replace);
+}
+
+void (play_sfx_delayed)(const char *name, int cooldown, bool replace, int delay) {
+	play_sfx_delayed_handle(sfx_handle(name), cooldown, replace, delay);
+}
+
+void (play_sfx_ui)(const char *name) {
+	play_sfx_ui_handle(sfx_handle(name));
 }
 
-SFXPlayID play_sfx(const char *name) {
-	return play_sound_internal(name, false, 0, false, 0);
+SFXPlayID play_sfx_handle(SFXHandle h) {
+	return play_sound_internal(h, false, 0, false, 0);
 }
 
-SFXPlayID play_sfx_ex(const char *name, int cooldown, bool replace) {
-	return play_sound_internal(name, false, cooldown, replace, 0);
+SFXPlayID play_sfx_ex_handle(SFXHandle h, int cooldown, bool replace) {
+	return play_sound_internal(h, false, cooldown, replace, 0);
 }
 
-void play_sfx_delayed(const char *name, int cooldown, bool replace, int delay) {
-	play_sound_internal(name, false, cooldown, replace, delay);
+void play_sfx_delayed_handle(SFXHandle h, int cooldown, bool replace, int delay) {
+	play_sound_internal(h, false, cooldown, replace, delay);
 }
 
-void play_sfx_ui(const char *name) {
-	play_sound_internal(name, true, 0, true, 0);
+void play_sfx_ui_handle(SFXHandle h) {
+	play_sound_internal(h, true, 0, true, 0);
 }
 
 static void stop_sfx_fadeout(SFXPlayID sid, double fadeout) {
@@ -329,15 +437,19 @@ void stop_sfx(SFXPlayID sid) {
 
 void replace_sfx(SFXPlayID sid, const char *name) {
 	stop_sfx(sid);
-	play_sfx(name);
+	play_sfx_handle(sfx_handle(name));
 }
 
-void play_sfx_loop(const char *name) {
+void (play_sfx_loop)(const char *name) {
+	play_sfx_loop_handle(sfx_handle(name));
+}
+
+void play_sfx_loop_handle(SFXHandle h) {
 	if(!audio_output_works() || is_skip_mode() || !audio.sfx_enabled) {
 		return;
 	}
 
-	SFX *sfx = res_sfx(name);
+	SFX *sfx = sfx_from_handle(h);
 
 	if(!sfx) {
 		return;
@@ -350,6 +462,7 @@ void play_sfx_loop(const char *name) {
 	}
 
 	sfx->looping = true;
+	*dynarray_append(&audio.active_loops) = sfx;
 
 	// If a previous loop is fading out, try to quickly fade it back in.
 	// Otherwise, start a new loop.
@@ -371,41 +484,43 @@ static void stop_sfx_loop(SFX *sfx, double fadeout) {
 	}
 }
 
-static void *update_sounds_callback(const char *name, Resource *res, void *arg) {
-	bool reset = (intptr_t)arg;
+static void *reset_sound_callback(const char *name, Resource *res, void *arg) {
 	SFX *sfx = res->data;
 
 	if(UNLIKELY(!sfx)) {
 		return NULL;
 	}
 
-	if(sfx->looping && (reset || global.frames > sfx->lastplayframe + LOOPTIMEOUTFRAMES)) {
+	if(sfx->looping) {
 		stop_sfx_loop(sfx, SFX_LOOPSTOP_FADETIME);
 		sfx->looping = false;
 	}
 
-	if(reset) {
-		sfx->lastplayframe = 0;
-	}
-
+	sfx->lastplayframe = 0;
 	return NULL;
 }
 
 void reset_all_sfx(void) {
-	resource_for_each(RES_SFX, update_sounds_callback, (void*)true);
-	list_foreach(&audio.sound_queue, discard_enqueued_sound, NULL);
+	resource_for_each(RES_SFX, reset_sound_callback, NULL);
+	audio.active_loops.num_elements = 0;
+	audio.sound_queue.num_elements = 0;
 }
 
 void update_all_sfx(void) {
-	resource_for_each(RES_SFX, update_sounds_callback, (void*)false);
-
-	for(struct enqueued_sound *s = audio.sound_queue, *next; s; s = next) {
-		next = (struct enqueued_sound*)s->next;
-
-		if(s->time <= global.frames) {
-			play_enqueued_sound(&audio.sound_queue, s, NULL);
+	for(uint i = 0; i < audio.active_loops.num_elements;) {
+		SFX *sfx = dynarray_get(&audio.active_loops, i);
+		assert(sfx->looping);
+
+		if(global.frames > sfx->lastplayframe + LOOPTIMEOUTFRAMES) {
+			stop_sfx_loop(sfx, SFX_LOOPSTOP_FADETIME);
+			sfx->looping = false;
+			remove_active_loop_at(i);
+		} else {
+			++i;
 		}
 	}
+
+	play_enqueued_sounds();
 }
 
 void pause_all_sfx(void) {
@@ -27,6 +27,9 @@ typedef enum {
 
 typedef uint64_t SFXPlayID;
 
+// Interned SFX name; 0 is never a valid handle.
+typedef uint32_t SFXHandle;
+
 typedef enum BGMStatus {
 	BGM_STOPPED,
 	BGM_PLAYING,
@@ -51,16 +54,52 @@ BGM *audio_bgm_current(void);
 
 SFX *audio_sfx_load(const char *name, const char *path) attr_nodiscard attr_nonnull(1, 2);
 void audio_sfx_destroy(SFX *sfx) attr_nonnull(1);
+// Binds a freshly loaded sound to the handle of its name. Must be called from the main thread.
+void audio_sfx_bind_handle(SFX *sfx, const char *name) attr_nonnull(1, 2);
 
 bool audio_sfx_set_enabled(bool enabled);
 
 // TODO modernize sfx API
 
-SFXPlayID play_sfx(const char *name) attr_nonnull(1);
-SFXPlayID play_sfx_ex(const char *name, int cooldown, bool replace) attr_nonnull(1);
-void play_sfx_delayed(const char *name, int cooldown, bool replace, int delay) attr_nonnull(1);
-void play_sfx_loop(const char *name) attr_nonnull(1);
-void play_sfx_ui(const char *name) attr_nonnull(1);
+// Returns the handle for an SFX name, creating it if needed. Handles stay valid for the rest of the
+// session, even if the sound is unloaded. Sounds are bound to their handles when they finish
+// loading, so playing a preloaded sound through a handle never looks it up by name.
+// Must be called from the main thread.
+SFXHandle sfx_handle(const char *name) attr_nonnull(1);
+
+// Like sfx_handle(), but caches the result at the call site. [name] must be a string literal.
+#define SFX_HANDLE(name) ({ \
+	static SFXHandle _sfx_handle; \
+	if(UNLIKELY(!_sfx_handle)) { \
+		_sfx_handle = sfx_handle("" name ""); \
+	} \
+	_sfx_handle; \
+})
+
+SFXPlayID play_sfx_handle(SFXHandle h);
+SFXPlayID play_sfx_ex_handle(SFXHandle h, int cooldown, bool replace);
+void play_sfx_delayed_handle(SFXHandle h, int cooldown, bool replace, int delay);
+void play_sfx_loop_handle(SFXHandle h);
+void play_sfx_ui_handle(SFXHandle h);
+
+SFXPlayID (play_sfx)(const char *name) attr_nonnull(1);
+SFXPlayID (play_sfx_ex)(const char *name, int cooldown, bool replace) attr_nonnull(1);
+void (play_sfx_delayed)(const char *name, int cooldown, bool replace, int delay) attr_nonnull(1);
+void (play_sfx_loop)(const char *name) attr_nonnull(1);
+void (play_sfx_ui)(const char *name) attr_nonnull(1);
+
+// These only accept string literals, and resolve the handle once per call site. To play a sound by
+// a name only known at runtime, call the function instead, e.g. (play_sfx)(name).
+#define play_sfx(name) \
+	play_sfx_handle(SFX_HANDLE(name))
+#define play_sfx_ex(name, cooldown, replace) \
+	play_sfx_ex_handle(SFX_HANDLE(name), cooldown, replace)
+#define play_sfx_delayed(name, cooldown, replace, delay) \
+	play_sfx_delayed_handle(SFX_HANDLE(name), cooldown, replace, delay)
+#define play_sfx_loop(name) \
+	play_sfx_loop_handle(SFX_HANDLE(name))
+#define play_sfx_ui(name) \
+	play_sfx_ui_handle(SFX_HANDLE(name))
 void stop_sfx(SFXPlayID sid);
 void replace_sfx(SFXPlayID sid, const char *name) attr_nonnull(2);
 void reset_all_sfx(void);
@@ -74,12 +113,12 @@ DEFINE_DEPRECATED_RESOURCE_GETTER(BGM, get_music, res_bgm)
 
 attr_deprecated("Use play_sfx() instead")
 INLINE SFXPlayID play_sound(const char *name) {
-	return play_sfx(name);
+	return (play_sfx)(name);
 }
 
 attr_deprecated("Use play_sfx_ex() instead") attr_nonnull(1)
 INLINE SFXPlayID play_sound_ex(const char *name, int cooldown, bool replace) {
-	return play_sfx_ex(name, cooldown, replace);
+	return (play_sfx_ex)(name, cooldown, replace);
 }
 
 attr_deprecated("Use stop_sfx() instead")
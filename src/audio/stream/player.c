@@ -14,6 +14,8 @@
 // #define SPAM(...) log_debug(__VA_ARGS__)
 #define SPAM(...) ((void)0)
 
+#define SCRATCH_ALIGNMENT 64
+
 typedef float sample_t;
 
 struct stereo_frame {
@@ -81,6 +83,7 @@ void splayer_shutdown(StreamPlayer *plr) {
 	}
 
 	mem_free(plr->channels);
+	mem_free(plr->scratch.data);
 }
 
 static inline void splayer_stream_ended(StreamPlayer *plr, int chan) {
@@ -88,13 +91,17 @@ static inline void splayer_stream_ended(StreamPlayer *plr, int chan) {
 	splayer_halt(plr, chan);
 }
 
-static size_t splayer_process_channel(StreamPlayer *plr, int chan, size_t bufsize, void *buffer) {
+static inline bool splayer_channel_is_playing(StreamPlayerChannel *pchan) {
+	return !pchan->paused && pchan->stream;
+}
+
+static size_t splayer_process_channel(
+	StreamPlayer *plr, int chan, size_t bufsize, void *buffer, void *pipe_staging_buffer
+) {
 	AudioStreamReadFlags rflags = 0;
 	StreamPlayerChannel *pchan = plr->channels + chan;
 
-	if(pchan->paused || !pchan->stream) {
-		return 0;
-	}
+	assert(splayer_channel_is_playing(pchan));
 
 	if(pchan->looping) {
 		rflags |= ASTREAM_READ_LOOP;
@@ -109,7 +116,6 @@ static size_t splayer_process_channel(StreamPlayer *plr, int chan, size_t bufsiz
 		// convert/resample
 
 		do {
-			uint8_t staging_buffer[bufsize];
 			ssize_t read = SDL_AudioStreamGet(pipe, buf, buf_end - buf);
 
 			if(UNLIKELY(read < 0)) {
@@ -123,7 +129,7 @@ static size_t splayer_process_channel(StreamPlayer *plr, int chan, size_t bufsiz
 				break;
 			}
 
-			read = astream_read_into_sdl_stream(astream, pipe, sizeof(staging_buffer), staging_buffer, rflags);
+			read = astream_read_into_sdl_stream(astream, pipe, bufsize, pipe_staging_buffer, rflags);
 
 			if(read <= 0) {
 				SDL_AudioStreamFlush(pipe);
@@ -150,6 +156,45 @@ static size_t splayer_process_channel(StreamPlayer *plr, int chan, size_t bufsiz
 	return bufsize - (buf_end - buf);
 }
 
+/*
+ * Mixing kernels. These are plain loops over restrict-qualified buffers, which compilers readily
+ * vectorize for whatever SIMD instruction set the target has. The input always points into the
+ * staging scratch buffer.
+ */
+
+static void mix_samples(
+	size_t num_samples, sample_t *restrict out, const sample_t *restrict in, float gain
+) {
+	for(size_t i = 0; i < num_samples; ++i) {
+		out[i] += in[i] * gain;
+	}
+}
+
+static void mix_frames_ramp(
+	uint num_frames, struct stereo_frame *restrict out, const struct stereo_frame *restrict in,
+	float ramp_start, float ramp_step, float gain
+) {
+	// Fades always start at the beginning of the buffer
+	in = ASSUME_ALIGNED(in, SCRATCH_ALIGNMENT);
+
+	for(uint i = 0; i < num_frames; ++i) {
+		float g = ramp_start + ramp_step * i;
+		out[i].l += in[i].l * g * gain;
+		out[i].r += in[i].r * g * gain;
+	}
+}
+
+static void splayer_ensure_scratch(StreamPlayer *plr, size_t bufsize) {
+	// Normally this only allocates on the first callback, since the buffer size doesn't change.
+	size_t size = 2 * topow2_u64(bufsize);
+
+	if(UNLIKELY(size > plr->scratch.size)) {
+		mem_free(plr->scratch.data);
+		plr->scratch.data = mem_alloc_aligned(size, SCRATCH_ALIGNMENT);
+		plr->scratch.size = size;
+	}
+}
+
 void splayer_process(StreamPlayer *plr, size_t bufsize, void *vbuffer) {
 	if(plr->paused) {
 		return;
@@ -158,57 +203,66 @@ void splayer_process(StreamPlayer *plr, size_t bufsize, void *vbuffer) {
 	float gain = plr->gain;
 	int num_channels = plr->num_channels;
 	union audio_buffer out_buffer = { vbuffer };
+	union audio_buffer staging_buffer = { NULL };
+	void *pipe_staging_buffer = NULL;
 
 	for(int i = 0; i < num_channels; ++i) {
-		uint8_t staging_buffer_bytes[bufsize];
-		union audio_buffer staging_buffer = { staging_buffer_bytes };
-		size_t chan_bytes = splayer_process_channel(plr, i, sizeof(staging_buffer_bytes), staging_buffer_bytes);
+		StreamPlayerChannel *pchan = plr->channels + i;
 
-		if(chan_bytes) {
-			assert(chan_bytes <= bufsize);
-			assert(chan_bytes % sizeof(struct stereo_frame) == 0);
+		if(!splayer_channel_is_playing(pchan)) {
+			continue;
+		}
 
-			StreamPlayerChannel *pchan = plr->channels + i;
-			float chan_gain = gain * pchan->gain;
-			uint num_staging_frames = chan_bytes / sizeof(struct stereo_frame);
-			uint fade_steps = pchan->fade.num_steps;
+		if(!staging_buffer.bytes) {
+			splayer_ensure_scratch(plr, bufsize);
+			staging_buffer.bytes = plr->scratch.data;
+			pipe_staging_buffer = plr->scratch.data + plr->scratch.size / 2;
+		}
 
-			if(fade_steps) {
-				float fade_step = pchan->fade.step;
-				float fade_gain = pchan->fade.gain;
+		size_t chan_bytes = splayer_process_channel(plr, i, bufsize, staging_buffer.bytes, pipe_staging_buffer);
 
-				if(fade_steps > num_staging_frames) {
-					fade_steps = num_staging_frames;
-				}
+		if(!chan_bytes) {
+			continue;
+		}
 
-				for(uint i = 0; i < fade_steps; ++i) {
-					float g = fade_gain + fade_step * i;
-					staging_buffer.frames[i].l *= g;
-					staging_buffer.frames[i].r *= g;
-				}
+		assert(chan_bytes <= bufsize);
+		assert(chan_bytes % sizeof(struct stereo_frame) == 0);
 
-				if((pchan->fade.num_steps -= fade_steps) == 0) {
-					// fade finished
+		float chan_gain = gain * pchan->gain;
+		uint num_staging_frames = chan_bytes / sizeof(struct stereo_frame);
+		uint fade_steps = pchan->fade.num_steps;
+		float fade_step = pchan->fade.step;
+		float fade_gain = pchan->fade.gain;
+
+		if(fade_steps) {
+			if(fade_steps > num_staging_frames) {
+				fade_steps = num_staging_frames;
+			}
 
-					if(pchan->fade.target == 0) {
-						splayer_stream_ended(plr, i);
-						continue;
-					}
+			if((pchan->fade.num_steps -= fade_steps) == 0) {
+				// fade finished
 
-					pchan->fade.gain = pchan->fade.target;
-					chan_gain *= pchan->fade.gain;
-				} else {
-					pchan->fade.gain += fade_step * fade_steps;
+				if(pchan->fade.target == 0) {
+					splayer_stream_ended(plr, i);
+					continue;
 				}
-			} else {
-				chan_gain *= pchan->fade.gain;
-			}
 
-			for(uint i = 0; i < num_staging_frames; ++i) {
-				out_buffer.frames[i].l += staging_buffer.frames[i].l * chan_gain;
-				out_buffer.frames[i].r += staging_buffer.frames[i].r * chan_gain;
+				pchan->fade.gain = pchan->fade.target;
+				chan_gain *= pchan->fade.gain;
+			} else {
+				pchan->fade.gain += fade_step * fade_steps;
 			}
+		} else {
+			chan_gain *= pchan->fade.gain;
 		}
+
+		mix_frames_ramp(fade_steps, out_buffer.frames, staging_buffer.frames, fade_gain, fade_step, chan_gain);
+		mix_samples(
+			(num_staging_frames - fade_steps) * 2,
+			out_buffer.samples + fade_steps * 2,
+			staging_buffer.samples + fade_steps * 2,
+			chan_gain
+		);
 	}
 }
 
@@ -35,6 +35,12 @@ struct StreamPlayer {
 	StreamPlayerChannel *channels;
 	LIST_ANCHOR(StreamPlayerChannel) channel_history;
 	AudioStreamSpec dst_spec;
+	struct {
+		// Staging buffers for splayer_process. Grown on demand to fit two audio buffers (one for a
+		// channel's output, one for feeding its conversion pipe), and reused afterwards.
+		uint8_t *data;
+		size_t size;
+	} scratch;
 	float gain;
 	int num_channels;
 	bool paused;
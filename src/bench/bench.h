@@ -0,0 +1,44 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2026, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2026, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#pragma once
+#include "taisei.h"
+
+#include "hirestime.h"
+
+#include <SDL.h>
+
+/*
+ * Offline benchmarks of engine subsystems, built into the separate taisei-bench executable when
+ * the benchmarks meson option is enabled. Each one writes a JSON report into [out] and returns an
+ * exit status. [arg] is the optional command line argument; NULL if not given.
+ */
+
+typedef int (*BenchFunc)(const char *arg, SDL_RWops *out);
+
+int bench_coroutines(const char *arg, SDL_RWops *out);
+int bench_geometry(const char *arg, SDL_RWops *out);
+int bench_log(const char *arg, SDL_RWops *out);
+int bench_mixer(const char *arg, SDL_RWops *out);
+int bench_pixmap_convert(const char *arg, SDL_RWops *out);
+int bench_rectpack(const char *arg, SDL_RWops *out);
+int bench_shader_cache(const char *arg, SDL_RWops *out);
+int bench_taskmgr(const char *arg, SDL_RWops *out);
+
+// Sets up logging into stderr, which keeps stdout free for the report.
+void bench_init_log(void);
+
+// Parses a positive integer argument, or returns [fallback] if [arg] is NULL.
+uint bench_arg_uint(const char *arg, uint fallback, const char *what);
+
+// Parses a positive number argument, or returns [fallback] if [arg] is NULL.
+double bench_arg_double(const char *arg, double fallback, const char *what);
+
+INLINE double bench_usec(hrtime_t t) {
+	return t * 1e6 / HRTIME_RESOLUTION;
+}
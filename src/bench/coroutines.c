@@ -0,0 +1,150 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2026, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2026, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#include "taisei.h"
+
+#include "bench.h"
+#include "coroutine.h"
+#include "log.h"
+#include "util.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+/*
+ * Spawns COUNT tasks of each stack class, all of them kept alive at once, and reports the time
+ * per spawn and the memory the process gained per task. "cold" allocates fresh stacks; "warm"
+ * recycles the ones pooled by the cold run. Memory is only available on Linux, where it's read
+ * from /proc/self/statm; "virtual" grows with the stack size, "resident" with the pages the
+ * tasks actually touched.
+ */
+
+typedef struct MemUsage {
+	int64_t virt;
+	int64_t resident;
+} MemUsage;
+
+typedef struct ClassResult {
+	double spawn_usec_cold;
+	double spawn_usec_warm;
+	MemUsage mem_per_task;
+} ClassResult;
+
+static const char *const class_names[COTASK_STACK_NUM_CLASSES] = {
+	[COTASK_STACK_DEFAULT] = "default",
+	[COTASK_STACK_SMALL] = "small",
+};
+
+static bool get_mem_usage(MemUsage *mem) {
+#ifdef __linux__
+	FILE *f = fopen("/proc/self/statm", "r");
+
+	if(!f) {
+		return false;
+	}
+
+	long long pages_virt, pages_resident;
+	bool ok = fscanf(f, "%lld %lld", &pages_virt, &pages_resident) == 2;
+	fclose(f);
+
+	if(ok) {
+		long page_size = sysconf(_SC_PAGESIZE);
+		mem->virt = pages_virt * page_size;
+		mem->resident = pages_resident * page_size;
+	}
+
+	return ok;
+#else
+	return false;
+#endif
+}
+
+static void *bench_coroutine(void *arg, size_t argsize) {
+	// Stay alive until the scheduler is finished, so that every stack is in use at once.
+	for(;;) {
+		cotask_wait(1);
+	}
+
+	return NULL;
+}
+
+static hrtime_t spawn_tasks(CoSched *sched, CoTaskStackClass stack_class, uint num_tasks) {
+	hrtime_t start = time_get();
+
+	for(uint i = 0; i < num_tasks; ++i) {
+		cosched_new_task(sched, bench_coroutine, NULL, 0, stack_class, "bench");
+	}
+
+	return time_get() - start;
+}
+
+static bool bench_class(CoTaskStackClass stack_class, uint num_tasks, ClassResult *result) {
+	CoSched sched;
+	MemUsage mem_before, mem_after;
+	bool have_mem = get_mem_usage(&mem_before);
+
+	cosched_init(&sched);
+	hrtime_t t_cold = spawn_tasks(&sched, stack_class, num_tasks);
+	have_mem = get_mem_usage(&mem_after) && have_mem;
+	cosched_finish(&sched);
+
+	cosched_init(&sched);
+	hrtime_t t_warm = spawn_tasks(&sched, stack_class, num_tasks);
+	cosched_finish(&sched);
+
+	// Drop the pooled stacks, so that the next class starts cold too.
+	coroutines_shutdown();
+	coroutines_init();
+
+	result->spawn_usec_cold = bench_usec(t_cold) / num_tasks;
+	result->spawn_usec_warm = bench_usec(t_warm) / num_tasks;
+
+	if(have_mem) {
+		result->mem_per_task.virt = (mem_after.virt - mem_before.virt) / num_tasks;
+		result->mem_per_task.resident = (mem_after.resident - mem_before.resident) / num_tasks;
+	}
+
+	return have_mem;
+}
+
+int bench_coroutines(const char *arg, SDL_RWops *out) {
+	uint num_tasks = bench_arg_uint(arg, 2000, "Task count");
+	ClassResult results[COTASK_STACK_NUM_CLASSES] = { 0 };
+	bool have_mem = true;
+
+	coroutines_init();
+
+	for(uint i = 0; i < ARRAY_SIZE(results); ++i) {
+		have_mem = bench_class(i, num_tasks, results + i) && have_mem;
+	}
+
+	coroutines_shutdown();
+
+	SDL_RWprintf(out, "{\n");
+	SDL_RWprintf(out, "  \"tasks\": %u,\n", num_tasks);
+
+	for(uint i = 0; i < ARRAY_SIZE(results); ++i) {
+		ClassResult *r = results + i;
+		SDL_RWprintf(out, "  \"%s\": {\n", class_names[i]);
+		SDL_RWprintf(out, "    \"spawn_usec\": { \"cold\": %.3f, \"warm\": %.3f },\n",
+			r->spawn_usec_cold, r->spawn_usec_warm);
+
+		if(have_mem) {
+			SDL_RWprintf(out, "    \"bytes_per_task\": { \"virtual\": %lld, \"resident\": %lld }\n",
+				(long long)r->mem_per_task.virt, (long long)r->mem_per_task.resident);
+		} else {
+			SDL_RWprintf(out, "    \"bytes_per_task\": null\n");
+		}
+
+		SDL_RWprintf(out, "  }%s\n", i + 1 < ARRAY_SIZE(results) ? "," : "");
+	}
+
+	SDL_RWprintf(out, "}\n");
+	return 0;
+}
@@ -0,0 +1,228 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2026, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2026, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#include "taisei.h"
+
+#include "bench.h"
+#include "log.h"
+#include "random.h"
+#include "util.h"
+#include "util/geometry.h"
+
+/*
+ * Checks the collision tests in util/geometry.c against the straightforward versions they
+ * replaced, over a fixed set of seeded random cases. Collisions decide replay outcomes, so any
+ * mismatch fails the run. Also reports the time per case of the projectile collision test
+ * (hitbox, then graze area) done both ways.
+ */
+
+#define GEOMETRY_SEED 0x7a15e1
+
+// The reference versions below are kept exactly as they were before the optimization.
+
+static bool ref_point_in_ellipse(cmplx p, Ellipse e) {
+	double Xp = creal(p);
+	double Yp = cimag(p);
+	double Xe = creal(e.origin);
+	double Ye = cimag(e.origin);
+	double a = e.angle;
+
+	Rect e_bbox = ellipse_bbox(e);
+
+	return point_in_rect(p, e_bbox) && (
+		pow(cos(a) * (Xp - Xe) + sin(a) * (Yp - Ye), 2) / pow(creal(e.axes)/2, 2) +
+		pow(sin(a) * (Xp - Xe) - cos(a) * (Yp - Ye), 2) / pow(cimag(e.axes)/2, 2)
+	) <= 1;
+}
+
+static bool ref_segment_ellipse_nonintersection_heuristic(LineSegment seg, Ellipse e) {
+	Rect seg_bbox = lineseg_bbox(seg);
+	Rect e_bbox = ellipse_bbox(e);
+	return !rect_rect_intersect(seg_bbox, e_bbox, true, true);
+}
+
+static double ref_lineseg_circle_intersect_fallback(LineSegment seg, Circle c) {
+	double rad2 = c.radius * c.radius;
+
+	double f = lineseg_closest_factor(seg, c.origin);
+	cmplx p = clerp(seg.a, seg.b, f);
+
+	if(cabs2(p - c.origin) <= rad2) {
+		return f;
+	}
+
+	return -1;
+}
+
+static bool ref_lineseg_ellipse_intersect(LineSegment seg, Ellipse e) {
+	if(ref_segment_ellipse_nonintersection_heuristic(seg, e)) {
+		return false;
+	}
+
+	seg.a -= e.origin;
+	seg.b -= e.origin;
+
+	double ratio = creal(e.axes) / cimag(e.axes);
+	cmplx rotation = cexp(I * -e.angle);
+	seg.a *= rotation;
+	seg.b *= rotation;
+	seg.a = creal(seg.a) + I * ratio * cimag(seg.a);
+	seg.b = creal(seg.b) + I * ratio * cimag(seg.b);
+
+	Circle c = { .radius = creal(e.axes) / 2 };
+	return ref_lineseg_circle_intersect_fallback(seg, c) >= 0;
+}
+
+static int ref_lineseg_ellipses_intersect(LineSegment seg, cmplx origin, double angle, uint num_ellipses, const cmplx axes[num_ellipses]) {
+	for(uint i = 0; i < num_ellipses; ++i) {
+		Ellipse e = { .origin = origin, .axes = axes[i], .angle = angle };
+
+		if(ref_lineseg_ellipse_intersect(seg, e)) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+typedef struct GeometryCase {
+	LineSegment seg;
+	cmplx point;
+	cmplx origin;
+	double angle;
+	cmplx axes[2];
+	uint num_axes;
+} GeometryCase;
+
+static cmplx rand_point(RandomState *rng, double range) {
+	return CMPLX(
+		vrng_f64_range(rng_next_p(rng), -range, range),
+		vrng_f64_range(rng_next_p(rng), -range, range)
+	);
+}
+
+static void make_case(RandomState *rng, GeometryCase *c) {
+	// Sizes and distances in the range of projectile hitboxes and player movement per frame.
+	c->origin = rand_point(rng, 8);
+	c->angle = vrng_f64_angle(rng_next_p(rng));
+	c->seg.a = rand_point(rng, 48);
+
+	switch(vrng_i32_range(rng_next_p(rng), 0, 4)) {
+		case 0:  c->seg.b = c->seg.a; break;  // standing still
+		case 1:  c->seg.b = c->seg.a + rand_point(rng, 2); break;
+		default: c->seg.b = rand_point(rng, 48); break;
+	}
+
+	c->point = rand_point(rng, 32);
+
+	if(vrng_bool(rng_next_p(rng))) {
+		// circular
+		double d = vrng_f64_range(rng_next_p(rng), 0.5, 24);
+		c->axes[0] = CMPLX(d, d);
+	} else {
+		c->axes[0] = CMPLX(vrng_f64_range(rng_next_p(rng), 0.5, 24), vrng_f64_range(rng_next_p(rng), 0.5, 24));
+	}
+
+	c->axes[1] = c->axes[0] * vrng_f64_range(rng_next_p(rng), 1, 4);
+	c->num_axes = vrng_bool(rng_next_p(rng)) ? 2 : 1;
+}
+
+int bench_geometry(const char *arg, SDL_RWops *out) {
+	uint num_cases = bench_arg_uint(arg, 1000000, "Case count");
+	GeometryCase *cases = ALLOC_ARRAY(num_cases, GeometryCase);
+
+	RandomState rng;
+	rng_init(&rng, GEOMETRY_SEED);
+
+	for(uint i = 0; i < num_cases; ++i) {
+		make_case(&rng, cases + i);
+	}
+
+	uint mismatch_point_in_ellipse = 0;
+	uint mismatch_circle_bbox = 0;
+	uint mismatch_ellipse = 0;
+	uint mismatch_ellipses = 0;
+	uint num_hits = 0;
+
+	for(uint i = 0; i < num_cases; ++i) {
+		GeometryCase *c = cases + i;
+		Ellipse e = { .origin = c->origin, .axes = c->axes[0], .angle = c->angle };
+
+		if(point_in_ellipse(c->point, e) != ref_point_in_ellipse(c->point, e)) {
+			++mismatch_point_in_ellipse;
+		}
+
+		if(point_in_ellipse_with_bbox(c->point, e, ellipse_bbox(e)) != ref_point_in_ellipse(c->point, e)) {
+			++mismatch_point_in_ellipse;
+		}
+
+		Circle circle = { .origin = c->origin, .radius = creal(c->axes[0]) / 2 };
+
+		if(cabs(c->point - circle.origin) < circle.radius && !point_in_circle_bbox(c->point, circle)) {
+			++mismatch_circle_bbox;
+		}
+
+		for(uint j = 0; j < c->num_axes; ++j) {
+			e.axes = c->axes[j];
+
+			if(lineseg_ellipse_intersect(c->seg, e) != ref_lineseg_ellipse_intersect(c->seg, e)) {
+				++mismatch_ellipse;
+			}
+		}
+
+		int hit = lineseg_ellipses_intersect(c->seg, c->origin, c->angle, c->num_axes, c->axes);
+
+		if(hit != ref_lineseg_ellipses_intersect(c->seg, c->origin, c->angle, c->num_axes, c->axes)) {
+			++mismatch_ellipses;
+		}
+
+		num_hits += hit >= 0;
+	}
+
+	volatile int sink = 0;
+	hrtime_t start = time_get();
+
+	for(uint i = 0; i < num_cases; ++i) {
+		GeometryCase *c = cases + i;
+		sink += ref_lineseg_ellipses_intersect(c->seg, c->origin, c->angle, c->num_axes, c->axes);
+	}
+
+	hrtime_t t_ref = time_get() - start;
+	start = time_get();
+
+	for(uint i = 0; i < num_cases; ++i) {
+		GeometryCase *c = cases + i;
+		sink += lineseg_ellipses_intersect(c->seg, c->origin, c->angle, c->num_axes, c->axes);
+	}
+
+	hrtime_t t_new = time_get() - start;
+	mem_free(cases);
+
+	uint mismatches = mismatch_point_in_ellipse + mismatch_circle_bbox + mismatch_ellipse + mismatch_ellipses;
+
+	SDL_RWprintf(out, "{\n");
+	SDL_RWprintf(out, "  \"cases\": %u,\n", num_cases);
+	SDL_RWprintf(out, "  \"seed\": %u,\n", GEOMETRY_SEED);
+	SDL_RWprintf(out, "  \"intersections\": %u,\n", num_hits);
+	SDL_RWprintf(out, "  \"mismatches\": {\n");
+	SDL_RWprintf(out, "    \"point_in_ellipse\": %u,\n", mismatch_point_in_ellipse);
+	SDL_RWprintf(out, "    \"point_in_circle_bbox\": %u,\n", mismatch_circle_bbox);
+	SDL_RWprintf(out, "    \"lineseg_ellipse_intersect\": %u,\n", mismatch_ellipse);
+	SDL_RWprintf(out, "    \"lineseg_ellipses_intersect\": %u\n", mismatch_ellipses);
+	SDL_RWprintf(out, "  },\n");
+	SDL_RWprintf(out, "  \"nsec_per_case\": { \"reference\": %.2f, \"optimized\": %.2f }\n",
+		bench_usec(t_ref) * 1000 / num_cases, bench_usec(t_new) * 1000 / num_cases);
+	SDL_RWprintf(out, "}\n");
+
+	if(mismatches) {
+		log_error("%u results differ from the reference implementation", mismatches);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,124 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2026, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2026, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#include "taisei.h"
+
+#include "bench.h"
+#include "log.h"
+#include "util.h"
+
+/*
+ * Every thread logs the same number of short formatted messages into a sink that discards them,
+ * first through the per-thread rings of the log thread, then through the locked synchronous path.
+ * The time includes waiting for the log thread to drain everything.
+ */
+
+#define LOG_BENCH_MAX_THREADS 8
+
+static size_t log_bench_sink_write(SDL_RWops *rw, const void *ptr, size_t size, size_t num) {
+	return num;
+}
+
+static int log_bench_sink_close(SDL_RWops *rw) {
+	SDL_FreeRW(rw);
+	return 0;
+}
+
+static SDL_RWops *log_bench_sink(void) {
+	SDL_RWops *rw = SDL_AllocRW();
+
+	if(UNLIKELY(!rw)) {
+		return NULL;
+	}
+
+	memset(rw, 0, sizeof(*rw));
+	rw->type = SDL_RWOPS_UNKNOWN;
+	rw->write = log_bench_sink_write;
+	rw->close = log_bench_sink_close;
+	return rw;
+}
+
+static int log_bench_thread(void *arg) {
+	uint num_messages = *(uint*)arg;
+
+	for(uint i = 0; i < num_messages; ++i) {
+		log_info("Benchmark message %u of %u (%s)", i, num_messages, "payload");
+	}
+
+	return 0;
+}
+
+static double log_bench_run(uint num_threads, uint num_messages) {
+	SDL_Thread *threads[LOG_BENCH_MAX_THREADS];
+	hrtime_t start = time_get();
+
+	for(uint i = 0; i < num_threads; ++i) {
+		threads[i] = SDL_CreateThread(log_bench_thread, "Log bench", &num_messages);
+	}
+
+	for(uint i = 0; i < num_threads; ++i) {
+		SDL_WaitThread(threads[i], NULL);
+	}
+
+	log_sync();
+	hrtime_t t = time_get() - start;
+
+	return num_threads * (double)num_messages * HRTIME_RESOLUTION / (double)umax(t, 1);
+}
+
+static void log_bench_mode(bool async, uint num_messages, double results[LOG_BENCH_MAX_THREADS]) {
+	// The log thread is started or not by log_init, depending on this.
+	env_set("TAISEI_LOG_ASYNC", async, true);
+	log_init(LOG_ALL);
+	log_add_output(LOG_ALL, log_bench_sink(), log_formatter_file);
+
+	for(uint i = 0; i < LOG_BENCH_MAX_THREADS; ++i) {
+		results[i] = log_bench_run(i + 1, num_messages);
+	}
+
+	log_shutdown();
+}
+
+static void log_bench_write_results(SDL_RWops *out, const char *mode, double *results, bool last) {
+	SDL_RWprintf(out, "  \"%s_msgs_per_sec\": [", mode);
+
+	for(uint i = 0; i < LOG_BENCH_MAX_THREADS; ++i) {
+		SDL_RWprintf(out, "%.0f%s", results[i], i + 1 < LOG_BENCH_MAX_THREADS ? ", " : "");
+	}
+
+	SDL_RWprintf(out, "]%s\n", last ? "" : ",");
+}
+
+int bench_log(const char *arg, SDL_RWops *out) {
+	uint num_messages = bench_arg_uint(arg, 100000, "Message count");
+	double queued[LOG_BENCH_MAX_THREADS], direct[LOG_BENCH_MAX_THREADS];
+
+	// Take over the logger; no other threads are running yet.
+	log_sync();
+	log_shutdown();
+
+	log_bench_mode(true, num_messages, queued);
+	log_bench_mode(false, num_messages, direct);
+
+	bench_init_log();
+
+	SDL_RWprintf(out, "{\n");
+	SDL_RWprintf(out, "  \"messages_per_thread\": %u,\n", num_messages);
+	SDL_RWprintf(out, "  \"threads\": [");
+
+	for(uint i = 0; i < LOG_BENCH_MAX_THREADS; ++i) {
+		SDL_RWprintf(out, "%u%s", i + 1, i + 1 < LOG_BENCH_MAX_THREADS ? ", " : "");
+	}
+
+	SDL_RWprintf(out, "],\n");
+	log_bench_write_results(out, "queued", queued, false);
+	log_bench_write_results(out, "direct", direct, true);
+	SDL_RWprintf(out, "}\n");
+
+	return 0;
+}
@@ -0,0 +1,151 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2026, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2026, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#include "taisei.h"
+
+#include <locale.h>
+
+#include "bench.h"
+#include "log.h"
+#include "util.h"
+
+typedef struct Benchmark {
+	const char *name;
+	const char *argname;
+	const char *help;
+	BenchFunc run;
+} Benchmark;
+
+static Benchmark benchmarks[] = {
+	{ "coroutines", "COUNT", "Spawn COUNT (default 2000) idle coroutine tasks per stack class; time the spawns and measure memory", bench_coroutines },
+	{ "geometry", "COUNT", "Check the collision tests against their reference versions on COUNT (default 1000000) seeded cases", bench_geometry },
+	{ "log", "MESSAGES", "Log MESSAGES messages (default 100000) from each of 1 to 8 threads into a null output", bench_log },
+#ifdef TAISEI_BUILDCONF_AUDIO_STREAM
+	{ "mixer", "SECONDS", "Mix SECONDS (default 60) of synthetic 32-channel audio as fast as possible", bench_mixer },
+#endif
+	{ "pixmap-convert", NULL, "Time the specialized pixmap format conversions against the generic ones", bench_pixmap_convert },
+	{ "rectpack", "COUNT", "Pack COUNT (default 2000) glyph-sized rects into a 2048x2048 sheet", bench_rectpack },
+	{ "shader-cache", NULL, "Time shader cache lookups in the pack file against the directory layout", bench_shader_cache },
+	{ "tasks", "COUNT", "Submit and complete COUNT (default 100000) trivial tasks in a task manager", bench_taskmgr },
+};
+
+static void print_help(void) {
+	tsfprintf(stdout,
+		"Usage: taisei-bench [-o OUTFILE] NAME [ARG]\n"
+		"Runs one of Taisei's subsystem benchmarks and writes a JSON report into OUTFILE, or stdout.\n\n"
+		"Benchmarks:\n"
+	);
+
+	for(uint i = 0; i < ARRAY_SIZE(benchmarks); ++i) {
+		Benchmark *b = benchmarks + i;
+		tsfprintf(stdout, "  %-16s %-10s %s\n", b->name, b->argname ? b->argname : "", b->help);
+	}
+}
+
+static Benchmark *find_benchmark(const char *name) {
+	for(uint i = 0; i < ARRAY_SIZE(benchmarks); ++i) {
+		if(!strcmp(benchmarks[i].name, name)) {
+			return benchmarks + i;
+		}
+	}
+
+	return NULL;
+}
+
+void bench_init_log(void) {
+	// stdout may carry the report, so keep the log out of it.
+	log_init(LOG_DEFAULT_LEVELS);
+	log_add_output(LOG_ALERT | LOG_INFO, SDL_RWFromFP(stderr, false), log_formatter_console);
+}
+
+uint bench_arg_uint(const char *arg, uint fallback, const char *what) {
+	if(!arg) {
+		return fallback;
+	}
+
+	char *endptr;
+	long val = strtol(arg, &endptr, 10);
+
+	if(!*arg || *endptr || val <= 0 || val > UINT_MAX) {
+		log_fatal("%s '%s' is not a positive number", what, arg);
+	}
+
+	return val;
+}
+
+double bench_arg_double(const char *arg, double fallback, const char *what) {
+	if(!arg) {
+		return fallback;
+	}
+
+	char *endptr;
+	double val = strtod(arg, &endptr);
+
+	if(!*arg || *endptr || !(val > 0)) {
+		log_fatal("%s '%s' is not a positive number", what, arg);
+	}
+
+	return val;
+}
+
+// shut up -Wmissing-prototypes
+int main(int argc, char **argv);
+
+attr_used
+int main(int argc, char **argv) {
+	setlocale(LC_ALL, "C");
+	main_thread_id = SDL_ThreadID();
+
+	bench_init_log();
+
+	const char *out_path = NULL;
+	int argi = 1;
+
+	if(argi + 1 < argc && !strcmp(argv[argi], "-o")) {
+		out_path = argv[argi + 1];
+		argi += 2;
+	}
+
+	if(argi < argc && (!strcmp(argv[argi], "-h") || !strcmp(argv[argi], "--help"))) {
+		print_help();
+		log_shutdown();
+		return 0;
+	}
+
+	if(argi >= argc || argc - argi > 2) {
+		print_help();
+		log_shutdown();
+		return 1;
+	}
+
+	Benchmark *b = find_benchmark(argv[argi]);
+
+	if(!b) {
+		log_fatal("Unknown benchmark '%s'; run taisei-bench --help for a list", argv[argi]);
+	}
+
+	const char *arg = argi + 1 < argc ? argv[argi + 1] : NULL;
+
+	if(arg && !b->argname) {
+		log_fatal("Benchmark '%s' takes no argument", b->name);
+	}
+
+	SDL_RWops *out = out_path ? SDL_RWFromFile(out_path, "w") : SDL_RWFromFP(stdout, false);
+
+	if(!out) {
+		log_sdl_error(LOG_FATAL, "SDL_RWFromFile");
+	}
+
+	time_init();
+	int status = b->run(arg, out);
+	time_shutdown();
+
+	SDL_RWclose(out);
+	log_shutdown();
+	return status;
+}
@@ -0,0 +1,123 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2026, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2026, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#include "taisei.h"
+
+#include "bench.h"
+#include "audio/stream/player.h"
+#include "audio/stream/stream_pcm.h"
+#include "util.h"
+
+#define BENCH_NUM_CHANNELS 32
+#define BENCH_SAMPLE_RATE 48000
+#define BENCH_BUFFER_FRAMES 1024
+#define BENCH_SOUND_LENGTH 0.25
+#define BENCH_FADE_TIME 0.05
+#define BENCH_RESTART_INTERVAL 4  // in buffers
+
+/*
+ * Offline benchmark of the mixing path. Every channel loops a short tone; half of them are already
+ * in the output format, and the other half are 16-bit 44.1kHz and go through a conversion pipe.
+ * One channel is restarted with a fade-in every few buffers, like SFX bursts would do.
+ */
+
+static void *make_tone(const AudioStreamSpec *spec, double freq, size_t *out_size) {
+	uint num_frames = spec->sample_rate * BENCH_SOUND_LENGTH;
+	size_t size = num_frames * spec->frame_size;
+	void *buf = mem_alloc(size);
+
+	for(uint i = 0; i < num_frames; ++i) {
+		float s = 0.5 * sin(2 * M_PI * freq * i / spec->sample_rate);
+
+		if(spec->sample_format == AUDIO_F32SYS) {
+			((float*)buf)[i * 2 + 0] = s;
+			((float*)buf)[i * 2 + 1] = s;
+		} else {
+			assert(spec->sample_format == AUDIO_S16SYS);
+			((int16_t*)buf)[i * 2 + 0] = s * INT16_MAX;
+			((int16_t*)buf)[i * 2 + 1] = s * INT16_MAX;
+		}
+	}
+
+	*out_size = size;
+	return buf;
+}
+
+int bench_mixer(const char *arg, SDL_RWops *out) {
+	double duration = bench_arg_double(arg, 60, "Duration");
+	AudioStreamSpec dst_spec = astream_spec(AUDIO_F32SYS, 2, BENCH_SAMPLE_RATE);
+	AudioStreamSpec src_specs[] = {
+		dst_spec,
+		astream_spec(AUDIO_S16SYS, 2, 44100),
+	};
+
+	StreamPlayer plr;
+
+	if(!splayer_init(&plr, BENCH_NUM_CHANNELS, &dst_spec)) {
+		log_fatal("splayer_init() failed");
+	}
+
+	plr.gain = 1.0f / BENCH_NUM_CHANNELS;
+
+	StaticPCMAudioStream streams[BENCH_NUM_CHANNELS];
+	void *tones[BENCH_NUM_CHANNELS];
+
+	for(int i = 0; i < BENCH_NUM_CHANNELS; ++i) {
+		const AudioStreamSpec *spec = src_specs + i % ARRAY_SIZE(src_specs);
+		size_t size;
+		tones[i] = make_tone(spec, 220 + 20 * i, &size);
+
+		astream_pcm_static_init(streams + i);
+
+		if(!astream_pcm_reopen(&streams[i].astream, spec, size, tones[i], 0)) {
+			log_fatal("astream_pcm_reopen() failed");
+		}
+
+		splayer_play(&plr, i, &streams[i].astream, true, 1, 0, 0);
+	}
+
+	size_t bufsize = BENCH_BUFFER_FRAMES * dst_spec.frame_size;
+	float *buffer = mem_alloc(bufsize);
+	uint num_buffers = ceil(duration * BENCH_SAMPLE_RATE / BENCH_BUFFER_FRAMES);
+
+	hrtime_t start = time_get();
+
+	for(uint i = 0; i < num_buffers; ++i) {
+		if(i % BENCH_RESTART_INTERVAL == 0) {
+			int chan = (i / BENCH_RESTART_INTERVAL) % BENCH_NUM_CHANNELS;
+			splayer_play(&plr, chan, &streams[chan].astream, true, 1, 0, BENCH_FADE_TIME);
+		}
+
+		memset(buffer, 0, bufsize);
+		splayer_process(&plr, bufsize, buffer);
+	}
+
+	hrtime_t elapsed = time_get() - start;
+	uint64_t num_frames = (uint64_t)num_buffers * BENCH_BUFFER_FRAMES;
+	double elapsed_sec = elapsed / (double)HRTIME_RESOLUTION;
+
+	SDL_RWprintf(out, "{\n");
+	SDL_RWprintf(out, "  \"channels\": %i,\n", BENCH_NUM_CHANNELS);
+	SDL_RWprintf(out, "  \"sample_rate\": %i,\n", BENCH_SAMPLE_RATE);
+	SDL_RWprintf(out, "  \"buffer_frames\": %i,\n", BENCH_BUFFER_FRAMES);
+	SDL_RWprintf(out, "  \"frames\": %"PRIu64",\n", num_frames);
+	SDL_RWprintf(out, "  \"wall_time_sec\": %.6f,\n", elapsed_sec);
+	SDL_RWprintf(out, "  \"ns_per_frame\": %.3f,\n", num_frames ? elapsed_sec * 1e9 / num_frames : 0.0);
+	SDL_RWprintf(out, "  \"realtime_factor\": %.2f\n", elapsed_sec > 0 ? num_frames / (elapsed_sec * BENCH_SAMPLE_RATE) : 0.0);
+	SDL_RWprintf(out, "}\n");
+
+	splayer_shutdown(&plr);
+	mem_free(buffer);
+
+	for(int i = 0; i < BENCH_NUM_CHANNELS; ++i) {
+		astream_close(&streams[i].astream);
+		mem_free(tones[i]);
+	}
+
+	return 0;
+}
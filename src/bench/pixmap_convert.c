@@ -0,0 +1,122 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2026, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2026, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#include "taisei.h"
+
+#include "bench.h"
+#include "pixmap/conversion_internal.h"
+#include "log.h"
+#include "util.h"
+
+/*
+ * Runs every specialized conversion and its generic equivalent over the same random image, and
+ * checks that both produce identical output.
+ */
+
+#define BENCH_WIDTH 1024
+#define BENCH_HEIGHT 1024
+#define BENCH_PASSES 16
+
+static const PixmapFormat bench_formats[] = {
+	PIXMAP_FORMAT_R8,    PIXMAP_FORMAT_R16,    PIXMAP_FORMAT_R16F,    PIXMAP_FORMAT_R32F,
+	PIXMAP_FORMAT_RG8,   PIXMAP_FORMAT_RG16,   PIXMAP_FORMAT_RG16F,   PIXMAP_FORMAT_RG32F,
+	PIXMAP_FORMAT_RGB8,  PIXMAP_FORMAT_RGB16,  PIXMAP_FORMAT_RGB16F,  PIXMAP_FORMAT_RGB32F,
+	PIXMAP_FORMAT_RGBA8, PIXMAP_FORMAT_RGBA16, PIXMAP_FORMAT_RGBA16F, PIXMAP_FORMAT_RGBA32F,
+};
+
+static double bench_mpix_per_sec(hrtime_t t) {
+	return BENCH_PASSES * (double)(BENCH_WIDTH * BENCH_HEIGHT) * HRTIME_RESOLUTION / (umax(t, 1) * 1e6);
+}
+
+static hrtime_t bench_convert(
+	void (*convert)(const Pixmap *src, Pixmap *dst, PixmapFormat format),
+	const Pixmap *src, Pixmap *dst, PixmapFormat format
+) {
+	hrtime_t start = time_get();
+
+	for(uint i = 0; i < BENCH_PASSES; ++i) {
+		convert(src, dst, format);
+	}
+
+	return time_get() - start;
+}
+
+int bench_pixmap_convert(const char *arg, SDL_RWops *out) {
+	size_t num_pixels = BENCH_WIDTH * BENCH_HEIGHT;
+	size_t max_size = num_pixels * PIXMAP_FORMAT_PIXEL_SIZE(PIXMAP_FORMAT_RGBA32F);
+	uint8_t *in = mem_alloc(max_size);
+	uint32_t rng = 0x9e3779b9;
+
+	for(size_t i = 0; i < max_size; ++i) {
+		rng ^= rng << 13;
+		rng ^= rng >> 17;
+		rng ^= rng << 5;
+		in[i] = rng;
+	}
+
+	Pixmap src = {
+		.data.untyped = in,
+		.width = BENCH_WIDTH,
+		.height = BENCH_HEIGHT,
+	};
+
+	Pixmap out_fast = { .data.untyped = mem_alloc(max_size) };
+	Pixmap out_generic = { .data.untyped = mem_alloc(max_size) };
+	bool first = true;
+	int status = 0;
+
+	SDL_RWprintf(out, "{\n");
+	SDL_RWprintf(out, "  \"pixels\": %zu,\n", num_pixels);
+	SDL_RWprintf(out, "  \"passes\": %u,\n", BENCH_PASSES);
+	SDL_RWprintf(out, "  \"conversions\": [");
+
+	for(uint i = 0; i < ARRAY_SIZE(bench_formats); ++i) {
+		for(uint j = 0; j < ARRAY_SIZE(bench_formats); ++j) {
+			PixmapFormat format_in = bench_formats[i];
+			PixmapFormat format_out = bench_formats[j];
+
+			if(!pixmap_convert_is_specialized(format_in, format_out)) {
+				continue;
+			}
+
+			src.format = format_in;
+			src.data_size = num_pixels * PIXMAP_FORMAT_PIXEL_SIZE(format_in);
+
+			hrtime_t t_generic = bench_convert(pixmap_convert_generic, &src, &out_generic, format_out);
+			hrtime_t t_fast = bench_convert(pixmap_convert, &src, &out_fast, format_out);
+
+			size_t out_size = num_pixels * PIXMAP_FORMAT_PIXEL_SIZE(format_out);
+			bool identical = !memcmp(out_fast.data.untyped, out_generic.data.untyped, out_size);
+
+			if(!identical) {
+				log_error("%s -> %s: fast path output differs from the generic conversion",
+					pixmap_format_name(format_in), pixmap_format_name(format_out));
+				status = 1;
+			}
+
+			SDL_RWprintf(out,
+				"%s\n    { \"from\": \"%s\", \"to\": \"%s\", \"generic_mpix_per_sec\": %.1f, \"fast_mpix_per_sec\": %.1f, \"identical\": %s }",
+				first ? "" : ",",
+				pixmap_format_name(format_in),
+				pixmap_format_name(format_out),
+				bench_mpix_per_sec(t_generic),
+				bench_mpix_per_sec(t_fast),
+				identical ? "true" : "false"
+			);
+
+			first = false;
+		}
+	}
+
+	SDL_RWprintf(out, "\n  ]\n}\n");
+
+	mem_free(in);
+	mem_free(out_fast.data.untyped);
+	mem_free(out_generic.data.untyped);
+	return status;
+}
@@ -0,0 +1,127 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2026, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2026, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#include "taisei.h"
+
+#include "bench.h"
+#include "util/rectpack.h"
+#include "util.h"
+
+/*
+ * Packs glyph-sized rects into a font-atlas-sized sheet, one at a time and in a batch,
+ * then reclaims them all.
+ */
+
+#define BENCH_SHEET_SIZE 2048
+
+typedef struct RectPackBenchResult {
+	hrtime_t add_time;
+	hrtime_t reclaim_time;
+	uint num_added;
+	double occupancy;
+	bool empty_after_reclaim;
+} RectPackBenchResult;
+
+static void rectpack_bench_run(
+	RectPack *rp, uint num_requests, RectPackRequest requests[num_requests], bool batch,
+	RectPackBenchResult *result
+) {
+	rectpack_reset(rp);
+
+	for(uint i = 0; i < num_requests; ++i) {
+		requests[i].section = NULL;
+	}
+
+	hrtime_t start = time_get();
+
+	if(batch) {
+		result->num_added = rectpack_add_batch(rp, num_requests, requests);
+	} else {
+		result->num_added = 0;
+
+		for(uint i = 0; i < num_requests; ++i) {
+			if((requests[i].section = rectpack_add(rp, requests[i].width, requests[i].height))) {
+				++result->num_added;
+			}
+		}
+	}
+
+	result->add_time = time_get() - start;
+
+	double area = 0;
+
+	for(uint i = 0; i < num_requests; ++i) {
+		if(requests[i].section) {
+			Rect r = rectpack_section_rect(requests[i].section);
+			area += rect_area(r);
+		}
+	}
+
+	result->occupancy = area / (BENCH_SHEET_SIZE * BENCH_SHEET_SIZE);
+	start = time_get();
+
+	for(uint i = 0; i < num_requests; ++i) {
+		if(requests[i].section) {
+			rectpack_reclaim(rp, requests[i].section);
+		}
+	}
+
+	result->reclaim_time = time_get() - start;
+	result->empty_after_reclaim = rectpack_is_empty(rp);
+
+	if(!result->empty_after_reclaim) {
+		log_error("RectPack is not empty after reclaiming every section");
+	}
+}
+
+static void rectpack_bench_print(SDL_RWops *out, const char *name, RectPackBenchResult *r, bool last) {
+	SDL_RWprintf(out,
+		"  \"%s\": { \"added\": %u, \"add_usec\": %.1f, \"reclaim_usec\": %.1f, \"occupancy\": %.4f, \"empty_after_reclaim\": %s }%s\n",
+		name,
+		r->num_added,
+		bench_usec(r->add_time),
+		bench_usec(r->reclaim_time),
+		r->occupancy,
+		r->empty_after_reclaim ? "true" : "false",
+		last ? "" : ","
+	);
+}
+
+int bench_rectpack(const char *arg, SDL_RWops *out) {
+	uint num_rects = bench_arg_uint(arg, 2000, "Rect count");
+	auto requests = ALLOC_ARRAY(num_rects, RectPackRequest);
+	uint32_t rng = 0x9e3779b9;
+
+	for(uint i = 0; i < num_rects; ++i) {
+		rng ^= rng << 13;
+		rng ^= rng >> 17;
+		rng ^= rng << 5;
+
+		// Roughly the spread of glyph bitmap sizes across the game's fonts
+		requests[i] = (RectPackRequest) {
+			.width = 4 + (rng & 0xff) % 45,
+			.height = 8 + (rng >> 8 & 0xff) % 41,
+		};
+	}
+
+	RectPack *rp = rectpack_new(BENCH_SHEET_SIZE, BENCH_SHEET_SIZE);
+	RectPackBenchResult single, batch;
+	rectpack_bench_run(rp, num_rects, requests, false, &single);
+	rectpack_bench_run(rp, num_rects, requests, true, &batch);
+	rectpack_free(rp);
+
+	SDL_RWprintf(out, "{\n");
+	SDL_RWprintf(out, "  \"rects\": %u,\n", num_rects);
+	SDL_RWprintf(out, "  \"sheet_size\": %u,\n", BENCH_SHEET_SIZE);
+	rectpack_bench_print(out, "single", &single, false);
+	rectpack_bench_print(out, "batch", &batch, true);
+	SDL_RWprintf(out, "}\n");
+
+	mem_free(requests);
+	return single.empty_after_reclaim && batch.empty_after_reclaim ? 0 : 1;
+}
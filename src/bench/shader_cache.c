@@ -0,0 +1,244 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2026, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2026, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#include "taisei.h"
+
+#include "bench.h"
+#include "renderer/common/shaderlib/cache_private.h"
+#include "renderer/common/shaderlib/shaderlib.h"
+#include "vfs/setup.h"
+#include "util.h"
+
+#if defined(TAISEI_BUILDCONF_HAVE_POSIX) && !defined(__EMSCRIPTEN__)
+	#include <fcntl.h>
+	#include <unistd.h>
+
+	#ifdef POSIX_FADV_DONTNEED
+		#define BENCH_EVICT_PAGE_CACHE
+	#endif
+#endif
+
+#define BENCH_DIR "cache/shaders-bench"
+#define BENCH_WARM_PASSES 5
+
+/*
+ * Every entry of the pack is exported into BENCH_DIR in the directory layout, then both copies
+ * are looked up entry by entry. The first pass over the pack includes opening and indexing it,
+ * like the first shader load of a game session would.
+ *
+ * Before the first passes, both copies are flushed and evicted from the OS page cache where the
+ * platform supports it. The report says whether that happened; if not, the "first pass" numbers
+ * are for a warm page cache. The exported directory is deleted afterwards.
+ */
+
+typedef DYNAMIC_ARRAY(char*) BenchNames;
+typedef bool (*BenchLookupFunc)(const char *name, bool decode);
+
+typedef struct BenchTimes {
+	hrtime_t open;
+	hrtime_t first_pass;
+	hrtime_t warm_pass;
+	hrtime_t warm_lookup;  // without decoding the entries
+} BenchTimes;
+
+static void bench_export_entry(const char *name, ShaderCacheBlob blob, void *arg) {
+	BenchNames *names = arg;
+
+	if(shader_cache_dir_write(BENCH_DIR, name, blob)) {
+		*dynarray_append(names) = strdup(name);
+	}
+}
+
+static bool bench_decode(ShaderCacheBlob blob) {
+	ShaderSource src;
+
+	if(!shader_cache_decode_blob(blob, &src)) {
+		return false;
+	}
+
+	shader_free_source(&src);
+	return true;
+}
+
+static bool bench_lookup_dir(const char *name, bool decode) {
+	ShaderCacheBlob blob;
+
+	if(!shader_cache_dir_read(BENCH_DIR, name, &blob)) {
+		return false;
+	}
+
+	bool ok = !decode || bench_decode(blob);
+	mem_free((void*)blob.data);
+	return ok;
+}
+
+static bool bench_lookup_pack(const char *name, bool decode) {
+	ShaderCacheBlob blob;
+
+	if(!shader_cache_pack_find(name, &blob)) {
+		return false;
+	}
+
+	return !decode || bench_decode(blob);
+}
+
+static hrtime_t bench_pass(BenchNames *names, BenchLookupFunc lookup, bool decode, uint *num_failures) {
+	hrtime_t start = time_get();
+
+	dynarray_foreach_elem(names, char **name, {
+		if(!lookup(*name, decode)) {
+			++*num_failures;
+		}
+	});
+
+	return time_get() - start;
+}
+
+#ifdef BENCH_EVICT_PAGE_CACHE
+
+static bool bench_evict_syspath(const char *path) {
+	int fd = open(path, O_RDONLY);
+
+	if(fd < 0) {
+		return false;
+	}
+
+	// Dirty pages can't be dropped, so write them out first.
+	bool ok = fdatasync(fd) == 0 && posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+	close(fd);
+	return ok;
+}
+
+static bool bench_evict(BenchNames *names) {
+	const char *pack_path = shader_cache_pack_path();
+	char *root = vfs_syspath(BENCH_DIR);
+	bool ok = pack_path && root && bench_evict_syspath(pack_path);
+
+	if(root) {
+		dynarray_foreach_elem(names, char **name, {
+			if(!ok) {
+				break;
+			}
+
+			char *path = vfs_syspath_join_alloc(root, *name);
+			ok = bench_evict_syspath(path);
+			mem_free(path);
+		});
+	}
+
+	mem_free(root);
+	return ok;
+}
+
+#else
+
+static bool bench_evict(BenchNames *names) {
+	return false;
+}
+
+#endif
+
+static void bench_write_times(SDL_RWops *out, const char *layout, const BenchTimes *t, bool last) {
+	SDL_RWprintf(out,
+		"  \"%s_usec\": { \"open\": %.1f, \"first_pass\": %.1f, \"warm_pass\": %.1f, \"warm_lookup_only\": %.1f }%s\n",
+		layout,
+		bench_usec(t->open),
+		bench_usec(t->first_pass),
+		bench_usec(t->warm_pass),
+		bench_usec(t->warm_lookup),
+		last ? "" : ","
+	);
+}
+
+static int bench_shader_cache_run(SDL_RWops *out) {
+	BenchNames names = { };
+	shader_cache_pack_foreach(bench_export_entry, &names);
+
+	if(!names.num_elements) {
+		log_error("The shader cache pack is empty or unavailable; run the game once to populate it");
+		SDL_RWprintf(out, "{\n  \"entries\": 0\n}\n");
+		dynarray_free_data(&names);
+		return 1;
+	}
+
+	log_info("Benchmarking %u shader cache entries", names.num_elements);
+
+	BenchTimes dir = { }, pack = { };
+	uint num_failures = 0;
+
+	shader_cache_pack_close();
+	bool evicted = bench_evict(&names);
+
+	if(!evicted) {
+		log_warn("Couldn't evict the cache files from the page cache; first pass timings will be warm");
+	}
+
+	dir.first_pass = bench_pass(&names, bench_lookup_dir, true, &num_failures);
+
+	shader_cache_pack_close();
+	hrtime_t start = time_get();
+	shader_cache_pack_open();
+	pack.open = time_get() - start;
+	pack.first_pass = pack.open + bench_pass(&names, bench_lookup_pack, true, &num_failures);
+
+	for(uint i = 0; i < BENCH_WARM_PASSES; ++i) {
+		dir.warm_pass += bench_pass(&names, bench_lookup_dir, true, &num_failures);
+		pack.warm_pass += bench_pass(&names, bench_lookup_pack, true, &num_failures);
+		dir.warm_lookup += bench_pass(&names, bench_lookup_dir, false, &num_failures);
+		pack.warm_lookup += bench_pass(&names, bench_lookup_pack, false, &num_failures);
+	}
+
+	dir.warm_pass /= BENCH_WARM_PASSES;
+	pack.warm_pass /= BENCH_WARM_PASSES;
+	dir.warm_lookup /= BENCH_WARM_PASSES;
+	pack.warm_lookup /= BENCH_WARM_PASSES;
+
+	if(num_failures) {
+		log_warn("%u lookups failed", num_failures);
+	}
+
+	SDL_RWprintf(out, "{\n");
+	SDL_RWprintf(out, "  \"entries\": %u,\n", names.num_elements);
+	SDL_RWprintf(out, "  \"pack_bytes\": %zu,\n", shader_cache_pack_size());
+	SDL_RWprintf(out, "  \"failed_lookups\": %u,\n", num_failures);
+	SDL_RWprintf(out, "  \"page_cache_evicted\": %s,\n", evicted ? "true" : "false");
+	bench_write_times(out, "directory", &dir, false);
+	bench_write_times(out, "pack", &pack, true);
+	SDL_RWprintf(out, "}\n");
+
+	dynarray_foreach_elem(&names, char **name, {
+		mem_free(*name);
+	});
+
+	dynarray_free_data(&names);
+	shader_cache_dir_remove(BENCH_DIR);
+	return num_failures ? 1 : 0;
+}
+
+typedef struct ShaderCacheBenchContext {
+	SDL_RWops *out;
+	int status;
+} ShaderCacheBenchContext;
+
+static void bench_shader_cache_post_vfsinit(CallChainResult ccr) {
+	ShaderCacheBenchContext *ctx = ccr.ctx;
+
+	shader_cache_init();
+	ctx->status = bench_shader_cache_run(ctx->out);
+	shader_cache_shutdown();
+}
+
+int bench_shader_cache(const char *arg, SDL_RWops *out) {
+	ShaderCacheBenchContext ctx = { .out = out };
+
+	// Synchronous on every platform taisei-bench is built for.
+	vfs_setup(CALLCHAIN(bench_shader_cache_post_vfsinit, &ctx));
+	vfs_shutdown();
+
+	return ctx.status;
+}
@@ -0,0 +1,87 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2026, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2026, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#include "taisei.h"
+
+#include "bench.h"
+#include "taskmanager.h"
+#include "log.h"
+#include "util.h"
+
+/*
+ * Measures how many trivial tasks per second can be submitted and completed, with the task pool
+ * empty and then warmed up. "batch" submits every task before waiting for any of them;
+ * "roundtrip" waits for each task before submitting the next one.
+ */
+
+static void *bench_task(void *arg) {
+	return arg;
+}
+
+static double bench_tasks_per_sec(uint num_tasks, hrtime_t t) {
+	return num_tasks * (double)HRTIME_RESOLUTION / (double)umax(t, 1);
+}
+
+static hrtime_t bench_batch(TaskManager *mgr, Task **tasks, uint num_tasks) {
+	hrtime_t start = time_get();
+
+	for(uint i = 0; i < num_tasks; ++i) {
+		tasks[i] = taskmgr_submit(mgr, (TaskParams) { .callback = bench_task });
+	}
+
+	for(uint i = 0; i < num_tasks; ++i) {
+		task_finish(tasks[i], NULL);
+	}
+
+	return time_get() - start;
+}
+
+static hrtime_t bench_roundtrip(TaskManager *mgr, uint num_tasks) {
+	hrtime_t start = time_get();
+
+	for(uint i = 0; i < num_tasks; ++i) {
+		task_finish(taskmgr_submit(mgr, (TaskParams) { .callback = bench_task }), NULL);
+	}
+
+	return time_get() - start;
+}
+
+int bench_taskmgr(const char *arg, SDL_RWops *out) {
+	uint num_tasks = bench_arg_uint(arg, 100000, "Task count");
+	TaskManager *mgr = taskmgr_create(0, SDL_THREAD_PRIORITY_NORMAL, "bench");
+
+	if(!mgr) {
+		log_error("Failed to create a task manager");
+		return 1;
+	}
+
+	Task **tasks = ALLOC_ARRAY(num_tasks, Task*);
+
+	// There's no global task manager here, so this just empties the task pool.
+	taskmgr_global_shutdown();
+	hrtime_t batch_cold = bench_batch(mgr, tasks, num_tasks);
+	hrtime_t batch_warm = bench_batch(mgr, tasks, num_tasks);
+
+	taskmgr_global_shutdown();
+	hrtime_t roundtrip_cold = bench_roundtrip(mgr, num_tasks);
+	hrtime_t roundtrip_warm = bench_roundtrip(mgr, num_tasks);
+
+	SDL_RWprintf(out, "{\n");
+	SDL_RWprintf(out, "  \"tasks\": %u,\n", num_tasks);
+	SDL_RWprintf(out, "  \"threads\": %i,\n", SDL_GetCPUCount());
+	SDL_RWprintf(out, "  \"batch_tasks_per_sec\": { \"cold\": %.0f, \"warm\": %.0f },\n",
+		bench_tasks_per_sec(num_tasks, batch_cold), bench_tasks_per_sec(num_tasks, batch_warm));
+	SDL_RWprintf(out, "  \"roundtrip_tasks_per_sec\": { \"cold\": %.0f, \"warm\": %.0f }\n",
+		bench_tasks_per_sec(num_tasks, roundtrip_cold), bench_tasks_per_sec(num_tasks, roundtrip_warm));
+	SDL_RWprintf(out, "}\n");
+
+	mem_free(tasks);
+	taskmgr_finish(mgr);
+	taskmgr_global_shutdown();
+	return 0;
+}
@@ -19,6 +19,7 @@
 #include "stages/stage5/stage5.h"  // for unlockable bonus BGM
 #include "stageobjects.h"
 #include "dynstage.h"
+#include "profiler.h"
 
 static void ent_draw_boss(EntityInterface *ent);
 static DamageResult ent_damage_boss(EntityInterface *ent, const DamageInfo *dmg);
@@ -907,9 +908,9 @@ static DamageResult ent_damage_boss(EntityInterface *ent, const DamageInfo *dmg)
 	boss->current->hp -= dmg->amount * factor;
 
 	if(boss->current->hp < boss->current->maxhp * 0.1) {
-		play_sfx_loop("hit1");
+		play_sfx_loop_handle(SFX_HANDLE("hit1"));
 	} else {
-		play_sfx_loop("hit0");
+		play_sfx_loop_handle(SFX_HANDLE("hit0"));
 	}
 
 	return DMG_RESULT_OK;
@@ -1056,6 +1057,8 @@ void boss_finish_current_attack(Boss *boss) {
 static void boss_schedule_next_attack(Boss *b, Attack *a);
 
 void process_boss(Boss **pboss) {
+	PROF_ZONE("process_boss");
+
 	Boss *boss = *pboss;
 
 	if(!boss) {
@@ -1092,7 +1095,7 @@ void process_boss(Boss **pboss) {
 		int remaining = boss->current->timeout - time;
 
 		if(boss->current->type != AT_Move && remaining <= 11*FPS && remaining > 0 && !(time % FPS)) {
-			play_sfx(remaining <= 6*FPS ? "timeout2" : "timeout1");
+			(play_sfx)(remaining <= 6*FPS ? "timeout2" : "timeout1");
 		}
 
 		boss_call_rule(boss, time);
@@ -1402,7 +1405,7 @@ void boss_start_next_attack(Boss *b, Attack *a) {
 	boss_call_rule(b, EVENT_BIRTH);
 
 	if(ATTACK_IS_SPELL(a->type)) {
-		play_sfx(a->type == AT_ExtraSpell ? "charge_extra" : "charge_generic");
+		(play_sfx)(a->type == AT_ExtraSpell ? "charge_extra" : "charge_generic");
 
 		for(int i = 0; i < 10+5*(a->type == AT_ExtraSpell); i++) {
 			RNG_ARRAY(rng, 4);
@@ -28,6 +28,8 @@ enum {
 	OPT_CUTSCENE_LIST,
 	OPT_FORCE_INTRO,
 	OPT_REREPLAY,
+	OPT_BENCH_REPLAY,
+	OPT_BENCH_OUTPUT,
 };
 
 static void print_help(struct TsOption* opts) {
@@ -77,6 +79,10 @@ int cli_args(int argc, char **argv, CLIAction *a) {
 		{{"replay",             required_argument,  0, 'r'},            "Play a replay from %s", "FILE"},
 		{{"verify-replay",      required_argument,  0, 'R'},            "Play a replay from %s in headless mode, crash as soon as it desyncs unless --rereplay is used", "FILE"},
 		{{"rereplay",           required_argument,  0, OPT_REREPLAY},   "Re-record replay into %s; specify input with -r or -R", "OUTFILE"},
+#ifdef TAISEI_BUILDCONF_PROFILER
+		{{"bench-replay",       required_argument,  0, OPT_BENCH_REPLAY}, "Play a replay from %s in headless mode as fast as possible, then print a CPU timing report as JSON", "FILE"},
+		{{"bench-output",       required_argument,  0, OPT_BENCH_OUTPUT}, "Write the --bench-replay report into %s instead of stdout", "OUTFILE"},
+#endif
 #ifdef DEBUG
 		{{"play",               no_argument,        0, 'p'},            "Play a specific stage"},
 		{{"sid",                required_argument,  0, 'i'},            "Select stage by %s", "ID"},
@@ -154,6 +160,13 @@ int cli_args(int argc, char **argv, CLIAction *a) {
 			a->type = CLI_VerifyReplay;
 			stralloc(&a->filename, optarg);
 			break;
+		case OPT_BENCH_REPLAY:
+			a->type = CLI_BenchReplay;
+			stralloc(&a->filename, optarg);
+			break;
+		case OPT_BENCH_OUTPUT:
+			stralloc(&a->bench_output, optarg);
+			break;
 		case OPT_REREPLAY:
 			stralloc(&a->out_replay, optarg);
 			env_set("TAISEI_REPLAY_DESYNC_CHECK_FREQUENCY", 1, false);
@@ -255,6 +268,7 @@ int cli_args(int argc, char **argv, CLIAction *a) {
 		switch(a->type) {
 			case CLI_PlayReplay:
 			case CLI_VerifyReplay:
+			case CLI_BenchReplay:
 			case CLI_SelectStage:
 				if(stageinfo_get_by_id(stageid) == NULL) {
 					log_fatal("Invalid stage id: %X", stageid);
@@ -285,6 +299,10 @@ int cli_args(int argc, char **argv, CLIAction *a) {
 		log_fatal("--rereplay requires --replay or --verify-replay");
 	}
 
+	if(a->bench_output && a->type != CLI_BenchReplay) {
+		log_fatal("--bench-output requires --bench-replay");
+	}
+
 	return 0;
 }
 
@@ -293,4 +311,6 @@ void free_cli_action(CLIAction *a) {
 	a->filename = NULL;
 	mem_free(a->out_replay);
 	a->out_replay = NULL;
+	mem_free(a->bench_output);
+	a->bench_output = NULL;
 }
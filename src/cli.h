@@ -15,6 +15,7 @@ typedef enum {
 	CLI_RunNormally = 0,
 	CLI_PlayReplay,
 	CLI_VerifyReplay,
+	CLI_BenchReplay,
 	CLI_SelectStage,
 	CLI_DumpStages,
 	CLI_DumpVFSTree,
@@ -33,6 +34,7 @@ struct CLIAction {
 	CutsceneID cutscene;
 	char *filename;
 	char *out_replay;
+	char *bench_output;
 	PlayerMode *plrmode;
 };
 
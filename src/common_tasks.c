@@ -127,7 +127,7 @@ static int common_charge_impl(
 	int delay = 3;
 	real rayfactor = 1.0 / time;
 	float hue_rand = 0.02;
-	SFXPlayID charge_snd_id = snd_charge ? play_sfx(snd_charge) : 0;
+	SFXPlayID charge_snd_id = snd_charge ? (play_sfx)(snd_charge) : 0;
 	DECLARE_ENT_ARRAY(Projectile, particles, 256);
 
 	BoxedTask snd_stopper_task = { 0 };
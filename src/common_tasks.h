@@ -21,13 +21,13 @@ DECLARE_EXTERN_TASK(
 	{ cmplx *pos; ItemCounts items; }
 );
 
-DECLARE_EXTERN_TASK(
-	common_move,
+DECLARE_EXTERN_TASK_WITH_STACK(
+	common_move, COTASK_STACK_SMALL,
 	{ cmplx *pos; MoveParams move_params; BoxedEntity ent; }
 );
 
-DECLARE_EXTERN_TASK(
-	common_move_ext,
+DECLARE_EXTERN_TASK_WITH_STACK(
+	common_move_ext, COTASK_STACK_SMALL,
 	{ cmplx *pos; MoveParams *move_params; BoxedEntity ent; }
 );
 
@@ -92,8 +92,8 @@ INLINE Rect viewport_bounds(double margin) {
 cmplx common_wander(cmplx origin, double dist, Rect bounds);
 void common_rotate_velocity(MoveParams *move, real angle, int duration);
 
-DECLARE_EXTERN_TASK(
-	common_set_bitflags,
+DECLARE_EXTERN_TASK_WITH_STACK(
+	common_set_bitflags, COTASK_STACK_SMALL,
 	{
 		uint *pflags;
 		uint mask;
@@ -115,8 +115,8 @@ DECLARE_EXTERN_TASK(
 	}
 );
 
-DECLARE_EXTERN_TASK(
-	common_easing_animate,
+DECLARE_EXTERN_TASK_WITH_STACK(
+	common_easing_animate, COTASK_STACK_SMALL,
 	{
 		float *value;
 		float to;
@@ -125,8 +125,8 @@ DECLARE_EXTERN_TASK(
 	}
 );
 
-DECLARE_EXTERN_TASK(
-	common_easing_animate_vec3,
+DECLARE_EXTERN_TASK_WITH_STACK(
+	common_easing_animate_vec3, COTASK_STACK_SMALL,
 	{
 		vec3 *value;
 		vec3 to;
@@ -135,8 +135,8 @@ DECLARE_EXTERN_TASK(
 	}
 );
 
-DECLARE_EXTERN_TASK(
-	common_easing_animate_vec4,
+DECLARE_EXTERN_TASK_WITH_STACK(
+	common_easing_animate_vec4, COTASK_STACK_SMALL,
 	{
 		vec4 *value;
 		vec4 to;
@@ -145,8 +145,8 @@ DECLARE_EXTERN_TASK(
 	}
 );
 
-DECLARE_EXTERN_TASK(
-	common_rotate_velocity,
+DECLARE_EXTERN_TASK_WITH_STACK(
+	common_rotate_velocity, COTASK_STACK_SMALL,
 	{
 		MoveParams *move;
 		real angle;
@@ -59,10 +59,19 @@ void coroutines_draw_stats(void) {
 
 	text_draw(buf, &tp);
 
+	tp.pos.y += ls;
+	snprintf(buf, sizeof(buf), "Stacks: %zukb ", STAT_VAL(stack_bytes_allocated) / 1024);
+	text_draw(buf, &tp);
+
 	tp.pos.y += ls;
 	snprintf(buf, sizeof(buf), "Switches/frame: %4zu ", STAT_VAL(num_switches_this_frame));
 	text_draw(buf, &tp);
 
+	tp.pos.y += ls;
+	snprintf(buf, sizeof(buf), "Waiting/frame: %4zu ", STAT_VAL(num_polls_this_frame));
+	text_draw(buf, &tp);
+
 	STAT_VAL_SET(num_switches_this_frame, 0);
+	STAT_VAL_SET(num_polls_this_frame, 0);
 #endif
 }
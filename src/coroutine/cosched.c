@@ -9,14 +9,15 @@
 #include "taisei.h"
 
 #include "internal.h"
+#include "profiler.h"
 
 void cosched_init(CoSched *sched) {
 	memset(sched, 0, sizeof(*sched));
 }
 
-CoTask *_cosched_new_task(CoSched *sched, CoTaskFunc func, void *arg, size_t arg_size, bool is_subtask, CoTaskDebugInfo debug) {
+CoTask *_cosched_new_task(CoSched *sched, CoTaskFunc func, void *arg, size_t arg_size, bool is_subtask, CoTaskStackClass stack_class, CoTaskDebugInfo debug) {
 	assume(sched != NULL);
-	CoTask *task = cotask_new_internal(cotask_entry);
+	CoTask *task = cotask_new_internal(cotask_entry, stack_class);
 
 #ifdef CO_TASK_DEBUG
 	snprintf(task->debug_label, sizeof(task->debug_label), "#%i <%p> %s (%s:%i:%s)", task->unique_id, (void*)task, debug.label, debug.debug_info.file, debug.debug_info.line, debug.debug_info.func);
@@ -43,6 +44,8 @@ CoTask *_cosched_new_task(CoSched *sched, CoTaskFunc func, void *arg, size_t arg
 }
 
 uint cosched_run_tasks(CoSched *sched) {
+	PROF_ZONE("cosched_run_tasks");
+
 	alist_merge_tail(&sched->tasks, &sched->pending_tasks);
 
 	uint ran = 0;
@@ -77,15 +80,13 @@ static uint gather_blocking_events(CoTaskList *tasks, events_hashset *events) {
 			continue;
 		}
 
-		CoTaskData *tdata = t->data;
-
-		if(tdata->wait.wait_type != COTASK_WAIT_EVENT) {
+		if(t->wait.wait_type != COTASK_WAIT_EVENT) {
 			continue;
 		}
 
-		CoEvent *e = tdata->wait.event.pevent;
+		CoEvent *e = t->wait.event.pevent;
 
-		if(e->unique_id != tdata->wait.event.snapshot.unique_id) {
+		if(e->unique_id != t->wait.event.snapshot.unique_id) {
 			// event not valid? (probably should not happen)
 			continue;
 		}
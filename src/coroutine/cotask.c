@@ -10,8 +10,20 @@
 
 #include "internal.h"
 
-static CoTaskList task_pool;
+#ifdef CO_STACK_GUARD_PAGE
+#include <errno.h>
+#include <sys/mman.h>
+#endif
+
+// Finished tasks are kept here along with their stacks, to be recycled later.
+static CoTaskList task_pool[COTASK_STACK_NUM_CLASSES];
+
+static const size_t stack_class_sizes[COTASK_STACK_NUM_CLASSES] = {
+	[COTASK_STACK_DEFAULT] = CO_STACK_SIZE,
+	[COTASK_STACK_SMALL] = CO_STACK_SIZE_SMALL,
+};
 static koishi_coroutine_t *co_main;
+static uint64_t resume_counter;
 
 #ifdef CO_TASK_DEBUG
 size_t _cotask_debug_event_id;
@@ -151,14 +163,58 @@ static void estimate_stack_usage(CoTask *task) { }
 #endif // CO_TASK_STATS_STACK
 
 
+#ifdef CO_STACK_GUARD_PAGE
+
+static void *get_guard_page(CoTask *task, size_t *page_size) {
+	*page_size = koishi_util_page_size();
+	size_t stack_size;
+	char *stack = koishi_get_stack(&task->ko, &stack_size);
+
+	if(!stack || (uintptr_t)stack % *page_size || stack_size < 2 * *page_size) {
+		return NULL;
+	}
+
+	return stack;
+}
+
+static void setup_guard_page(CoTask *task) {
+	size_t page_size;
+	void *page = get_guard_page(task, &page_size);
+
+	if(page && mprotect(page, page_size, PROT_NONE) != 0) {
+		log_warn("mprotect() failed: %s", strerror(errno));
+	}
+}
+
+// Koishi may allocate stacks with aligned_alloc or posix_memalign instead of mmap. The page must
+// be made accessible again before such a stack is handed back to malloc.
+static void release_guard_page(CoTask *task) {
+	size_t page_size;
+	void *page = get_guard_page(task, &page_size);
+
+	if(page && mprotect(page, page_size, PROT_READ | PROT_WRITE) != 0) {
+		log_warn("mprotect() failed: %s", strerror(errno));
+	}
+}
+
+#else // CO_STACK_GUARD_PAGE
+
+static void setup_guard_page(CoTask *task) { }
+static void release_guard_page(CoTask *task) { }
+
+#endif // CO_STACK_GUARD_PAGE
+
 void cotask_global_init(void) {
 	co_main = koishi_active();
 }
 
 void cotask_global_shutdown(void) {
-	for(CoTask *task; (task = alist_pop(&task_pool));) {
-		koishi_deinit(&task->ko);
-		mem_free(task);
+	for(uint i = 0; i < ARRAY_SIZE(task_pool); ++i) {
+		for(CoTask *task; (task = alist_pop(task_pool + i));) {
+			release_guard_page(task);
+			koishi_deinit(&task->ko);
+			mem_free(task);
+		}
 	}
 }
 
@@ -194,11 +250,13 @@ CoTask *cotask_unbox_notnull(BoxedTask box) {
 	return NULL;
 }
 
-CoTask *cotask_new_internal(koishi_entrypoint_t entry_point) {
+CoTask *cotask_new_internal(koishi_entrypoint_t entry_point, CoTaskStackClass stack_class) {
+	assert((uint)stack_class < ARRAY_SIZE(task_pool));
+
 	CoTask *task;
 	STAT_VAL_ADD(num_tasks_in_use, 1);
 
-	if((task = alist_pop(&task_pool))) {
+	if((task = alist_pop(task_pool + stack_class))) {
 		koishi_recycle(&task->ko, entry_point);
 		TASK_DEBUG(
 			"Recycled task %p, entry=%p (%zu tasks allocated / %zu in use)",
@@ -207,8 +265,11 @@ CoTask *cotask_new_internal(koishi_entrypoint_t entry_point) {
 		);
 	} else {
 		task = ALLOC(typeof(*task));
-		koishi_init(&task->ko, CO_STACK_SIZE, entry_point);
+		task->stack_class = stack_class;
+		koishi_init(&task->ko, stack_class_sizes[stack_class], entry_point);
+		setup_guard_page(task);
 		STAT_VAL_ADD(num_tasks_allocated, 1);
+		STAT_VAL_ADD(stack_bytes_allocated, stack_class_sizes[stack_class]);
 		TASK_DEBUG(
 			"Created new task %p, entry=%p (%zu tasks allocated / %zu in use)",
 			(void*)task, *(void**)&entry_point,
@@ -222,6 +283,8 @@ CoTask *cotask_new_internal(koishi_entrypoint_t entry_point) {
 	assert(unique_counter != 0);
 
 	task->data = NULL;
+	task->bound_ent = (BoxedEntity) { };
+	memset(&task->wait, 0, sizeof(task->wait));
 
 #ifdef CO_TASK_DEBUG
 	snprintf(task->debug_label, sizeof(task->debug_label), "<unknown at %p; entry=%p>", (void*)task, *(void**)&entry_point);
@@ -234,18 +297,23 @@ void *cotask_resume_internal(CoTask *task, void *arg) {
 	TASK_DEBUG_EVENT(ev);
 	TASK_DEBUG("[%zu] Resuming task %s", ev, task->debug_label);
 	STAT_VAL_ADD(num_switches_this_frame, 1);
+	++resume_counter;
 	arg = koishi_resume(&task->ko, arg);
 	TASK_DEBUG("[%zu] koishi_resume returned (%s)", ev, task->debug_label);
 	return arg;
 }
 
+uint64_t cotask_resume_counter(void) {
+	return resume_counter;
+}
+
 static void cancel_task_events(CoTaskData *task_data) {
 	// HACK: This allows an entity-bound task to wait for its own "finished"
 	// event. Can be useful to do some cleanup without spawning a separate task
 	// just for that purpose.
 	// It's ok to unbind the entity like that, because when we get here, the
 	// task is about to die anyway.
-	task_data->bound_ent.ent = 0;
+	task_data->task->bound_ent.ent = 0;
 
 	COEVENT_CANCEL_ARRAY(task_data->events);
 }
@@ -288,15 +356,15 @@ static bool cotask_finalize(CoTask *task) {
 		task_data->master = NULL;
 	}
 
-	if(task_data->wait.wait_type == COTASK_WAIT_EVENT) {
-		CoEvent *evt = NOT_NULL(task_data->wait.event.pevent);
+	if(task->wait.wait_type == COTASK_WAIT_EVENT) {
+		CoEvent *evt = NOT_NULL(task->wait.event.pevent);
 
-		if(evt->unique_id == task_data->wait.event.snapshot.unique_id) {
-			coevent_cleanup_subscribers(task_data->wait.event.pevent);
+		if(evt->unique_id == task->wait.event.snapshot.unique_id) {
+			coevent_cleanup_subscribers(task->wait.event.pevent);
 		}
 	}
 
-	task_data->wait.wait_type = COTASK_WAIT_NONE;
+	task->wait.wait_type = COTASK_WAIT_NONE;
 
 	attr_unused bool had_slaves = false;
 
@@ -389,7 +457,7 @@ void cotask_free(CoTask *task) {
 	estimate_stack_usage(task);
 
 	task->unique_id = 0;
-	alist_push(&task_pool, task);
+	alist_push(task_pool + task->stack_class, task);
 
 	STAT_VAL_ADD(num_tasks_in_use, -1);
 
@@ -456,7 +524,7 @@ static void cotask_force_cancel(CoTask *task) {
 	// CoTaskData, since we don't need any of the 'advanced' features for this.
 	// This also means we don't need to cotask_finalize it.
 
-	CoTask *cancel_task = cotask_new_internal(cotask_cancel_in_safe_context);
+	CoTask *cancel_task = cotask_new_internal(cotask_cancel_in_safe_context, COTASK_STACK_DEFAULT);
 
 	// This is basically just koishi_resume + some logging when built with CO_TASK_DEBUG.
 	// We can't use normal cotask_resume here, since we don't have CoTaskData.
@@ -475,26 +543,25 @@ bool cotask_cancel(CoTask *task) {
 }
 
 static void *cotask_force_resume(CoTask *task, void *arg) {
-	attr_unused CoTaskData *task_data = cotask_get_data(task);
-	assert(task_data->wait.wait_type == COTASK_WAIT_NONE);
-	assert(!task_data->bound_ent.ent || ENT_UNBOX(task_data->bound_ent));
+	assert(task->data != NULL);
+	assert(task->wait.wait_type == COTASK_WAIT_NONE);
+	assert(!task->bound_ent.ent || ENT_UNBOX(task->bound_ent));
 	return cotask_resume_internal(task, arg);
 }
 
 static void *cotask_wake_and_resume(CoTask *task, void *arg) {
-	CoTaskData *task_data = cotask_get_data(task);
-	task_data->wait.wait_type = COTASK_WAIT_NONE;
+	task->wait.wait_type = COTASK_WAIT_NONE;
 	return cotask_force_resume(task, arg);
 }
 
-static bool cotask_do_wait(CoTaskData *task_data) {
-	switch(task_data->wait.wait_type) {
+static bool cotask_do_wait(CoTask *task) {
+	switch(task->wait.wait_type) {
 		case COTASK_WAIT_NONE: {
 			return false;
 		}
 
 		case COTASK_WAIT_DELAY: {
-			if(--task_data->wait.delay.remaining < 0) {
+			if(--task->wait.delay.remaining < 0) {
 				return false;
 			}
 
@@ -502,12 +569,12 @@ static bool cotask_do_wait(CoTaskData *task_data) {
 		}
 
 		case COTASK_WAIT_EVENT: {
-			// TASK_DEBUG("COTASK_WAIT_EVENT in task %s", task_data->task->debug_label);
+			// TASK_DEBUG("COTASK_WAIT_EVENT in task %s", task->debug_label);
 
-			CoEventStatus stat = coevent_poll(task_data->wait.event.pevent, &task_data->wait.event.snapshot);
+			CoEventStatus stat = coevent_poll(task->wait.event.pevent, &task->wait.event.snapshot);
 			if(stat != CO_EVENT_PENDING) {
-				task_data->wait.result.event_status = stat;
-				TASK_DEBUG("COTASK_WAIT_EVENT in task %s RESULT = %i", task_data->task->debug_label, stat);
+				task->wait.result.event_status = stat;
+				TASK_DEBUG("COTASK_WAIT_EVENT in task %s RESULT = %i", task->debug_label, stat);
 				return false;
 			}
 
@@ -515,7 +582,7 @@ static bool cotask_do_wait(CoTaskData *task_data) {
 		}
 
 		case COTASK_WAIT_SUBTASKS: {
-			if(task_data->slaves.first == NULL) {
+			if(cotask_get_data(task)->slaves.first == NULL) {
 				return false;
 			}
 
@@ -523,23 +590,24 @@ static bool cotask_do_wait(CoTaskData *task_data) {
 		}
 	}
 
-	task_data->wait.result.frames++;
+	task->wait.result.frames++;
 	return true;
 }
 
 void *cotask_resume(CoTask *task, void *arg) {
-	CoTaskData *task_data = cotask_get_data(task);
+	assert(task->data != NULL);
 
-	if(task_data->bound_ent.ent && !ENT_UNBOX(task_data->bound_ent)) {
+	if(task->bound_ent.ent && !ENT_UNBOX(task->bound_ent)) {
 		cotask_force_cancel(task);
 		return NULL;
 	}
 
-	if(!cotask_do_wait(task_data)) {
+	if(!cotask_do_wait(task)) {
 		return cotask_wake_and_resume(task, arg);
 	}
 
-	assert(task_data->wait.wait_type != COTASK_WAIT_NONE);
+	assert(task->wait.wait_type != COTASK_WAIT_NONE);
+	STAT_VAL_ADD(num_polls_this_frame, 1);
 	return NULL;
 }
 
@@ -555,45 +623,43 @@ void *cotask_yield(void *arg) {
 	return arg;
 }
 
-static inline CoWaitResult cotask_wait_init(CoTaskData *task_data, char wait_type) {
-	CoWaitResult wr = task_data->wait.result;
-	memset(&task_data->wait, 0, sizeof(task_data->wait));
-	task_data->wait.wait_type = wait_type;
+static inline CoWaitResult cotask_wait_init(CoTask *task, char wait_type) {
+	CoWaitResult wr = task->wait.result;
+	memset(&task->wait, 0, sizeof(task->wait));
+	task->wait.wait_type = wait_type;
 	return wr;
 }
 
 int cotask_wait(int delay) {
 	CoTask *task = cotask_active();
-	CoTaskData *task_data = cotask_get_data(task);
-	assert(task_data->wait.wait_type == COTASK_WAIT_NONE);
+	assert(task->wait.wait_type == COTASK_WAIT_NONE);
 
 	if(delay == 1) {
 		cotask_yield(NULL);
 		return 1;
 	}
 
-	cotask_wait_init(task_data, COTASK_WAIT_DELAY);
-	task_data->wait.delay.remaining = delay;
+	cotask_wait_init(task, COTASK_WAIT_DELAY);
+	task->wait.delay.remaining = delay;
 
-	if(cotask_do_wait(task_data)) {
+	if(cotask_do_wait(task)) {
 		cotask_yield(NULL);
 	}
 
-	return cotask_wait_init(task_data, COTASK_WAIT_NONE).frames;
+	return cotask_wait_init(task, COTASK_WAIT_NONE).frames;
 }
 
 int cotask_wait_subtasks(void) {
 	CoTask *task = cotask_active();
-	CoTaskData *task_data = cotask_get_data(task);
-	assert(task_data->wait.wait_type == COTASK_WAIT_NONE);
+	assert(task->wait.wait_type == COTASK_WAIT_NONE);
 
-	cotask_wait_init(task_data, COTASK_WAIT_SUBTASKS);
+	cotask_wait_init(task, COTASK_WAIT_SUBTASKS);
 
-	if(cotask_do_wait(task_data)) {
+	if(cotask_do_wait(task)) {
 		cotask_yield(NULL);
 	}
 
-	return cotask_wait_init(task_data, COTASK_WAIT_NONE).frames;
+	return cotask_wait_init(task, COTASK_WAIT_NONE).frames;
 }
 
 static void *_cotask_malloc(CoTaskData *task_data, size_t size, bool allow_heap_fallback) {
@@ -648,19 +714,18 @@ void cotask_host_events(CoTask *task, uint num_events, CoEvent events[num_events
 
 static CoWaitResult cotask_wait_event_internal(CoEvent *evt) {
 	CoTask *task = cotask_active();
-	CoTaskData *task_data = cotask_get_data(task);
 
 	coevent_add_subscriber(evt, task);
 
-	cotask_wait_init(task_data, COTASK_WAIT_EVENT);
-	task_data->wait.event.pevent = evt;
-	task_data->wait.event.snapshot = coevent_snapshot(evt);
+	cotask_wait_init(task, COTASK_WAIT_EVENT);
+	task->wait.event.pevent = evt;
+	task->wait.event.snapshot = coevent_snapshot(evt);
 
-	if(cotask_do_wait(task_data)) {
+	if(cotask_do_wait(task)) {
 		cotask_yield(NULL);
 	}
 
-	return cotask_wait_init(task_data, COTASK_WAIT_NONE);
+	return cotask_wait_init(task, COTASK_WAIT_NONE);
 }
 
 CoWaitResult cotask_wait_event(CoEvent *evt) {
@@ -703,15 +768,15 @@ CoSched *cotask_get_sched(CoTask *task) {
 }
 
 EntityInterface *(cotask_bind_to_entity)(CoTask *task, EntityInterface *ent) {
-	CoTaskData *task_data = cotask_get_data(task);
-	assert(task_data->bound_ent.ent == 0);
+	assert(task->data != NULL);
+	assert(task->bound_ent.ent == 0);
 
 	if(ent == NULL) {
 		cotask_force_cancel(task);
 		UNREACHABLE;
 	}
 
-	task_data->bound_ent = ENT_BOX(ent);
+	task->bound_ent = ENT_BOX(ent);
 	return ent;
 }
 
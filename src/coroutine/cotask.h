@@ -21,6 +21,15 @@ typedef struct CoTask CoTask;
 typedef LIST_ANCHOR(CoTask) CoTaskList;
 typedef void *(*CoTaskFunc)(void *arg, size_t argsize);
 
+// Stack size class of a task. Stacks are pooled per class.
+// Use COTASK_STACK_SMALL for simple leaf tasks that don't call deep into the engine.
+typedef enum CoTaskStackClass {
+	COTASK_STACK_DEFAULT,
+	COTASK_STACK_SMALL,
+
+	COTASK_STACK_NUM_CLASSES,
+} CoTaskStackClass;
+
 typedef enum CoStatus {
 	CO_STATUS_SUSPENDED = KOISHI_SUSPENDED,
 	CO_STATUS_RUNNING   = KOISHI_RUNNING,
@@ -72,5 +81,9 @@ EntityInterface *cotask_host_entity(CoTask *task, size_t ent_size, EntityType en
 void cotask_host_events(CoTask *task, uint num_events, CoEvent events[num_events]) attr_nonnull_all;
 CoSched *cotask_get_sched(CoTask *task);
 
+// Incremented every time any task is resumed. Useful to detect whether arbitrary
+// task code may have run (and mutated game state) between two points.
+uint64_t cotask_resume_counter(void);
+
 BoxedTask cotask_box(CoTask *task);
 CoTask *cotask_unbox(BoxedTask box);
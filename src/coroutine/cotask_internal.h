@@ -15,6 +15,17 @@
 	#define CO_STACK_SIZE (256 * 1024)
 #endif
 
+// The guard page below comes out of these sizes. Don't shrink the small class below CO_STACK_SIZE
+// until the worst case stack depth of the tasks using it has been measured (see CO_TASK_STATS_STACK;
+// the coroutines benchmark of taisei-bench reports what the size buys in memory and spawn time).
+#define CO_STACK_SIZE_SMALL CO_STACK_SIZE
+
+// Make the lowest page of each stack inaccessible, so that an overflow faults immediately
+// instead of corrupting adjacent memory. Incompatible with the canary fill of CO_TASK_STATS_STACK.
+#if defined(TAISEI_BUILDCONF_HAVE_POSIX) && !defined(__EMSCRIPTEN__)
+	#define CO_STACK_GUARD_PAGE
+#endif
+
 #ifdef CO_TASK_DEBUG
 	#define TASK_DEBUG(...) log_debug(__VA_ARGS__)
 	extern size_t _cotask_debug_event_id;
@@ -54,7 +65,30 @@ struct CoTask {
 	// Pointer to a control structure on the coroutine's stack
 	CoTaskData *data;
 
+	// The scheduler checks these for every task on every frame, so they live here rather than in
+	// CoTaskData. That way a task that is still waiting costs a look at this struct, instead of a
+	// cache miss on its stack.
+	BoxedEntity bound_ent;
+
+	struct {
+		CoWaitResult result;
+
+		union {
+			struct {
+				int remaining;
+			} delay;
+
+			struct {
+				CoEvent *pevent;
+				CoEventSnapshot snapshot;
+			} event;
+		};
+
+		uint wait_type;
+	} wait;
+
 	uint32_t unique_id;
+	CoTaskStackClass stack_class;
 
 	#ifdef CO_TASK_DEBUG
 	char debug_label[256];
@@ -65,7 +99,9 @@ struct CoTask {
 typedef struct CoTaskStats {
 	size_t num_tasks_allocated;
 	size_t num_tasks_in_use;
+	size_t stack_bytes_allocated;
 	size_t num_switches_this_frame;
+	size_t num_polls_this_frame;  // resume attempts on tasks that kept waiting; no switch needed
 	size_t peak_stack_usage;
 } CoTaskStats;
 extern CoTaskStats cotask_stats;
@@ -79,6 +115,10 @@ extern CoTaskStats cotask_stats;
 // #define CO_TASK_STATS_STACK
 #endif
 
+#ifdef CO_TASK_STATS_STACK
+#undef CO_STACK_GUARD_PAGE
+#endif
+
 #else // CO_TASK_STATS
 
 #define STAT_VAL(name) ((void)0)
@@ -102,28 +142,10 @@ struct CoTaskData {
 	CoTaskData *master;              // AKA supertask
 	LIST_ANCHOR(CoTaskData) slaves;  // AKA subtasks
 
-	BoxedEntity bound_ent;
 	CoTaskEvents events;
 
 	bool finalizing;
 
-	struct {
-		CoWaitResult result;
-
-		union {
-			struct {
-				int remaining;
-			} delay;
-
-			struct {
-				CoEvent *pevent;
-				CoEventSnapshot snapshot;
-			} event;
-		};
-
-		uint wait_type;
-	} wait;
-
 	struct {
 		EntityInterface *ent;
 		CoEvent *events;
@@ -149,7 +171,7 @@ typedef struct CoTaskInitData {
 void cotask_global_init(void);
 void cotask_global_shutdown(void);
 
-CoTask *cotask_new_internal(koishi_entrypoint_t entry_point);
+CoTask *cotask_new_internal(koishi_entrypoint_t entry_point, CoTaskStackClass stack_class);
 void *cotask_resume_internal(CoTask *task, void *arg);
 CoTask *cotask_unbox_notnull(BoxedTask box);
 void cotask_force_finish(CoTask *task);
@@ -81,9 +81,11 @@
 	/* user-defined task body */ \
 	static void COTASK_##name(TASK_ARGS_TYPE(name) *_cotask_args) /* require semicolon */
 
-#define TASK_COMMON_DECLARATIONS(name, argstype, handletype, linkage) \
+#define TASK_COMMON_DECLARATIONS(name, argstype, handletype, linkage, stackclass) \
 	/* produce warning if the task is never used */ \
 	linkage char COTASK_UNUSED_CHECK_##name; \
+	/* stack size class to run the task with (see CoTaskStackClass) */ \
+	enum { COTASK_STACK_CLASS_##name = (stackclass) }; \
 	/* type of indirect handle to a compatible task */ \
 	typedef handletype TASK_INDIRECT_TYPE_ALIAS(name); \
 	/* user-defined type of args struct */ \
@@ -154,8 +156,8 @@
 	linkage void COTASK_##name(TASK_ARGS_TYPE(name) *_cotask_args)
 
 
-#define DECLARE_TASK_EXPLICIT(name, argstype, handletype, linkage) \
-	TASK_COMMON_DECLARATIONS(name, argstype, handletype, linkage) /* require semicolon */
+#define DECLARE_TASK_EXPLICIT(name, argstype, handletype, linkage, stackclass) \
+	TASK_COMMON_DECLARATIONS(name, argstype, handletype, linkage, stackclass) /* require semicolon */
 
 #define DEFINE_TASK_EXPLICIT(name, linkage) \
 	TASK_COMMON_PRIVATE_DECLARATIONS(name); \
@@ -168,12 +170,19 @@
 #define DECLARE_TASK(name, ...) \
 	MACROHAX_OVERLOAD_HASARGS(DECLARE_TASK_, __VA_ARGS__)(name, ##__VA_ARGS__)
 #define DECLARE_TASK_1(name, ...) \
-	DECLARE_TASK_EXPLICIT(name, TASK_ARGS_STRUCT(__VA_ARGS__), void, static) /* require semicolon */
+	DECLARE_TASK_WITH_STACK_1(name, COTASK_STACK_DEFAULT, __VA_ARGS__) /* require semicolon */
 #define DECLARE_TASK_0(name) DECLARE_TASK_1(name, { })
 
+/* like DECLARE_TASK, but with a non-default stack size class (see CoTaskStackClass) */
+#define DECLARE_TASK_WITH_STACK(name, stackclass, ...) \
+	MACROHAX_OVERLOAD_HASARGS(DECLARE_TASK_WITH_STACK_, __VA_ARGS__)(name, stackclass, ##__VA_ARGS__)
+#define DECLARE_TASK_WITH_STACK_1(name, stackclass, ...) \
+	DECLARE_TASK_EXPLICIT(name, TASK_ARGS_STRUCT(__VA_ARGS__), void, static, stackclass) /* require semicolon */
+#define DECLARE_TASK_WITH_STACK_0(name, stackclass) DECLARE_TASK_WITH_STACK_1(name, stackclass, { })
+
 /* declare a task with static linkage that conforms to a common interface (needs to be defined later) */
 #define DECLARE_TASK_WITH_INTERFACE(name, iface) \
-	DECLARE_TASK_EXPLICIT(name, TASK_IFACE_ARGS_TYPE(iface), TASK_INDIRECT_TYPE(iface), static) /* require semicolon */
+	DECLARE_TASK_EXPLICIT(name, TASK_IFACE_ARGS_TYPE(iface), TASK_INDIRECT_TYPE(iface), static, COTASK_STACK_DEFAULT) /* require semicolon */
 
 /* define a task with static linkage (needs to be declared first) */
 #define DEFINE_TASK(name) \
@@ -184,6 +193,11 @@
 	DECLARE_TASK(name, ##__VA_ARGS__); \
 	DEFINE_TASK(name)
 
+/* declare and define a task with static linkage and a non-default stack size class */
+#define TASK_WITH_STACK(name, stackclass, ...) \
+	DECLARE_TASK_WITH_STACK(name, stackclass, ##__VA_ARGS__); \
+	DEFINE_TASK(name)
+
 /* declare and define a task with static linkage that conforms to a common interface */
 #define TASK_WITH_INTERFACE(name, iface) \
 	DECLARE_TASK_WITH_INTERFACE(name, iface); \
@@ -194,13 +208,21 @@
 #define DECLARE_EXTERN_TASK(name, ...)\
 	MACROHAX_OVERLOAD_HASARGS(DECLARE_EXTERN_TASK_, __VA_ARGS__)(name, ##__VA_ARGS__)
 #define DECLARE_EXTERN_TASK_1(name, ...) \
-	DECLARE_TASK_EXPLICIT(name, TASK_ARGS_STRUCT(__VA_ARGS__), void, extern) /* require semicolon */
+	DECLARE_EXTERN_TASK_WITH_STACK_1(name, COTASK_STACK_DEFAULT, __VA_ARGS__) /* require semicolon */
 #define DECLARE_EXTERN_TASK_0(name) \
 	DECLARE_EXTERN_TASK_1(name, { })
 
+/* like DECLARE_EXTERN_TASK, but with a non-default stack size class (see CoTaskStackClass) */
+#define DECLARE_EXTERN_TASK_WITH_STACK(name, stackclass, ...) \
+	MACROHAX_OVERLOAD_HASARGS(DECLARE_EXTERN_TASK_WITH_STACK_, __VA_ARGS__)(name, stackclass, ##__VA_ARGS__)
+#define DECLARE_EXTERN_TASK_WITH_STACK_1(name, stackclass, ...) \
+	DECLARE_TASK_EXPLICIT(name, TASK_ARGS_STRUCT(__VA_ARGS__), void, extern, stackclass) /* require semicolon */
+#define DECLARE_EXTERN_TASK_WITH_STACK_0(name, stackclass) \
+	DECLARE_EXTERN_TASK_WITH_STACK_1(name, stackclass, { })
+
 /* declare a task with extern linkage that conforms to a common interface (needs to be defined later) */
 #define DECLARE_EXTERN_TASK_WITH_INTERFACE(name, iface) \
-	DECLARE_TASK_EXPLICIT(name, TASK_IFACE_ARGS_TYPE(iface), TASK_INDIRECT_TYPE(iface), extern) /* require semicolon */
+	DECLARE_TASK_EXPLICIT(name, TASK_IFACE_ARGS_TYPE(iface), TASK_INDIRECT_TYPE(iface), extern, COTASK_STACK_DEFAULT) /* require semicolon */
 
 /* define a task with extern linkage (needs to be declared first) */
 #define DEFINE_EXTERN_TASK(name) \
@@ -240,6 +262,7 @@
 		COTASKTHUNK_##name, \
 		(&(TASK_ARGS_TYPE(name)) { __VA_ARGS__ }), \
 		sizeof(TASK_ARGS_TYPE(name)), \
+		COTASK_STACK_CLASS_##name, \
 		#name \
 	) \
 )
@@ -274,6 +297,7 @@
 			.delay = (_delay) \
 		}), \
 		sizeof(TASK_ARGSDELAY(name)), \
+		COTASK_STACK_CLASS_##name, \
 		#name \
 	) \
 )
@@ -317,6 +341,7 @@
 			.unconditional = is_unconditional \
 		}), \
 		sizeof(TASK_ARGSCOND(name)), \
+		COTASK_STACK_CLASS_##name, \
 		#name \
 	) \
 )
@@ -337,7 +362,7 @@
 #define CANCEL_TASK_WHEN(_event, _task) INVOKE_TASK_WHEN(_event, _cancel_task_helper, _task)
 #define CANCEL_TASK_AFTER(_event, _task) INVOKE_TASK_AFTER(_event, _cancel_task_helper, _task)
 
-DECLARE_EXTERN_TASK(_cancel_task_helper, { BoxedTask task; });
+DECLARE_EXTERN_TASK_WITH_STACK(_cancel_task_helper, COTASK_STACK_SMALL, { BoxedTask task; });
 
 #define CANCEL_TASK(boxed_task) cotask_cancel(cotask_unbox(boxed_task))
 
@@ -355,6 +380,7 @@ DECLARE_EXTERN_TASK(_cancel_task_helper, { BoxedTask task; });
 		taskhandle._cotask_##iface##_thunk, \
 		(&(TASK_IFACE_ARGS_TYPE(iface)) { __VA_ARGS__ }), \
 		sizeof(TASK_IFACE_ARGS_TYPE(iface)), \
+		COTASK_STACK_DEFAULT, \
 		"<indirect:"#iface">" \
 	) \
 )
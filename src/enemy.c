@@ -17,6 +17,7 @@
 #include "stageobjects.h"
 #include "util/glm.h"
 #include "entity.h"
+#include "profiler.h"
 
 #ifdef create_enemy_p
 #undef create_enemy_p
@@ -346,9 +347,9 @@ static DamageResult ent_damage_enemy(EntityInterface *ienemy, const DamageInfo *
 	}
 
 	if(enemy->hp < enemy->spawn_hp * 0.1) {
-		play_sfx_loop("hit1");
+		play_sfx_loop_handle(SFX_HANDLE("hit1"));
 	} else {
-		play_sfx_loop("hit0");
+		play_sfx_loop_handle(SFX_HANDLE("hit0"));
 	}
 
 	return DMG_RESULT_OK;
@@ -369,6 +370,8 @@ static bool should_auto_kill(Enemy *enemy) {
 }
 
 void process_enemies(EnemyList *enemies) {
+	PROF_ZONE("process_enemies");
+
 	for(Enemy *enemy = enemies->first, *next; enemy; enemy = next) {
 		next = enemy->next;
 
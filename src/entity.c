@@ -13,6 +13,7 @@
 #include "renderer/api.h"
 #include "global.h"
 #include "dynarray.h"
+#include "profiler.h"
 
 typedef struct EntityDrawHook EntityDrawHook;
 typedef LIST_ANCHOR(EntityDrawHook) EntityDrawHookList;
@@ -23,9 +24,21 @@ struct EntityDrawHook {
 	void *arg;
 };
 
+typedef struct EntitySortItem {
+	uint64_t key;
+	EntityInterface *ent;
+} EntitySortItem;
+
 static struct {
+	// Kept in draw order as of the last ent_draw() call, except for entities
+	// registered since then, which are appended at the end. Unregistering leaves
+	// a NULL hole behind to not disturb the order; holes are compacted lazily.
 	DYNAMIC_ARRAY(EntityInterface*) registered;
+	DYNAMIC_ARRAY(EntitySortItem) sort_items;
+	DYNAMIC_ARRAY(EntitySortItem) sort_temp;
 	uint32_t total_spawns;
+	uint32_t num_vacant;
+	bool drawing;
 
 	struct {
 		EntityDrawHookList pre_draw;
@@ -65,18 +78,53 @@ void ent_init(void) {
 }
 
 void ent_shutdown(void) {
-	if(entities.registered.num_elements) {
-		log_fatal_if_debug("%u entities were not properly unregistered, this is a bug!", entities.registered.num_elements);
+	uint num_registered = entities.registered.num_elements - entities.num_vacant;
+
+	if(num_registered) {
+		log_fatal_if_debug("%u entities were not properly unregistered, this is a bug!", num_registered);
 	}
 
 	dynarray_free_data(&entities.registered);
+	dynarray_free_data(&entities.sort_items);
+	dynarray_free_data(&entities.sort_temp);
 
 	assert(entities.hooks.post_draw.first == NULL);
 	assert(entities.hooks.pre_draw.first == NULL);
 }
 
+static void ent_compact(void) {
+	if(!entities.num_vacant) {
+		return;
+	}
+
+	dynarray_size_t n = 0;
+
+	dynarray_foreach_elem(&entities.registered, EntityInterface **pent, {
+		EntityInterface *ent = *pent;
+
+		if(ent) {
+			ent->index = n;
+			entities.registered.data[n++] = ent;
+		}
+	});
+
+	entities.registered.num_elements = n;
+	entities.num_vacant = 0;
+}
+
 void ent_register(EntityInterface *ent, EntityType type) {
 	assert(type > _ENT_TYPE_ENUM_BEGIN && type < _ENT_TYPE_ENUM_END);
+
+	// Don't let holes pile up if nothing is drawing (e.g. when verifying replays).
+	// Never compact from within ent_draw(), though: that would shift entities under its loop.
+	if(
+		!entities.drawing &&
+		entities.num_vacant > 1024 &&
+		entities.num_vacant > entities.registered.num_elements / 2
+	) {
+		ent_compact();
+	}
+
 	ent->type = type;
 	ent->spawn_id = ++entities.total_spawns;
 	ent->index = entities.registered.num_elements;
@@ -87,27 +135,138 @@ void ent_register(EntityInterface *ent, EntityType type) {
 void ent_unregister(EntityInterface *ent) {
 	ent->spawn_id = 0;
 
-	// Fast non-order-preserving removal by moving the last element into the removed element's position.
-
 	assert(ent->index < entities.registered.num_elements);
 	assert(dynarray_get(&entities.registered, ent->index) == ent);
-	EntityInterface *sub = entities.registered.data[--entities.registered.num_elements];
-	entities.registered.data[sub->index = ent->index] = sub;
+	dynarray_set(&entities.registered, ent->index, NULL);
+	++entities.num_vacant;
 	del_ref(ent);
 }
 
-static int ent_cmp(const void *ptr1, const void *ptr2) {
-	const EntityInterface *ent1 = *(const EntityInterface**)ptr1;
-	const EntityInterface *ent2 = *(const EntityInterface**)ptr2;
+static inline uint64_t ent_sort_key(EntityInterface *ent) {
+	// Sort by layer first. Same layer? Put whatever spawned later on top, then.
+	return ((uint64_t)ent->draw_layer << 32) | ent->spawn_id;
+}
+
+static void ent_radix_sort(dynarray_size_t n, EntitySortItem items[n], EntitySortItem temp[n]) {
+	enum { DIGIT_BITS = 8, NUM_DIGITS = 64 / DIGIT_BITS, RADIX = 1 << DIGIT_BITS };
+	uint32_t counts[NUM_DIGITS][RADIX] = { 0 };
+
+	for(dynarray_size_t i = 0; i < n; ++i) {
+		uint64_t key = items[i].key;
+
+		for(uint d = 0; d < NUM_DIGITS; ++d) {
+			++counts[d][(key >> (d * DIGIT_BITS)) & (RADIX - 1)];
+		}
+	}
+
+	EntitySortItem *src = items;
+	EntitySortItem *dst = temp;
+
+	for(uint d = 0; d < NUM_DIGITS; ++d) {
+		uint32_t *c = counts[d];
+
+		// Skip passes where all keys have the same digit; the high bits of the layer
+		// and spawn id are often identical across all entities.
+		if(c[(src[0].key >> (d * DIGIT_BITS)) & (RADIX - 1)] == n) {
+			continue;
+		}
+
+		uint32_t sum = 0;
+
+		for(uint b = 0; b < RADIX; ++b) {
+			uint32_t tmp = c[b];
+			c[b] = sum;
+			sum += tmp;
+		}
+
+		for(dynarray_size_t i = 0; i < n; ++i) {
+			dst[c[(src[i].key >> (d * DIGIT_BITS)) & (RADIX - 1)]++] = src[i];
+		}
+
+		EntitySortItem *tmp = src;
+		src = dst;
+		dst = tmp;
+	}
+
+	if(src != items) {
+		memcpy(items, src, sizeof(*items) * n);
+	}
+}
+
+static void ent_merge(
+	dynarray_size_t n1, EntitySortItem a[n1],
+	dynarray_size_t n2, EntitySortItem b[n2],
+	EntitySortItem out[n1 + n2]
+) {
+	dynarray_size_t i = 0, j = 0, k = 0;
+
+	while(i < n1 && j < n2) {
+		out[k++] = (b[j].key < a[i].key) ? b[j++] : a[i++];
+	}
+
+	while(i < n1) {
+		out[k++] = a[i++];
+	}
+
+	while(j < n2) {
+		out[k++] = b[j++];
+	}
+}
+
+/*
+ * The draw order rarely changes much between frames: usually some entities were
+ * spawned since the last sort (appended at the end), some were removed (holes),
+ * and only a few changed their layer. So instead of a full comparison sort, check
+ * how much of the array is still in order and only sort what's necessary.
+ */
+static void ent_sort(void) {
+	ent_compact();
+
+	dynarray_size_t n = entities.registered.num_elements;
+
+	if(n < 2) {
+		return;
+	}
+
+	dynarray_ensure_capacity(&entities.sort_items, n);
+	entities.sort_items.num_elements = n;
+	EntitySortItem *items = entities.sort_items.data;
+
+	dynarray_size_t sorted_prefix = n;
+
+	for(dynarray_size_t i = 0; i < n; ++i) {
+		EntityInterface *ent = entities.registered.data[i];
+		items[i] = (EntitySortItem) { ent_sort_key(ent), ent };
+
+		if(i > 0 && sorted_prefix == n && items[i].key < items[i - 1].key) {
+			sorted_prefix = i;
+		}
+	}
+
+	if(sorted_prefix == n) {
+		return;
+	}
+
+	dynarray_ensure_capacity(&entities.sort_temp, n);
+	entities.sort_temp.num_elements = n;
+	EntitySortItem *temp = entities.sort_temp.data;
 
-	int r = (ent1->draw_layer > ent2->draw_layer) - (ent1->draw_layer < ent2->draw_layer);
+	dynarray_size_t tail = n - sorted_prefix;
 
-	if(r == 0) {
-		// Same layer? Put whatever spawned later on top, then.
-		r = (ent1->spawn_id > ent2->spawn_id) - (ent1->spawn_id < ent2->spawn_id);
+	if(tail <= n / 4) {
+		// Mostly fresh spawns: sort just the tail, then merge it into the ordered prefix.
+		ent_radix_sort(tail, items + sorted_prefix, temp);
+		ent_merge(sorted_prefix, items, tail, items + sorted_prefix, temp);
+		memcpy(items, temp, sizeof(*items) * n);
+	} else {
+		ent_radix_sort(n, items, temp);
 	}
 
-	return r;
+	for(dynarray_size_t i = 0; i < n; ++i) {
+		EntityInterface *ent = items[i].ent;
+		ent->index = i;
+		entities.registered.data[i] = ent;
+	}
 }
 
 static inline bool ent_is_drawable(EntityInterface *ent) {
@@ -115,15 +274,20 @@ static inline bool ent_is_drawable(EntityInterface *ent) {
 }
 
 void ent_draw(EntityPredicate predicate) {
+	PROF_ZONE("ent_draw");
+
 	call_hooks(&entities.hooks.pre_draw, NULL);
-	dynarray_qsort(&entities.registered, ent_cmp);
+	ent_sort();
+	entities.drawing = true;
+
+	// NOTE: draw functions and hooks may unregister entities, leaving NULL holes behind.
 
-	if(predicate) {
-		dynarray_foreach(&entities.registered, int i, EntityInterface **pent, {
+	if(entities.hooks.pre_draw.first || entities.hooks.post_draw.first) {
+		// Hooks may set up state for each entity; isolate every draw call.
+		dynarray_foreach_elem(&entities.registered, EntityInterface **pent, {
 			EntityInterface *ent = *pent;
-			ent->index = i;
 
-			if(ent_is_drawable(ent) && predicate(ent)) {
+			if(ent && ent_is_drawable(ent) && (!predicate || predicate(ent))) {
 				call_hooks(&entities.hooks.pre_draw, ent);
 				r_state_push();
 				ent->draw_func(ent);
@@ -132,20 +296,28 @@ void ent_draw(EntityPredicate predicate) {
 			}
 		});
 	} else {
-		dynarray_foreach(&entities.registered, int i, EntityInterface **pent, {
+		// Most entities (e.g. plain projectiles) just feed the sprite batch and don't touch the
+		// render state at all. Keep one state frame open and only roll it back after an entity
+		// actually modifies something, instead of pushing and popping around every single one.
+		r_state_push();
+
+		dynarray_foreach_elem(&entities.registered, EntityInterface **pent, {
 			EntityInterface *ent = *pent;
-			ent->index = i;
 
-			if(ent_is_drawable(ent)) {
-				call_hooks(&entities.hooks.pre_draw, ent);
-				r_state_push();
+			if(ent && ent_is_drawable(ent) && (!predicate || predicate(ent))) {
 				ent->draw_func(ent);
-				r_state_pop();
-				call_hooks(&entities.hooks.post_draw, ent);
+
+				if(r_state_is_dirty()) {
+					r_state_pop();
+					r_state_push();
+				}
 			}
 		});
+
+		r_state_pop();
 	}
 
+	entities.drawing = false;
 	call_hooks(&entities.hooks.post_draw, NULL);
 }
 
@@ -172,8 +344,11 @@ DamageResult ent_damage(EntityInterface *ent, const DamageInfo *damage) {
 }
 
 void ent_area_damage(cmplx origin, float radius, const DamageInfo *damage, EntityAreaDamageCallback callback, void *callback_arg) {
+	Circle area = { origin, radius };
+
 	for(Enemy *e = global.enemies.first; e; e = e->next) {
 		if(
+			point_in_circle_bbox(e->pos, area) &&
 			cabs(origin - e->pos) < radius &&
 			ent_damage(&e->ent, damage) == DMG_RESULT_OK &&
 			callback != NULL
@@ -193,9 +368,11 @@ void ent_area_damage(cmplx origin, float radius, const DamageInfo *damage, Entit
 }
 
 void ent_area_damage_ellipse(Ellipse ellipse, const DamageInfo *damage, EntityAreaDamageCallback callback, void *callback_arg) {
+	Rect bbox = ellipse_bbox(ellipse);
+
 	for(Enemy *e = global.enemies.first; e; e = e->next) {
 		if(
-			point_in_ellipse(e->pos, ellipse) &&
+			point_in_ellipse_with_bbox(e->pos, ellipse, bbox) &&
 			ent_damage(&e->ent, damage) == DMG_RESULT_OK &&
 			callback != NULL
 		) {
@@ -205,7 +382,7 @@ void ent_area_damage_ellipse(Ellipse ellipse, const DamageInfo *damage, EntityAr
 
 	if(
 		global.boss != NULL &&
-		point_in_ellipse(global.boss->pos, ellipse) &&
+		point_in_ellipse_with_bbox(global.boss->pos, ellipse, bbox) &&
 		ent_damage(&global.boss->ent, damage) == DMG_RESULT_OK &&
 		callback != NULL
 	) {
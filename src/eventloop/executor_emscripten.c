@@ -11,6 +11,7 @@
 #include "eventloop_private.h"
 #include "events.h"
 #include "global.h"
+#include "profiler.h"
 
 #include <emscripten.h>
 
@@ -54,6 +55,7 @@ static void em_loop_callback(void) {
 	}
 
 	fpscounter_update(&global.fps.busy);
+	prof_frame_end();
 }
 
 static void update_vsync(void) {
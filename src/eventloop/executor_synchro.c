@@ -12,6 +12,7 @@
 #include "util.h"
 #include "framerate.h"
 #include "global.h"
+#include "profiler.h"
 
 void eventloop_run(void) {
 	assert(is_main_thread());
@@ -97,6 +98,7 @@ begin_frame:
 		}
 
 		fpscounter_update(&global.fps.busy);
+		prof_frame_end();
 
 		if(uncapped_rendering || global.frameskip > 0 || global.is_replay_verification) {
 			continue;
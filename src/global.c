@@ -25,6 +25,10 @@ void init_global(CLIAction *cli) {
 		global.is_headless = true;
 		global.is_replay_verification = true;
 		global.frameskip = 1;
+	} else if(cli->type == CLI_BenchReplay) {
+		// Unlike verification, this still runs the render frames, on the null renderer.
+		global.is_headless = true;
+		global.frameskip = 1;
 	} else if(global.frameskip) {
 		log_warn("FPS limiter disabled. Gotta go fast! (frameskip = %i)", global.frameskip);
 	}
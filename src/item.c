@@ -12,6 +12,7 @@
 #include "global.h"
 #include "list.h"
 #include "stageobjects.h"
+#include "profiler.h"
 
 // Instant collection radius.
 // This is not the same as the player's PLR_PROP_COLLECT_RADIUS property, which is the minimum
@@ -239,10 +240,17 @@ void collect_all_items(float value) {
 }
 
 void process_items(void) {
+	PROF_ZONE("process_items");
+
 	Item *item = global.items.first, *del = NULL;
 	float attract_dist = player_property(&global.plr, PLR_PROP_COLLECT_RADIUS);
 	bool plr_alive = player_is_alive(&global.plr);
-	bool stage_cleared = stage_is_cleared();
+	bool collect_all = stage_is_cleared() || cimag(global.plr.pos) < player_property(&global.plr, PLR_PROP_POC);
+	float attract_collect_value = 1 - cimag(global.plr.pos) / VIEWPORT_H;
+	bool play_collect_sfx = false;
+
+	// Thousands of items may be grabbed at once during clears; don't spawn a score text for each.
+	player_begin_score_text_batch(&global.plr);
 
 	while(item != NULL) {
 		bool may_collect = true;
@@ -275,10 +283,10 @@ void process_items(void) {
 			real item_dist2 = cabs2(global.plr.pos - item->pos);
 
 			if(plr_alive) {
-				if(cimag(global.plr.pos) < player_property(&global.plr, PLR_PROP_POC) || stage_cleared) {
+				if(collect_all) {
 					collect_item(item, 1);
 				} else if(item_dist2 < attract_dist * attract_dist) {
-					collect_item(item, 1 - cimag(global.plr.pos) / VIEWPORT_H);
+					collect_item(item, attract_collect_value);
 					item->auto_collect = 2;
 				}
 			} else if(item->auto_collect) {
@@ -299,30 +307,30 @@ void process_items(void) {
 				player_add_power(&global.plr, POWER_VALUE);
 				player_add_points(&global.plr, 25, item->pos);
 				player_extend_powersurge(&global.plr, PLR_POWERSURGE_POSITIVE_GAIN*3, PLR_POWERSURGE_NEGATIVE_GAIN*3);
-				play_sfx("item_generic");
+				play_collect_sfx = true;
 				break;
 			case ITEM_POWER_MINI:
 				player_add_power(&global.plr, POWER_VALUE_MINI);
 				player_add_points(&global.plr, 5, item->pos);
-				play_sfx("item_generic");
+				play_collect_sfx = true;
 				break;
 			case ITEM_SURGE:
 				player_extend_powersurge(&global.plr, PLR_POWERSURGE_POSITIVE_GAIN, PLR_POWERSURGE_NEGATIVE_GAIN);
 				player_add_points(&global.plr, 25, item->pos);
-				play_sfx("item_generic");
+				play_collect_sfx = true;
 				break;
 			case ITEM_POINTS:
 				player_add_points(&global.plr, round(global.plr.point_item_value * item->pickup_value), item->pos);
-				play_sfx("item_generic");
+				play_collect_sfx = true;
 				break;
 			case ITEM_PIV:
 				player_add_piv(&global.plr, 1, item->pos);
-				play_sfx("item_generic");
+				play_collect_sfx = true;
 				break;
 			case ITEM_VOLTAGE:
 				player_add_voltage(&global.plr, 1);
 				player_add_piv(&global.plr, 10, item->pos);
-				play_sfx("item_generic");
+				play_collect_sfx = true;
 				break;
 			case ITEM_LIFE:
 				player_add_lives(&global.plr, 1);
@@ -347,6 +355,12 @@ void process_items(void) {
 			item = item->next;
 		}
 	}
+
+	player_end_score_text_batch(&global.plr);
+
+	if(play_collect_sfx) {
+		play_sfx_handle(SFX_HANDLE("item_generic"));
+	}
 }
 
 static void spawn_item_internal(cmplx pos, ItemType type, float collect_value) {
@@ -27,8 +27,18 @@ typedef struct LaserSegment {
 	};
 } LaserSegment;
 
+// Bounding box of up to LASER_CHUNK_SIZE consecutive segments of a laser.
+// Lets intersection tests skip whole parts of long lasers at once.
+typedef struct LaserChunk {
+	FloatOffset top_left, bottom_right;
+	float max_width;
+} LaserChunk;
+
+#define LASER_CHUNK_SIZE 8
+
 typedef struct LaserInternalData {
 	DYNAMIC_ARRAY(LaserSegment) segments;
+	DYNAMIC_ARRAY(LaserChunk) chunks;
 } LaserInternalData;
 
 extern LaserInternalData lintern;
@@ -21,6 +21,7 @@
 #include "util/fbmgr.h"
 #include "util/glm.h"
 #include "video.h"
+#include "profiler.h"
 
 typedef struct LaserSamplingParams {
 	uint num_samples;
@@ -28,6 +29,10 @@ typedef struct LaserSamplingParams {
 	float time_step;
 } LaserSamplingParams;
 
+typedef void (*LaserBatchPosRule)(Laser *l, float t, float step, uint num, cmplxf out[num]);
+
+static LaserBatchPosRule laser_get_batch_rule(LaserPosRule prule);
+
 void lasers_init(void) {
 	laserintern_init();
 	laserdraw_init();
@@ -95,6 +100,7 @@ static void *_delete_laser(ListAnchor *lasers, List *laser, void *arg) {
 	}
 
 	ent_unregister(&l->ent);
+	dynarray_free_data(&l->_internal.sample_cache.samples);
 	objpool_release(stage_object_pools.lasers, alist_unlink(lasers, laser));
 	return NULL;
 }
@@ -163,12 +169,70 @@ static float calc_sample_width(
 	);
 }
 
+static bool laser_sample_cache_valid(Laser *l, const LaserSamplingParams *sp) {
+	auto cache = &l->_internal.sample_cache;
+
+	// Compared bitwise: the rules may tell -0 apart from +0 (e.g. via carg).
+	return
+		cache->prule == l->prule &&
+		cache->samples.num_elements == sp->num_samples &&
+		!memcmp(&cache->time_shift, &sp->time_shift, sizeof(sp->time_shift)) &&
+		!memcmp(&cache->pos, &l->pos, sizeof(l->pos)) &&
+		!memcmp(cache->args, l->args, sizeof(l->args));
+}
+
+static const cmplxf *laser_sample_curve(Laser *l, const LaserSamplingParams *sp, cmplx *out_prev) {
+	// Returns sp->num_samples points along the laser curve, starting at sp->time_shift; and in
+	// out_prev, the point one step before that.
+	//
+	// The built-in rules only depend on pos, args and t, so for lasers that don't move along their
+	// curve (e.g. static ones) the points can be reused for as long as those stay the same.
+
+	auto cache = &l->_internal.sample_cache;
+	LaserBatchPosRule batch_rule = laser_get_batch_rule(l->prule);
+
+	if(batch_rule && laser_sample_cache_valid(l, sp)) {
+		*out_prev = cache->prev_sample;
+		return cache->samples.data;
+	}
+
+	dynarray_ensure_capacity(&cache->samples, sp->num_samples);
+	cache->samples.num_elements = sp->num_samples;
+	cmplxf *samples = cache->samples.data;
+	float t = sp->time_shift;
+
+	if(batch_rule) {
+		batch_rule(l, t, sp->time_step, sp->num_samples, samples);
+		cache->prev_sample = l->prule(l, t - sp->time_step);
+		cache->prule = l->prule;
+		cache->pos = l->pos;
+		memcpy(cache->args, l->args, sizeof(l->args));
+		cache->time_shift = t;
+	} else {
+		// Custom rules may depend on anything, so never reuse these.
+		// Keep the evaluation order the same as it has always been, just in case.
+		samples[0] = l->prule(l, t);
+		cache->prev_sample = l->prule(l, t - sp->time_step);
+		t += sp->time_step;
+
+		for(uint i = 1; i < sp->num_samples; ++i, t += sp->time_step) {
+			samples[i] = l->prule(l, t);
+		}
+
+		cache->prule = NULL;
+	}
+
+	*out_prev = cache->prev_sample;
+	return samples;
+}
+
 static int quantize_laser(Laser *l) {
 	// Break the laser curve into small line segments, simplify and cull them,
 	// compute the bounding box.
 
 	l->_internal.segments_ofs = lintern.segments.num_elements;
 	l->_internal.num_segments = 0;
+	l->_internal.chunks_ofs = lintern.chunks.num_elements;
 
 	LaserSamplingParams sp;
 
@@ -195,10 +259,13 @@ static int quantize_laser(Laser *l) {
 	// Time value of last included sample
 	float t0 = t;
 
+	cmplx prev_sample;
+	const cmplxf *samples = laser_sample_curve(l, &sp, &prev_sample);
+
 	// Points of the current line segment
 	// Begin constructing at t0
 	cmplxf a, b;
-	a = l->prule(l, t0);
+	a = samples[0];
 
 	// Width value of the last included sample
 	// Initialized to the width at t0
@@ -208,7 +275,7 @@ static int quantize_laser(Laser *l) {
 	t += sp.time_step;
 
 	// Vector from A to B of the last included segment, and its squared length.
-	cmplxf v0 = a - l->prule(l, t0 - sp.time_step);
+	cmplxf v0 = a - prev_sample;
 	float v0_abs2 = cabs2f(v0);
 
 	float viewmargin = l->width * 0.5f;
@@ -222,8 +289,10 @@ static int quantize_laser(Laser *l) {
 	top_left.as_cmplx = a;
 	bottom_right.as_cmplx = a;
 
+	LaserChunk *chunk = NULL;
+
 	for(uint i = 1; i < sp.num_samples; ++i, t += sp.time_step) {
-		b = l->prule(l, t);
+		b = samples[i];
 
 		if(i < sp.num_samples - 1 && (t - t0) < thres_temporal) {
 			cmplxf v1 = b - a;
@@ -257,6 +326,14 @@ static int quantize_laser(Laser *l) {
 			(xb > viewbounds.x && xb < viewbounds.w && yb > viewbounds.y && yb < viewbounds.h);
 
 		if(visible) {
+			if((lintern.segments.num_elements - l->_internal.segments_ofs) % LASER_CHUNK_SIZE == 0) {
+				chunk = dynarray_append(&lintern.chunks);
+				*chunk = (LaserChunk) {
+					.top_left.as_cmplx = a,
+					.bottom_right.as_cmplx = a,
+				};
+			}
+
 			LaserSegment *seg = dynarray_append(&lintern.segments);
 
 			if(w < w0) {
@@ -281,6 +358,12 @@ static int quantize_laser(Laser *l) {
 			top_left.y     = fminf(    top_left.y, fminf(ya, yb));
 			bottom_right.x = fmaxf(bottom_right.x, fmaxf(xa, xb));
 			bottom_right.y = fmaxf(bottom_right.y, fmaxf(ya, yb));
+
+			chunk->top_left.x     = fminf(    chunk->top_left.x, fminf(xa, xb));
+			chunk->top_left.y     = fminf(    chunk->top_left.y, fminf(ya, yb));
+			chunk->bottom_right.x = fmaxf(chunk->bottom_right.x, fmaxf(xa, xb));
+			chunk->bottom_right.y = fmaxf(chunk->bottom_right.y, fmaxf(ya, yb));
+			chunk->max_width      = fmaxf(chunk->max_width, seg->width.b);
 		}
 
 		t0 = t;
@@ -309,10 +392,13 @@ static int quantize_laser(Laser *l) {
 static bool laser_collision(Laser *l, Player *plr);
 
 void process_lasers(void) {
+	PROF_ZONE("process_lasers");
+
 	bool stage_cleared = stage_is_cleared();
 	Player *plr = &global.plr;
 
 	lintern.segments.num_elements = 0;
+	lintern.chunks.num_elements = 0;
 
 	/*
 	 * NOTE: it's important to have two loops here, because something triggered from ent_damage()
@@ -384,6 +470,19 @@ static inline Rect laser_bbox_rect(Laser *l) {
 	};
 }
 
+static inline int laser_num_chunks(Laser *l) {
+	return (l->_internal.num_segments + LASER_CHUNK_SIZE - 1) / LASER_CHUNK_SIZE;
+}
+
+static inline Rect laser_chunk_rect(LaserChunk *chunk, double margin) {
+	cmplx m = margin * (1 + I);
+
+	return (Rect) {
+		chunk->top_left.as_cmplx - m,
+		chunk->bottom_right.as_cmplx + m
+	};
+}
+
 static bool laser_collision(Laser *l, Player *plr) {
 	if(!laser_is_active(l)) {
 		return false;
@@ -425,35 +524,64 @@ static bool laser_collision(Laser *l, Player *plr) {
 		plrmotion.b = plrpos;
 	}
 
-	for(int i = 0; i < num_segs; ++i) {
-		LaserSegment *lseg = segs + i;
-		LineSegment s = { lseg->pos.a, lseg->pos.b };
+	Rect plrbox = { plrpos, plrpos };
 
-		if(player_moved && lineseg_lineseg_intersection(plrmotion, s, NULL)) {
-			// Prevent phasing through laser beams
-			return true;
-		}
+	if(player_moved) {
+		plrbox.left   = fmin(creal(plrmotion.a), creal(plrmotion.b));
+		plrbox.top    = fmin(cimag(plrmotion.a), cimag(plrmotion.b));
+		plrbox.right  = fmax(creal(plrmotion.a), creal(plrmotion.b));
+		plrbox.bottom = fmax(cimag(plrmotion.a), cimag(plrmotion.b));
+	}
+
+	LaserChunk *chunks = dynarray_get_ptr(&lintern.chunks, l->_internal.chunks_ofs);
+	int num_chunks = laser_num_chunks(l);
 
-		UnevenCapsule c = {
-			.pos = s,
-			.radius.a = fmax(lseg->width.a * 0.5 - 4, 2),
-			.radius.b = fmax(lseg->width.b * 0.5 - 4, 2),
-		};
+	for(int ci = 0; ci < num_chunks; ++ci) {
+		LaserChunk *chunk = chunks + ci;
 
-		double d = ucapsule_dist_from_point(plrpos, c);
+		// Skip the chunk if none of its segments can hit the player, nor be closer than the
+		// current graze candidate. The extra unit of margin absorbs rounding errors.
+		double reach = fmax(chunk->max_width * 0.5 - 4, 2) + 1;
 
-		if(d < 0) {
-			return true;
+		if(graze) {
+			reach += graze_dist;
 		}
 
-		if(graze && d < graze_dist) {
-			double f = lineseg_closest_factor(c.pos, plrpos);
-			graze_pos = clerp(c.pos.a, c.pos.b, f);
-			cmplx v = cnormalize(plrpos - graze_pos);
-			graze_pos += 0.5 * clerp(lseg->width.a, lseg->width.b, f) * v;
-			graze_dist = d;
+		if(!rect_rect_intersect(plrbox, laser_chunk_rect(chunk, reach), true, true)) {
+			continue;
 		}
 
+		int segs_end = imin((ci + 1) * LASER_CHUNK_SIZE, num_segs);
+
+		for(int i = ci * LASER_CHUNK_SIZE; i < segs_end; ++i) {
+			LaserSegment *lseg = segs + i;
+			LineSegment s = { lseg->pos.a, lseg->pos.b };
+
+			if(player_moved && lineseg_lineseg_intersection(plrmotion, s, NULL)) {
+				// Prevent phasing through laser beams
+				return true;
+			}
+
+			UnevenCapsule c = {
+				.pos = s,
+				.radius.a = fmax(lseg->width.a * 0.5 - 4, 2),
+				.radius.b = fmax(lseg->width.b * 0.5 - 4, 2),
+			};
+
+			double d = ucapsule_dist_from_point(plrpos, c);
+
+			if(d < 0) {
+				return true;
+			}
+
+			if(graze && d < graze_dist) {
+				double f = lineseg_closest_factor(c.pos, plrpos);
+				graze_pos = clerp(c.pos.a, c.pos.b, f);
+				cmplx v = cnormalize(plrpos - graze_pos);
+				graze_pos += 0.5 * clerp(lseg->width.a, lseg->width.b, f) * v;
+				graze_dist = d;
+			}
+		}
 	}
 
 	if(graze_dist < graze_maxdist) {
@@ -484,13 +612,23 @@ bool laser_intersects_ellipse(Laser *l, Ellipse ellipse) {
 	}
 
 	LaserSegment *segs = dynarray_get_ptr(&lintern.segments, l->_internal.segments_ofs);
+	LaserChunk *chunks = dynarray_get_ptr(&lintern.chunks, l->_internal.chunks_ofs);
+	int num_chunks = laser_num_chunks(l);
+
+	for(int ci = 0; ci < num_chunks; ++ci) {
+		if(!rect_rect_intersect(e_bbox, laser_chunk_rect(chunks + ci, 1), true, true)) {
+			continue;
+		}
 
-	for(int i = 0; i < num_segs; ++i) {
-		LaserSegment *lseg = segs + i;
-		LineSegment s = { lseg->pos.a, lseg->pos.b };
+		int segs_end = imin((ci + 1) * LASER_CHUNK_SIZE, num_segs);
 
-		if(lineseg_ellipse_intersect(s, ellipse)) {
-			return true;
+		for(int i = ci * LASER_CHUNK_SIZE; i < segs_end; ++i) {
+			LaserSegment *lseg = segs + i;
+			LineSegment s = { lseg->pos.a, lseg->pos.b };
+
+			if(lineseg_ellipse_intersect(s, ellipse)) {
+				return true;
+			}
 		}
 	}
 
@@ -506,6 +644,41 @@ bool laser_intersects_circle(Laser *l, Circle circle) {
 	return laser_intersects_ellipse(l, ellipse);
 }
 
+/*
+ * The parts of the curvier rules that don't depend on t are split out, so that the batched
+ * versions below can compute them once per laser. Both versions go through the same code, so the
+ * results are exactly the same.
+ */
+
+INLINE cmplx las_weird_sine_eval(cmplx pos, const cmplx args[4], double angle, double speed, float t) {
+	double s = (args[2] * t + args[3]);
+	return pos + cexp(I * (angle + args[1] * sin(s) / s)) * t * speed;
+}
+
+INLINE cmplx las_sine_normal(cmplx line_vel) {
+	cmplx line_dir = line_vel / cabs(line_vel);
+	return cimag(line_dir) - I*creal(line_dir);
+}
+
+INLINE cmplx las_sine_eval(cmplx pos, const cmplx args[4], cmplx line_normal, float t) {
+	cmplx line_vel = args[0];
+	cmplx sine_amp = args[1];
+	cmplx sine_freq = args[2];
+	cmplx sine_phase = args[3];
+
+	cmplx sine_ofs = line_normal * sine_amp * sin(sine_freq * t + sine_phase);
+	return pos + t * line_vel + sine_ofs;
+}
+
+INLINE cmplx las_sine_expanding_eval(cmplx pos, const cmplx args[4], double angle, double speed, float t) {
+	double amplitude = creal(args[1]);
+	double frequency = creal(args[2]);
+	double phase = creal(args[3]);
+
+	double s = (frequency * t + phase);
+	return pos + cexp(I * (angle + amplitude * sin(s))) * t * speed;
+}
+
 cmplx las_linear(Laser *l, float t) {
 	if(t == EVENT_BIRTH) {
 		return 0;
@@ -530,8 +703,7 @@ cmplx las_weird_sine(Laser *l, float t) {             // [0] = velocity; [1] = s
 		return 0;
 	}
 
-	double s = (l->args[2] * t + l->args[3]);
-	return l->pos + cexp(I * (carg(l->args[0]) + l->args[1] * sin(s) / s)) * t * cabs(l->args[0]);
+	return las_weird_sine_eval(l->pos, l->args, carg(l->args[0]), cabs(l->args[0]), t);
 }
 
 cmplx las_sine(Laser *l, float t) {               // [0] = velocity; [1] = sine amplitude; [2] = sine frequency; [3] = sine phase
@@ -541,15 +713,7 @@ cmplx las_sine(Laser *l, float t) {               // [0] = velocity; [1] = sine
 		return 0;
 	}
 
-	cmplx line_vel = l->args[0];
-	cmplx line_dir = line_vel / cabs(line_vel);
-	cmplx line_normal = cimag(line_dir) - I*creal(line_dir);
-	cmplx sine_amp = l->args[1];
-	cmplx sine_freq = l->args[2];
-	cmplx sine_phase = l->args[3];
-
-	cmplx sine_ofs = line_normal * sine_amp * sin(sine_freq * t + sine_phase);
-	return l->pos + t * line_vel + sine_ofs;
+	return las_sine_eval(l->pos, l->args, las_sine_normal(l->args[0]), t);
 }
 
 cmplx las_sine_expanding(Laser *l, float t) { // [0] = velocity; [1] = sine amplitude; [2] = sine frequency; [3] = sine phase
@@ -559,16 +723,7 @@ cmplx las_sine_expanding(Laser *l, float t) { // [0] = velocity; [1] = sine ampl
 		return 0;
 	}
 
-	cmplx velocity = l->args[0];
-	double amplitude = creal(l->args[1]);
-	double frequency = creal(l->args[2]);
-	double phase = creal(l->args[3]);
-
-	double angle = carg(velocity);
-	double speed = cabs(velocity);
-
-	double s = (frequency * t + phase);
-	return l->pos + cexp(I * (angle + amplitude * sin(s))) * t * speed;
+	return las_sine_expanding_eval(l->pos, l->args, carg(l->args[0]), cabs(l->args[0]), t);
 }
 
 cmplx las_turning(Laser *l, float t) { // [0] = vel0; [1] = vel1; [2] r: turn begin time, i: turn end time
@@ -603,6 +758,63 @@ cmplx las_circle(Laser *l, float t) {
 	return l->pos + radius * cexp(I * (t + time_ofs) * turn_speed);
 }
 
+/*
+ * Batched versions of the built-in rules, used by laser_sample_curve().
+ * These write [num] samples starting at time [t], spaced [step] apart.
+ */
+
+#define LASER_BATCH_RULE(rule) \
+	static void rule##_batch(Laser *l, float t, float step, uint num, cmplxf out[num]) { \
+		for(uint i = 0; i < num; ++i, t += step) { \
+			out[i] = rule(l, t); \
+		} \
+	}
+
+LASER_BATCH_RULE(las_linear)
+LASER_BATCH_RULE(las_accel)
+LASER_BATCH_RULE(las_turning)
+LASER_BATCH_RULE(las_circle)
+
+static void las_weird_sine_batch(Laser *l, float t, float step, uint num, cmplxf out[num]) {
+	double angle = carg(l->args[0]);
+	double speed = cabs(l->args[0]);
+
+	for(uint i = 0; i < num; ++i, t += step) {
+		out[i] = las_weird_sine_eval(l->pos, l->args, angle, speed, t);
+	}
+}
+
+static void las_sine_batch(Laser *l, float t, float step, uint num, cmplxf out[num]) {
+	cmplx line_normal = las_sine_normal(l->args[0]);
+
+	for(uint i = 0; i < num; ++i, t += step) {
+		out[i] = las_sine_eval(l->pos, l->args, line_normal, t);
+	}
+}
+
+static void las_sine_expanding_batch(Laser *l, float t, float step, uint num, cmplxf out[num]) {
+	double angle = carg(l->args[0]);
+	double speed = cabs(l->args[0]);
+
+	for(uint i = 0; i < num; ++i, t += step) {
+		out[i] = las_sine_expanding_eval(l->pos, l->args, angle, speed, t);
+	}
+}
+
+static LaserBatchPosRule laser_get_batch_rule(LaserPosRule prule) {
+	#define CHECK_RULE(rule) if(prule == rule) return rule##_batch;
+	CHECK_RULE(las_linear)
+	CHECK_RULE(las_accel)
+	CHECK_RULE(las_weird_sine)
+	CHECK_RULE(las_sine)
+	CHECK_RULE(las_sine_expanding)
+	CHECK_RULE(las_turning)
+	CHECK_RULE(las_circle)
+	#undef CHECK_RULE
+
+	return NULL;
+}
+
 void laser_charge(Laser *l, int t, float charge, float width) {
 	float new_width;
 
@@ -11,6 +11,7 @@
 
 #include "draw.h"
 
+#include "dynarray.h"
 #include "util.h"
 #include "projectile.h"
 #include "resource/shader_program.h"
@@ -35,9 +36,21 @@ DEFINE_ENTITY_TYPE(Laser, {
 		LaserRenderData renderdata;
 		int segments_ofs;
 		int num_segments;
+		int chunks_ofs;
 		struct {
 			FloatOffset top_left, bottom_right;
 		} bbox;
+
+		// Raw curve samples from the last quantization, and the inputs they were computed from.
+		// Reused as long as those stay the same and prule is one of the built-in rules.
+		struct {
+			DYNAMIC_ARRAY(cmplxf) samples;
+			cmplx prev_sample;
+			cmplx pos;
+			cmplx args[4];
+			LaserPosRule prule;
+			float time_shift;
+		} sample_cache;
 	} _internal;
 
 	Color color;
@@ -24,11 +24,48 @@ typedef struct Logger {
 	uint levels;
 } Logger;
 
-typedef struct QueuedLogEntry {
-	LIST_INTERFACE(struct QueuedLogEntry);
+/*
+ * With the async queue enabled, every thread formats its messages into a private buffer and
+ * pushes them into its own single-producer, single-consumer ring. The log thread sleeps until
+ * a message is pushed into an empty ring, then keeps draining all rings at least every
+ * LOG_FLUSH_INTERVAL_MS until they are empty again. Threads only take a lock when their ring is
+ * full, or to wake the log thread up (from an empty queue, for alerts, or when half full).
+ *
+ * The rings are merged by a global sequence number. That ordering is best-effort: a thread
+ * can be preempted between taking its number and publishing the record, and a message with a
+ * later number from another thread may be written out first in the meantime.
+ *
+ * Every thread that logs pins a LogRing (LOG_RING_SIZE bytes, plus its format buffer) until it
+ * exits. Rings of exited threads are freed by the log thread once drained.
+ *
+ * Messages have to be formatted by the caller: the arguments may point to temporary strings.
+ */
+
+#define LOG_RING_SIZE (1 << 16)
+#define LOG_RING_MASK (LOG_RING_SIZE - 1)
+#define LOG_FLUSH_INTERVAL_MS 10
+
+typedef struct LogRecord {
+	uint32_t size;  // of the whole record, including padding
+	uint32_t seq;
+	char *heap_message;  // for messages too large to be stored inline
 	LogEntry e;
 	char message[];
-} QueuedLogEntry;
+} LogRecord;
+
+#define LOG_RECORD_ALIGN alignof(LogRecord)
+// Marks unused space at the end of the ring; the size is stored in the low bits.
+#define LOG_RECORD_SKIP_BIT 0x80000000u
+#define LOG_RECORD_MAX_INLINE_SIZE (LOG_RING_SIZE / 8)
+
+typedef struct LogRing {
+	LIST_INTERFACE(struct LogRing);
+	SDL_atomic_t head;  // written by the owning thread only (under logging.mutex for the shared ring)
+	SDL_atomic_t tail;  // written by the log thread only
+	SDL_atomic_t refs;  // one for the owning thread, one for the queue
+	StringBuffer format_buf;  // used by the owning thread only
+	alignas(LOG_RECORD_ALIGN) uint8_t data[LOG_RING_SIZE];
+} LogRing;
 
 typedef struct LogFilterEntry {
 	struct {
@@ -51,9 +88,17 @@ static struct {
 
 	struct {
 		SDL_Thread *thread;
+		SDL_threadID thread_id;
 		SDL_mutex *mutex;
-		SDL_cond *cond;
-		LIST_ANCHOR(QueuedLogEntry) queue;
+		SDL_cond *cond;  // wakes the log thread up
+		SDL_cond *drained;  // signaled by the log thread after every flush
+		SDL_TLSID tls;
+		LIST_ANCHOR(LogRing) rings;
+		LogRing *shared_ring;  // for threads that couldn't set up their own; see log_ring_get_shared_locked
+		DYNAMIC_ARRAY(LogRing*) drain_list;  // used by the log thread only
+		SDL_atomic_t seq;
+		SDL_atomic_t wake_pending;
+		SDL_atomic_t num_dropped;
 		int shutdown;
 	} queue;
 
@@ -254,20 +299,261 @@ static void log_dispatch(LogEntry *entry) {
 	}
 }
 
-static void log_dispatch_async(LogEntry *entry) {
-	for(Logger *l = logging.outputs; l; l = l->next) {
-		if(l->levels & entry->level) {
-			size_t msg_len = strlen(entry->message);
-			auto qle = ALLOC_FLEX(QueuedLogEntry, msg_len + 1);
-			memcpy(&qle->e, entry, sizeof(*entry));
-			memcpy(qle->message, entry->message, msg_len);
-			qle->e.message = qle->message;
-			SDL_LockMutex(logging.queue.mutex);
-			alist_append(&logging.queue.queue, qle);
-			SDL_CondBroadcast(logging.queue.cond);
-			SDL_UnlockMutex(logging.queue.mutex);
+static void log_ring_release(LogRing *ring) {
+	if(SDL_AtomicDecRef(&ring->refs)) {
+		strbuf_free(&ring->format_buf);
+		mem_free(ring);
+	}
+}
+
+static void log_ring_thread_exit(void *ring) {
+	log_ring_release(ring);
+}
+
+static LogRing *log_ring_get(void) {
+	LogRing *ring = SDL_TLSGet(logging.queue.tls);
+
+	if(LIKELY(ring)) {
+		return ring;
+	}
+
+	ring = ALLOC(LogRing);
+	SDL_AtomicSet(&ring->refs, 2);
+
+	if(SDL_TLSSet(logging.queue.tls, ring, log_ring_thread_exit) < 0) {
+		mem_free(ring);
+		return NULL;
+	}
+
+	SDL_LockMutex(logging.queue.mutex);
+	alist_append(&logging.queue.rings, ring);
+	SDL_UnlockMutex(logging.queue.mutex);
+
+	return ring;
+}
+
+// Fallback for threads that couldn't get a ring of their own (e.g. TLS failure). Those may not
+// dispatch entries themselves while the log thread is running, so they share a ring instead.
+// Must be called with logging.mutex held, which also serializes all pushes into this ring.
+static LogRing *log_ring_get_shared_locked(void) {
+	LogRing *ring = logging.queue.shared_ring;
+
+	if(ring) {
+		return ring;
+	}
+
+	ring = ALLOC(LogRing);
+	// One reference for the queue, one kept until log_queue_shutdown()
+	SDL_AtomicSet(&ring->refs, 2);
+
+	SDL_LockMutex(logging.queue.mutex);
+	alist_append(&logging.queue.rings, ring);
+	SDL_UnlockMutex(logging.queue.mutex);
+
+	return logging.queue.shared_ring = ring;
+}
+
+INLINE uint32_t log_record_size(size_t message_size) {
+	return (sizeof(LogRecord) + message_size + LOG_RECORD_ALIGN - 1) & ~(LOG_RECORD_ALIGN - 1);
+}
+
+static void log_queue_wake(void) {
+	if(SDL_AtomicCAS(&logging.queue.wake_pending, 0, 1)) {
+		SDL_LockMutex(logging.queue.mutex);
+		SDL_CondSignal(logging.queue.cond);
+		SDL_UnlockMutex(logging.queue.mutex);
+	}
+}
+
+static bool log_ring_wait_space(LogRing *ring, uint32_t head, uint32_t size) {
+	for(;;) {
+		uint32_t tail = SDL_AtomicGet(&ring->tail);
+
+		if(LOG_RING_SIZE - (head - tail) >= size) {
+			return true;
+		}
+
+		if(SDL_ThreadID() == logging.queue.thread_id || logging.queue.shutdown) {
+			// The log thread can't wait for itself
+			return false;
+		}
+
+		SDL_LockMutex(logging.queue.mutex);
+		SDL_CondSignal(logging.queue.cond);
+		SDL_CondWaitTimeout(logging.queue.drained, logging.queue.mutex, LOG_FLUSH_INTERVAL_MS);
+		SDL_UnlockMutex(logging.queue.mutex);
+	}
+}
+
+static void log_ring_push(LogRing *ring, const LogEntry *entry, size_t message_len) {
+	uint32_t size = log_record_size(message_len + 1);
+	bool store_inline = size <= LOG_RECORD_MAX_INLINE_SIZE;
+
+	if(!store_inline) {
+		size = log_record_size(0);
+	}
+
+	uint32_t start = SDL_AtomicGet(&ring->head);
+	uint32_t head = start;
+	uint32_t ofs = head & LOG_RING_MASK;
+	uint32_t skip = LOG_RING_SIZE - ofs;
+
+	if(skip >= size) {
+		skip = 0;
+	}
+
+	if(!log_ring_wait_space(ring, head, skip + size)) {
+		SDL_AtomicIncRef(&logging.queue.num_dropped);
+		return;
+	}
+
+	if(skip) {
+		// Records are never split; pad out the end of the ring instead.
+		*CASTPTR_ASSUME_ALIGNED(ring->data + ofs, uint32_t) = skip | LOG_RECORD_SKIP_BIT;
+		head += skip;
+		ofs = 0;
+	}
+
+	LogRecord *rec = CASTPTR_ASSUME_ALIGNED(ring->data + ofs, LogRecord);
+	rec->size = size;
+	rec->seq = SDL_AtomicIncRef(&logging.queue.seq);
+	rec->e = *entry;
+
+	if(store_inline) {
+		memcpy(rec->message, entry->message, message_len + 1);
+		rec->heap_message = NULL;
+	} else {
+		rec->heap_message = memdup(entry->message, message_len + 1);
+	}
+
+	SDL_MemoryBarrierRelease();
+	SDL_AtomicSet(&ring->head, head + size);
+
+	// The tail must be read after publishing the head: either we see that the log thread has
+	// consumed everything before this record and wake it, or it sees this record.
+	uint32_t tail = SDL_AtomicGet(&ring->tail);
+
+	if(tail == start || (entry->level & LOG_ALERT) || head + size - tail > LOG_RING_SIZE / 2) {
+		log_queue_wake();
+	}
+}
+
+static void log_enqueue(LogRing *ring, LogEntry *entry, const char *fmt, va_list args) {
+	StringBuffer *buf = &ring->format_buf;
+	strbuf_clear(buf);
+
+	va_list args_copy;
+	va_copy(args_copy, args);
+	attr_unused int slen = strbuf_vprintf(buf, fmt, args_copy);
+	va_end(args_copy);
+	assert_nolog(slen >= 0);
+
+	entry->message = buf->start;
+	log_ring_push(ring, entry, buf->pos - buf->start);
+}
+
+static LogRecord *log_ring_peek(LogRing *ring, uint32_t *tail) {
+	uint32_t head = SDL_AtomicGet(&ring->head);
+	SDL_MemoryBarrierAcquire();
+
+	while(*tail != head) {
+		uint8_t *p = ring->data + (*tail & LOG_RING_MASK);
+		uint32_t size = *CASTPTR_ASSUME_ALIGNED(p, uint32_t);
+
+		if(size & LOG_RECORD_SKIP_BIT) {
+			*tail += size & ~LOG_RECORD_SKIP_BIT;
+			continue;
+		}
+
+		return CASTPTR_ASSUME_ALIGNED(p, LogRecord);
+	}
+
+	return NULL;
+}
+
+static void log_queue_drain(void) {
+	auto rings = &logging.queue.drain_list;
+	rings->num_elements = 0;
+
+	SDL_LockMutex(logging.queue.mutex);
+
+	for(LogRing *r = logging.queue.rings.first; r; r = r->next) {
+		*dynarray_append(rings) = r;
+	}
+
+	SDL_UnlockMutex(logging.queue.mutex);
+
+	uint num_rings = rings->num_elements;
+
+	if(!num_rings) {
+		return;
+	}
+
+	uint32_t tails[num_rings];
+	LogRecord *fronts[num_rings];
+
+	for(uint i = 0; i < num_rings; ++i) {
+		LogRing *r = dynarray_get(rings, i);
+		tails[i] = SDL_AtomicGet(&r->tail);
+		fronts[i] = log_ring_peek(r, tails + i);
+	}
+
+	// Merge the rings by sequence number, to preserve the order of messages across threads.
+	for(;;) {
+		int next = -1;
+
+		for(uint i = 0; i < num_rings; ++i) {
+			if(fronts[i] && (next < 0 || (int32_t)(fronts[i]->seq - fronts[next]->seq) < 0)) {
+				next = i;
+			}
+		}
+
+		if(next < 0) {
 			break;
 		}
+
+		LogRing *r = dynarray_get(rings, next);
+		LogRecord *rec = fronts[next];
+
+		rec->e.message = rec->heap_message ? rec->heap_message : rec->message;
+		log_dispatch(&rec->e);
+		mem_free(rec->heap_message);
+
+		tails[next] += rec->size;
+
+		// Don't let the producer reuse the record before we're done reading it.
+		SDL_MemoryBarrierRelease();
+		SDL_AtomicSet(&r->tail, tails[next]);
+		fronts[next] = log_ring_peek(r, tails + next);
+	}
+
+	// Account for padding skipped at the end
+	SDL_MemoryBarrierRelease();
+
+	for(uint i = 0; i < num_rings; ++i) {
+		SDL_AtomicSet(&dynarray_get(rings, i)->tail, tails[i]);
+	}
+}
+
+static bool log_queue_empty_locked(void) {
+	for(LogRing *r = logging.queue.rings.first; r; r = r->next) {
+		if(SDL_AtomicGet(&r->head) != SDL_AtomicGet(&r->tail)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void log_queue_free_orphaned_rings_locked(void) {
+	for(LogRing *r = logging.queue.rings.first, *next; r; r = next) {
+		next = r->next;
+
+		// Only the queue's reference is left, so the owning thread has exited.
+		if(SDL_AtomicGet(&r->refs) == 1 && SDL_AtomicGet(&r->head) == SDL_AtomicGet(&r->tail)) {
+			alist_unlink(&logging.queue.rings, r);
+			log_ring_release(r);
+		}
 	}
 }
 
@@ -287,8 +573,31 @@ static void log_internal(LogLevel lvl, const char *funcname, const char *filenam
 		return;
 	}
 
+	LogEntry entry = {
+		.file = filename,
+		.func = funcname,
+		.line = line,
+		.level = lvl,
+		.time = SDL_GetTicks(),
+	};
+
+	LogRing *ring = NULL;
+
+	if(logging.queue.thread && (ring = log_ring_get())) {
+		if(!(lvl & LOG_FATAL)) {
+			log_enqueue(ring, &entry, fmt, args);
+			return;
+		}
+	}
+
+	// Fatal errors take the slow path even with the queue enabled, because they shut the logger down.
 	SDL_LockMutex(logging.mutex);
 
+	if(logging.queue.thread && !ring) {
+		// Dispatching from here would race with the log thread.
+		ring = log_ring_get_shared_locked();
+	}
+
 	StringBuffer *buf = &logging.buffers.pre_format;
 	strbuf_clear(buf);
 
@@ -302,17 +611,10 @@ static void log_internal(LogLevel lvl, const char *funcname, const char *filenam
 		add_debug_info(buf);
 	}
 
-	LogEntry entry = {
-		.message = buf->start,
-		.file = filename,
-		.func = funcname,
-		.line = line,
-		.level = lvl,
-		.time = SDL_GetTicks(),
-	};
+	entry.message = buf->start;
 
-	if(logging.queue.thread) {
-		log_dispatch_async(&entry);
+	if(ring) {
+		log_ring_push(ring, &entry, buf->pos - buf->start);
 	} else {
 		log_dispatch(&entry);
 	}
@@ -320,6 +622,7 @@ static void log_internal(LogLevel lvl, const char *funcname, const char *filenam
 	if(lvl & LOG_FATAL) {
 		if(noabort) {
 			// Will likely abort externally (e.g. assertion failure), so sync everything now.
+			log_sync();
 			list_foreach(&logging.outputs, sync_logger, NULL);
 		} else {
 			log_abort(entry.message);
@@ -363,29 +666,44 @@ static void *delete_logger(List **loggers, List *logger, void *arg) {
 
 static int log_queue_thread(void *a) {
 	SDL_mutex *mtx = logging.queue.mutex;
-	SDL_cond *cond = logging.queue.cond;
-
-	SDL_LockMutex(mtx);
 
 	for(;;) {
-		SDL_CondWait(cond, mtx);
-		QueuedLogEntry *qle;
-
-		while((qle = alist_pop(&logging.queue.queue)) && logging.queue.shutdown < 2) {
-			SDL_UnlockMutex(mtx);
-			log_dispatch(&qle->e);
-			mem_free(qle);
-			SDL_LockMutex(mtx);
+		SDL_LockMutex(mtx);
+
+		if(!logging.queue.shutdown) {
+			if(log_queue_empty_locked()) {
+				// Producers wake us when they push into an empty ring, so don't poll.
+				SDL_CondWait(logging.queue.cond, mtx);
+			} else {
+				SDL_CondWaitTimeout(logging.queue.cond, mtx, LOG_FLUSH_INTERVAL_MS);
+			}
 		}
 
-		SDL_CondBroadcast(cond);
+		int shutdown = logging.queue.shutdown;
+		SDL_UnlockMutex(mtx);
+
+		SDL_AtomicSet(&logging.queue.wake_pending, 0);
+
+		if(shutdown < 2) {
+			log_queue_drain();
+		}
 
-		if(logging.queue.shutdown) {
+		int num_dropped = SDL_AtomicSet(&logging.queue.num_dropped, 0);
+
+		if(num_dropped) {
+			log_warn("%i messages logged from the log thread were dropped", num_dropped);
+		}
+
+		SDL_LockMutex(mtx);
+		log_queue_free_orphaned_rings_locked();
+		SDL_CondBroadcast(logging.queue.drained);
+		SDL_UnlockMutex(mtx);
+
+		if(shutdown) {
 			break;
 		}
 	}
 
-	SDL_UnlockMutex(mtx);
 	return 0;
 }
 
@@ -394,20 +712,34 @@ static void log_queue_init(void) {
 		return;
 	}
 
+	if(!(logging.queue.tls = SDL_TLSCreate())) {
+		log_sdl_error(LOG_ERROR, "SDL_TLSCreate");
+		return;
+	}
+
 	if(!(logging.queue.cond = SDL_CreateCond())) {
 		log_sdl_error(LOG_ERROR, "SDL_CreateCond");
 		return;
 	}
 
+	if(!(logging.queue.drained = SDL_CreateCond())) {
+		log_sdl_error(LOG_ERROR, "SDL_CreateCond");
+		return;
+	}
+
 	if(!(logging.queue.mutex = SDL_CreateMutex())) {
 		log_sdl_error(LOG_ERROR, "SDL_CreateMutex");
 		return;
 	}
 
+	logging.queue.shutdown = 0;
+
 	if(!(logging.queue.thread = SDL_CreateThread(log_queue_thread, "Log queue", NULL))) {
 		log_sdl_error(LOG_ERROR, "SDL_CreateThread");
 		return;
 	}
+
+	logging.queue.thread_id = SDL_GetThreadID(logging.queue.thread);
 }
 
 static void log_queue_shutdown(bool force_sync) {
@@ -421,10 +753,34 @@ static void log_queue_shutdown(bool force_sync) {
 	SDL_UnlockMutex(logging.queue.mutex);
 	SDL_WaitThread(logging.queue.thread, NULL);
 	logging.queue.thread = NULL;
+	logging.queue.thread_id = 0;
+
+	// The calling thread's destructor won't run in time, so release its ring explicitly.
+	LogRing *own_ring = SDL_TLSGet(logging.queue.tls);
+
+	if(own_ring) {
+		SDL_TLSSet(logging.queue.tls, NULL, NULL);
+		log_ring_release(own_ring);
+	}
+
+	if(logging.queue.shared_ring) {
+		log_ring_release(logging.queue.shared_ring);
+		logging.queue.shared_ring = NULL;
+	}
+
+	// Rings of threads that are still alive are freed when those threads exit.
+	for(LogRing *r; (r = logging.queue.rings.first);) {
+		alist_unlink(&logging.queue.rings, r);
+		log_ring_release(r);
+	}
+
+	dynarray_free_data(&logging.queue.drain_list);
 	SDL_DestroyMutex(logging.queue.mutex);
 	logging.queue.mutex = NULL;
 	SDL_DestroyCond(logging.queue.cond);
 	logging.queue.cond = NULL;
+	SDL_DestroyCond(logging.queue.drained);
+	logging.queue.drained = NULL;
 }
 
 void log_init(LogLevel lvls) {
@@ -453,10 +809,17 @@ void log_shutdown(void) {
 }
 
 void log_sync(void) {
+	if(!logging.queue.thread || SDL_ThreadID() == logging.queue.thread_id) {
+		return;
+	}
+
 	SDL_LockMutex(logging.queue.mutex);
- 	while(logging.queue.queue.first) {
-		SDL_CondWait(logging.queue.cond, logging.queue.mutex);
+
+	while(!log_queue_empty_locked()) {
+		SDL_CondSignal(logging.queue.cond);
+		SDL_CondWaitTimeout(logging.queue.drained, logging.queue.mutex, LOG_FLUSH_INTERVAL_MS);
 	}
+
 	SDL_UnlockMutex(logging.queue.mutex);
 }
 
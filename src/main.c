@@ -30,14 +30,16 @@
 #include "util/gamemode.h"
 #include "cutscenes/cutscene.h"
 #include "replay/struct.h"
+#include "replay/bench.h"
 #include "filewatch/filewatch.h"
 #include "dynstage.h"
+#include "profiler.h"
 
 attr_unused
 static void taisei_shutdown(void) {
 	log_info("Shutting down");
 
-	if(!global.is_replay_verification) {
+	if(!global.is_headless) {
 		config_save();
 		progress_save();
 	}
@@ -56,6 +58,7 @@ static void taisei_shutdown(void) {
 	filewatch_shutdown();
 	vfs_shutdown();
 	events_shutdown();
+	prof_shutdown();
 	time_shutdown();
 	coroutines_shutdown();
 
@@ -219,6 +222,7 @@ typedef struct MainContext {
 	Replay *replay_in;
 	Replay *replay_out;
 	SDL_RWops *replay_out_stream;
+	SDL_RWops *bench_out_stream;
 	int replay_idx;
 	uchar headless : 1;
 } MainContext;
@@ -241,6 +245,20 @@ static Replay *alloc_replay(void) {
 	return ALLOC(Replay);
 }
 
+static SDL_RWops *open_bench_output(const char *path) {
+	if(!path) {
+		return SDL_RWFromFP(stdout, false);
+	}
+
+	SDL_RWops *out = SDL_RWFromFile(path, "w");
+
+	if(!out) {
+		log_sdl_error(LOG_FATAL, "SDL_RWFromFile");
+	}
+
+	return out;
+}
+
 static noreturn void main_quit(MainContext *ctx, int status) {
 	free_cli_action(&ctx->cli);
 
@@ -263,6 +281,13 @@ static noreturn void main_quit(MainContext *ctx, int status) {
 
 	cleanup_replay(&ctx->replay_out);
 
+	if(ctx->bench_out_stream) {
+		replay_bench_write_report(ctx->bench_out_stream);
+		SDL_RWclose(ctx->bench_out_stream);
+		ctx->bench_out_stream = NULL;
+		replay_bench_shutdown();
+	}
+
 	mem_free(ctx);
 	exit(status);
 }
@@ -303,7 +328,11 @@ int main(int argc, char **argv) {
 		main_quit(ctx, 0);
 	}
 
-	if(ctx->cli.type == CLI_PlayReplay || ctx->cli.type == CLI_VerifyReplay) {
+	if(
+		ctx->cli.type == CLI_PlayReplay ||
+		ctx->cli.type == CLI_VerifyReplay ||
+		ctx->cli.type == CLI_BenchReplay
+	) {
 		ctx->replay_in = alloc_replay();
 
 		if(!replay_load_syspath(ctx->replay_in, ctx->cli.filename, REPLAY_READ_ALL)) {
@@ -320,6 +349,12 @@ int main(int argc, char **argv) {
 			ctx->headless = true;
 		}
 
+		if(ctx->cli.type == CLI_BenchReplay) {
+			ctx->headless = true;
+			ctx->bench_out_stream = open_bench_output(ctx->cli.bench_output);
+			replay_bench_init();
+		}
+
 		if(ctx->cli.out_replay != NULL) {
 			ctx->replay_out_stream = SDL_RWFromFile(ctx->cli.out_replay, "wb");
 
@@ -369,6 +404,7 @@ static void main_post_vfsinit(CallChainResult ccr) {
 	taskmgr_global_init();
 	gamemode_init();
 	time_init();
+	prof_init();
 	init_global(&ctx->cli);
 	events_init();
 	video_init();
@@ -392,7 +428,11 @@ static void main_post_vfsinit(CallChainResult ccr) {
 	atexit(taisei_shutdown);
 #endif
 
-	if(ctx->cli.type == CLI_PlayReplay || ctx->cli.type == CLI_VerifyReplay) {
+	if(
+		ctx->cli.type == CLI_PlayReplay ||
+		ctx->cli.type == CLI_VerifyReplay ||
+		ctx->cli.type == CLI_BenchReplay
+	) {
 		main_replay(ctx);
 		return;
 	}
@@ -1443,7 +1443,7 @@ static bool options_text_input_handler(SDL_Event *event, void *arg) {
 		}
 
 		mem_free(text_allocated);
-		play_sfx_ui(snd);
+		(play_sfx_ui)(snd);
 		return true;
 	}
 
@@ -11,6 +11,18 @@
 #include "move.h"
 #include "util/miscmath.h"
 
+static cmplx move_attraction_delta(cmplx pos, const MoveParams *p) {
+	cmplx av = p->attraction_point - pos;
+
+	// NOTE: pow(x, 1) == x exactly, so the result is bit-identical to the general case.
+	// Must stay that way, or replays will desync.
+	if(p->attraction_exponent == 1) {
+		return p->attraction * cnormalize(av) * cabs(av);
+	}
+
+	return p->attraction * cnormalize(av) * pow(cabs(av), p->attraction_exponent);
+}
+
 cmplx move_update(cmplx *restrict pos, MoveParams *restrict p) {
 	cmplx v = p->velocity;
 
@@ -18,9 +30,7 @@ cmplx move_update(cmplx *restrict pos, MoveParams *restrict p) {
 	p->velocity = p->acceleration + p->retention * v;
 
 	if(p->attraction) {
-		cmplx av = p->attraction_point - *pos;
-
-		p->velocity += p->attraction * cnormalize(av) * pow(cabs(av), p->attraction_exponent);
+		p->velocity += move_attraction_delta(*pos, p);
 	}
 
 	return v;
@@ -12,10 +12,36 @@
 #include "util.h"
 #include "list.h"
 
+#if defined(TAISEI_BUILDCONF_HAVE_POSIX) && !defined(__EMSCRIPTEN__)
+	#include <sys/mman.h>
+	#include <errno.h>
+
+	#if defined(MAP_ANONYMOUS) && defined(MADV_HUGEPAGE)
+		#define OBJPOOL_HUGEPAGES
+	#endif
+#endif
+
+// Slabs at least this large are mapped directly and marked for transparent huge pages.
+#define OBJPOOL_HUGEPAGE_SIZE ((size_t)2 << 20)
+
+// Every slab is twice as large as the previous one, so this is effectively unlimited.
+#define OBJPOOL_MAX_SLABS 24
+
 typedef struct ObjHeader {
 	alignas(alignof(max_align_t)) struct ObjHeader *next;
 } ObjHeader;
 
+typedef struct ObjSlab {
+	char *objects;
+	size_t capacity;
+	size_t alloc_size;
+	// Objects at index >= num_touched have never been handed out, and are still zeroed.
+	size_t num_touched;
+	size_t usage;
+	ObjHeader *free_objects;
+	bool mapped;
+} ObjSlab;
+
 struct ObjectPool {
 	char *tag;
 	size_t size_of_object;
@@ -24,9 +50,10 @@ struct ObjectPool {
 	size_t usage;
 	size_t peak_usage;
 #endif
-	size_t num_extents;
-	char **extents;
-	ObjHeader *free_objects;
+	// All slabs before this one are full.
+	uint first_free_slab;
+	uint num_slabs;
+	ObjSlab slabs[OBJPOOL_MAX_SLABS];
 	char objects[];
 };
 
@@ -35,14 +62,6 @@ ObjHeader *obj_ptr(ObjectPool *pool, char *objects, size_t idx) {
 	return CASTPTR_ASSUME_ALIGNED(objects + idx * pool->size_of_object, ObjHeader);
 }
 
-static void objpool_register_objects(ObjectPool *pool, char *objects) {
-	for(size_t i = 0; i < pool->max_objects; ++i) {
-		ObjHeader *o = obj_ptr(pool, objects, i);
-		o->next = pool->free_objects;
-		pool->free_objects = o;
-	}
-}
-
 ObjectPool *objpool_alloc(size_t obj_size, size_t max_objects, const char *tag) {
 	// TODO: overflow handling
 
@@ -51,7 +70,13 @@ ObjectPool *objpool_alloc(size_t obj_size, size_t max_objects, const char *tag)
 	pool->max_objects = max_objects;
 	pool->tag = strdup(tag);
 
-	objpool_register_objects(pool, pool->objects);
+	// The first slab is embedded in the pool itself.
+	pool->slabs[0] = (ObjSlab) {
+		.objects = pool->objects,
+		.capacity = max_objects,
+		.alloc_size = obj_size * max_objects,
+	};
+	pool->num_slabs = 1;
 
 	log_debug("[%s] Allocated pool for %zu objects, %zu bytes each",
 		pool->tag,
@@ -62,71 +87,142 @@ ObjectPool *objpool_alloc(size_t obj_size, size_t max_objects, const char *tag)
 	return pool;
 }
 
-static char *objpool_add_extent(ObjectPool *pool) {
-	pool->extents = mem_realloc(pool->extents, (++pool->num_extents) * sizeof(*pool->extents));
-	char *extent = pool->extents[pool->num_extents - 1] = mem_alloc_array(pool->max_objects, pool->size_of_object);
-	objpool_register_objects(pool, extent);
-	return extent;
+static void objpool_alloc_slab_memory(ObjectPool *pool, ObjSlab *slab) {
+	size_t size = slab->capacity * pool->size_of_object;
+
+#ifdef OBJPOOL_HUGEPAGES
+	if(size >= OBJPOOL_HUGEPAGE_SIZE) {
+		size = ((size - 1) / OBJPOOL_HUGEPAGE_SIZE + 1) * OBJPOOL_HUGEPAGE_SIZE;
+		void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+		if(p != MAP_FAILED) {
+			if(madvise(p, size, MADV_HUGEPAGE) != 0) {
+				log_debug("[%s] madvise() failed: %s", pool->tag, strerror(errno));
+			}
+
+			// Anonymous mappings are zero-filled lazily by the kernel.
+			slab->objects = p;
+			slab->alloc_size = size;
+			slab->mapped = true;
+			return;
+		}
+
+		log_debug("[%s] mmap() failed: %s", pool->tag, strerror(errno));
+	}
+#endif
+
+	slab->objects = mem_alloc_array(slab->capacity, pool->size_of_object);
+	slab->alloc_size = size;
 }
 
-static char* objpool_fmt_size(ObjectPool *pool) {
-	switch(pool->num_extents) {
-		case 0:
-			return strfmt("%zu objects, %zu bytes each",
-				pool->max_objects,
-				pool->size_of_object
-			);
-
-		case 1:
-			return strfmt("%zu objects, %zu bytes each, with 1 extent",
-				pool->max_objects * 2,
-				pool->size_of_object
-			);
-
-		default:
-			return strfmt("%zu objects, %zu bytes each, with %zu extents",
-				pool->max_objects * (1 + pool->num_extents),
-				pool->size_of_object,
-				pool->num_extents
-			);
+static void objpool_free_slab_memory(ObjSlab *slab) {
+#ifdef OBJPOOL_HUGEPAGES
+	if(slab->mapped) {
+		munmap(slab->objects, slab->alloc_size);
+		return;
 	}
+#endif
+
+	mem_free(slab->objects);
 }
 
-void *objpool_acquire(ObjectPool *pool) {
-	ObjHeader *obj = pool->free_objects;
+static size_t objpool_capacity(ObjectPool *pool) {
+	size_t capacity = 0;
 
-	if(obj) {
-acquired:
-		pool->free_objects = obj->next;
-		memset(obj, 0, pool->size_of_object);
+	for(uint i = 0; i < pool->num_slabs; ++i) {
+		capacity += pool->slabs[i].capacity;
+	}
 
-#ifdef OBJPOOL_TRACK_STATS
-		if(++pool->usage > pool->peak_usage) {
-			pool->peak_usage = pool->usage;
-		}
-#endif
+	return capacity;
+}
 
-		return obj;
+static ObjSlab *objpool_add_slab(ObjectPool *pool) {
+	if(pool->num_slabs >= OBJPOOL_MAX_SLABS) {
+		log_fatal("[%s] Object pool can't grow any further", pool->tag);
 	}
 
-	char *tmp = objpool_fmt_size(pool);
-	log_debug("[%s] Object pool exhausted (%s), extending",
+	ObjSlab *prev = pool->slabs + pool->num_slabs - 1;
+
+	log_debug("[%s] Object pool exhausted (%zu objects, %zu bytes each, in %u slabs), extending",
 		pool->tag,
-		tmp
+		objpool_capacity(pool),
+		pool->size_of_object,
+		pool->num_slabs
 	);
-	mem_free(tmp);
 
-	objpool_add_extent(pool);
-	obj = pool->free_objects;
-	assert(obj != NULL);
-	goto acquired;
+	ObjSlab *slab = prev + 1;
+	*slab = (ObjSlab) { .capacity = prev->capacity * 2 };
+	objpool_alloc_slab_memory(pool, slab);
+	++pool->num_slabs;
+
+	return slab;
+}
+
+void *objpool_acquire(ObjectPool *pool) {
+	ObjSlab *slab = pool->slabs + pool->first_free_slab;
+	ObjSlab *slabs_end = pool->slabs + pool->num_slabs;
+	ObjHeader *obj;
+
+	// Always allocate from the lowest slab that has room, so that live objects stay packed together.
+	for(;; ++slab) {
+		if(UNLIKELY(slab == slabs_end)) {
+			slab = objpool_add_slab(pool);
+			slabs_end = slab + 1;
+		}
+
+		if((obj = slab->free_objects)) {
+			slab->free_objects = obj->next;
+			memset(obj, 0, pool->size_of_object);
+			break;
+		}
+
+		if(slab->num_touched < slab->capacity) {
+			obj = obj_ptr(pool, slab->objects, slab->num_touched++);
+			break;
+		}
+	}
+
+	pool->first_free_slab = slab - pool->slabs;
+	++slab->usage;
+
+#ifdef OBJPOOL_TRACK_STATS
+	if(++pool->usage > pool->peak_usage) {
+		pool->peak_usage = pool->usage;
+	}
+#endif
+
+	return obj;
+}
+
+static ObjSlab *objpool_find_slab(ObjectPool *pool, void *object) {
+	char *p = object;
+
+	for(uint i = 0; i < pool->num_slabs; ++i) {
+		ObjSlab *slab = pool->slabs + i;
+
+		if(p >= slab->objects && p < slab->objects + slab->capacity * pool->size_of_object) {
+			return slab;
+		}
+	}
+
+	return NULL;
 }
 
 void objpool_release(ObjectPool *pool, void *object) {
 	objpool_memtest(pool, object);
+
+	ObjSlab *slab = NOT_NULL(objpool_find_slab(pool, object));
 	ObjHeader *obj = object;
-	obj->next = pool->free_objects;
-	pool->free_objects = obj;
+	obj->next = slab->free_objects;
+	slab->free_objects = obj;
+	--slab->usage;
+
+	uint slab_idx = slab - pool->slabs;
+
+	if(slab_idx < pool->first_free_slab) {
+		pool->first_free_slab = slab_idx;
+	}
+
 #ifdef OBJPOOL_TRACK_STATS
 	pool->usage--;
 #endif
@@ -139,11 +235,10 @@ void objpool_free(ObjectPool *pool) {
 	}
 #endif
 
-	for(size_t i = 0; i < pool->num_extents; ++i) {
-		mem_free(pool->extents[i]);
+	for(uint i = 1; i < pool->num_slabs; ++i) {
+		objpool_free_slab_memory(pool->slabs + i);
 	}
 
-	mem_free(pool->extents);
 	mem_free(pool->tag);
 	mem_free(pool);
 }
@@ -153,33 +248,49 @@ size_t objpool_object_size(ObjectPool *pool) {
 }
 
 void objpool_get_stats(ObjectPool *pool, ObjectPoolStats *stats) {
-	stats->tag = pool->tag;
-	stats->capacity = pool->max_objects * (1 + pool->num_extents);
+	*stats = (ObjectPoolStats) {
+		.tag = pool->tag,
+		.num_slabs = pool->num_slabs,
+	};
+
+	size_t fragmented_capacity = 0;
+	size_t fragmented_usage = 0;
+
+	for(uint i = 0; i < pool->num_slabs; ++i) {
+		ObjSlab *slab = pool->slabs + i;
+		stats->capacity += slab->capacity;
+		stats->reserved_bytes += slab->alloc_size;
+
+		if(slab->usage > 0) {
+			fragmented_capacity += slab->capacity;
+			fragmented_usage += slab->usage;
+		}
+	}
+
+	if(fragmented_capacity > 0) {
+		stats->fragmentation = 1.0 - fragmented_usage / (double)fragmented_capacity;
+	}
+
 #ifdef OBJPOOL_TRACK_STATS
 	stats->usage = pool->usage;
 	stats->peak_usage = pool->peak_usage;
-#else
-	stats->usage = 0;
-	stats->peak_usage = 0;
 #endif
 }
 
 attr_unused
-static bool objpool_object_in_subpool(ObjectPool *pool, ObjHeader *object, char *objects) {
-	char *objofs = (char*)object;
-	char *minofs = objects;
-	char *maxofs = objects + (pool->max_objects - 1) * pool->size_of_object;
+static bool objpool_object_in_pool(ObjectPool *pool, ObjHeader *object) {
+	ObjSlab *slab = objpool_find_slab(pool, object);
 
-	if(objofs < minofs || objofs > maxofs) {
+	if(!slab) {
 		return false;
 	}
 
-	ptrdiff_t misalign = (ptrdiff_t)(objofs - objects) % pool->size_of_object;
+	ptrdiff_t misalign = (ptrdiff_t)((char*)object - slab->objects) % pool->size_of_object;
 
 	if(misalign) {
 		log_fatal("[%s] Object pointer %p is misaligned by %zi",
 			pool->tag,
-			(void*)objofs,
+			(void*)object,
 			(ssize_t)misalign
 		);
 	}
@@ -187,21 +298,6 @@ static bool objpool_object_in_subpool(ObjectPool *pool, ObjHeader *object, char
 	return true;
 }
 
-attr_unused
-static bool objpool_object_in_pool(ObjectPool *pool, ObjHeader *object) {
-	if(objpool_object_in_subpool(pool, object, pool->objects)) {
-		return true;
-	}
-
-	for(size_t i = 0; i < pool->num_extents; ++i) {
-		if(objpool_object_in_subpool(pool, object, pool->extents[i])) {
-			return true;
-		}
-	}
-
-	return false;
-}
-
 #ifdef OBJPOOL_DEBUG
 void objpool_memtest(ObjectPool *pool, void *object) {
 	if(!objpool_object_in_pool(pool, object)) {
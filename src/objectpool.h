@@ -16,12 +16,14 @@
 #endif
 
 #ifdef OBJPOOL_DEBUG
-	#define OBJPOOL_TRACK_STATS
 	#define IF_OBJPOOL_DEBUG(code) code
 #else
 	#define IF_OBJPOOL_DEBUG(code)
 #endif
 
+// Usage tracking is cheap, and the replay benchmark reports peak usage in release builds too.
+#define OBJPOOL_TRACK_STATS
+
 typedef struct ObjectPool ObjectPool;
 typedef struct ObjectPoolStats ObjectPoolStats;
 
@@ -30,8 +32,20 @@ struct ObjectPoolStats {
 	size_t capacity;
 	size_t usage;
 	size_t peak_usage;
+	size_t reserved_bytes;
+	uint num_slabs;
+	// Fraction of free slots in slabs that also hold live objects.
+	double fragmentation;
 };
 
+/*
+ * Pools start with a single slab of max_objects, and grow by adding slabs twice as large
+ * as the previous one when exhausted. Objects are always taken from the lowest slab that
+ * has room, so live objects stay packed in as few slabs as possible.
+ *
+ * Acquired objects are zero-initialized.
+ */
+
 #define OBJPOOL_ALLOC(typename,max_objects) objpool_alloc(sizeof(typename), max_objects, #typename)
 #define OBJPOOL_ACQUIRE(pool, type) CASTPTR_ASSUME_ALIGNED(objpool_acquire(pool), type)
 
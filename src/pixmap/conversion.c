@@ -9,9 +9,11 @@
 #include "taisei.h"
 
 #include "pixmap.h"
+#include "conversion_internal.h"
 #include "util.h"
 
-// NOTE: this is pretty stupid and not at all optimized, patches welcome
+// NOTE: the generic conversions are pretty stupid and not at all optimized, patches welcome.
+// The common cases hit while loading textures have fast paths, see below.
 
 #define _CONV_FUNCNAME	convert_u8_to_u8
 #define _CONV_IN_MAX	UINT8_MAX
@@ -178,6 +180,139 @@ static struct conversion_def* find_conversion(uint depth_in, uint depth_out) {
 	log_fatal("Pixmap conversion for %upbc -> %upbc undefined, please add", depth_in, depth_out);
 }
 
+/*
+ * Fast paths for the most common conversions. These must produce exactly the same
+ * results as the generic functions above. They're written as straight loops over
+ * fixed channel counts, which compilers readily unroll and vectorize.
+ */
+
+typedef void (*fastconvfunc_t)(
+	size_t num_pixels,
+	const void *restrict vbuf_in,
+	void *restrict vbuf_out
+);
+
+static void fastconv_r8_to_rgba8(size_t num_pixels, const void *restrict vbuf_in, void *restrict vbuf_out) {
+	const uint8_t *in = vbuf_in;
+	uint8_t *out = vbuf_out;
+
+	for(size_t i = 0; i < num_pixels; ++i) {
+		out[4 * i + 0] = in[i];
+		out[4 * i + 1] = 0;
+		out[4 * i + 2] = 0;
+		out[4 * i + 3] = UINT8_MAX;
+	}
+}
+
+static void fastconv_rg8_to_rgba8(size_t num_pixels, const void *restrict vbuf_in, void *restrict vbuf_out) {
+	const uint8_t *in = vbuf_in;
+	uint8_t *out = vbuf_out;
+
+	for(size_t i = 0; i < num_pixels; ++i) {
+		out[4 * i + 0] = in[2 * i + 0];
+		out[4 * i + 1] = in[2 * i + 1];
+		out[4 * i + 2] = 0;
+		out[4 * i + 3] = UINT8_MAX;
+	}
+}
+
+static void fastconv_rgb8_to_rgba8(size_t num_pixels, const void *restrict vbuf_in, void *restrict vbuf_out) {
+	const uint8_t *in = vbuf_in;
+	uint8_t *out = vbuf_out;
+
+	for(size_t i = 0; i < num_pixels; ++i) {
+		out[4 * i + 0] = in[3 * i + 0];
+		out[4 * i + 1] = in[3 * i + 1];
+		out[4 * i + 2] = in[3 * i + 2];
+		out[4 * i + 3] = UINT8_MAX;
+	}
+}
+
+static void fastconv_rgba8_to_rgb8(size_t num_pixels, const void *restrict vbuf_in, void *restrict vbuf_out) {
+	const uint8_t *in = vbuf_in;
+	uint8_t *out = vbuf_out;
+
+	for(size_t i = 0; i < num_pixels; ++i) {
+		out[3 * i + 0] = in[4 * i + 0];
+		out[3 * i + 1] = in[4 * i + 1];
+		out[3 * i + 2] = in[4 * i + 2];
+	}
+}
+
+// Same expression as convert_u8_to_f32_convert_value(); built at compile time, so that loader
+// threads can share it without synchronization.
+#define U8_TO_F32(i)    ((i) * (1.0f / (float)UINT8_MAX))
+#define U8_TO_F32_4(i)  U8_TO_F32(i), U8_TO_F32(i + 1), U8_TO_F32(i + 2), U8_TO_F32(i + 3)
+#define U8_TO_F32_16(i) U8_TO_F32_4(i), U8_TO_F32_4(i + 4), U8_TO_F32_4(i + 8), U8_TO_F32_4(i + 12)
+#define U8_TO_F32_64(i) U8_TO_F32_16(i), U8_TO_F32_16(i + 16), U8_TO_F32_16(i + 32), U8_TO_F32_16(i + 48)
+
+static const float u8_to_f32_table[UINT8_MAX + 1] = {
+	U8_TO_F32_64(0), U8_TO_F32_64(64), U8_TO_F32_64(128), U8_TO_F32_64(192),
+};
+
+#undef U8_TO_F32
+#undef U8_TO_F32_4
+#undef U8_TO_F32_16
+#undef U8_TO_F32_64
+
+static void fastconv_u8_to_f32(size_t num_values, const void *restrict vbuf_in, void *restrict vbuf_out) {
+	const uint8_t *in = vbuf_in;
+	float *out = vbuf_out;
+
+	for(size_t i = 0; i < num_values; ++i) {
+		out[i] = u8_to_f32_table[in[i]];
+	}
+}
+
+static void fastconv_u16_to_u8(size_t num_values, const void *restrict vbuf_in, void *restrict vbuf_out) {
+	const uint16_t *in = vbuf_in;
+	uint8_t *out = vbuf_out;
+
+	// Equivalent to roundf(x * (255.0f / 65535.0f)) for every 16-bit input.
+	for(size_t i = 0; i < num_values; ++i) {
+		out[i] = (in[i] + 128u) / 257u;
+	}
+}
+
+struct fastconv_def {
+	fastconvfunc_t func;
+	PixmapFormat format_in;
+	PixmapFormat format_out;
+	// If set, the function operates on individual channel values rather than pixels.
+	bool per_channel;
+};
+
+#define FASTCONV_CHANNELS(func, in, out) { fastconv_##func, PIXMAP_FORMAT_##in, PIXMAP_FORMAT_##out, true }
+
+static struct fastconv_def fastconv_table[] = {
+	{ fastconv_r8_to_rgba8,   PIXMAP_FORMAT_R8,    PIXMAP_FORMAT_RGBA8 },
+	{ fastconv_rg8_to_rgba8,  PIXMAP_FORMAT_RG8,   PIXMAP_FORMAT_RGBA8 },
+	{ fastconv_rgb8_to_rgba8, PIXMAP_FORMAT_RGB8,  PIXMAP_FORMAT_RGBA8 },
+	{ fastconv_rgba8_to_rgb8, PIXMAP_FORMAT_RGBA8, PIXMAP_FORMAT_RGB8 },
+
+	FASTCONV_CHANNELS(u8_to_f32,  R8,     R32F),
+	FASTCONV_CHANNELS(u8_to_f32,  RG8,    RG32F),
+	FASTCONV_CHANNELS(u8_to_f32,  RGB8,   RGB32F),
+	FASTCONV_CHANNELS(u8_to_f32,  RGBA8,  RGBA32F),
+
+	FASTCONV_CHANNELS(u16_to_u8,  R16,    R8),
+	FASTCONV_CHANNELS(u16_to_u8,  RG16,   RG8),
+	FASTCONV_CHANNELS(u16_to_u8,  RGB16,  RGB8),
+	FASTCONV_CHANNELS(u16_to_u8,  RGBA16, RGBA8),
+
+	{ 0 }
+};
+
+static struct fastconv_def *find_fast_conversion(PixmapFormat format_in, PixmapFormat format_out) {
+	for(struct fastconv_def *cv = fastconv_table; cv->func; ++cv) {
+		if(cv->format_in == format_in && cv->format_out == format_out) {
+			return cv;
+		}
+	}
+
+	return NULL;
+}
+
 static void pixmap_copy_meta(const Pixmap *src, Pixmap *dst) {
 	dst->format = src->format;
 	dst->width = src->width;
@@ -203,6 +338,22 @@ void pixmap_copy_alloc(const Pixmap *src, Pixmap *dst) {
 	pixmap_copy(src, dst);
 }
 
+static void convert_generic(PixmapFormat format_in, PixmapFormat format_out, size_t num_pixels, void *buf_in, void *buf_out) {
+	struct conversion_def *cv = find_conversion(
+		PIXMAP_FORMAT_DEPTH(format_in) | (PIXMAP_FORMAT_IS_FLOAT(format_in) * DEPTH_FLOAT_BIT),
+		PIXMAP_FORMAT_DEPTH(format_out) | (PIXMAP_FORMAT_IS_FLOAT(format_out) * DEPTH_FLOAT_BIT)
+	);
+
+	cv->func(
+		PIXMAP_FORMAT_LAYOUT(format_in),
+		PIXMAP_FORMAT_LAYOUT(format_out),
+		num_pixels,
+		buf_in,
+		buf_out,
+		NULL
+	);
+}
+
 void pixmap_convert(const Pixmap *src, Pixmap *dst, PixmapFormat format) {
 	size_t num_pixels = src->width * src->height;
 	size_t pixel_size = PIXMAP_FORMAT_PIXEL_SIZE(format);
@@ -217,19 +368,31 @@ void pixmap_convert(const Pixmap *src, Pixmap *dst, PixmapFormat format) {
 
 	dst->format = format;
 
-	struct conversion_def *cv = find_conversion(
-		PIXMAP_FORMAT_DEPTH(src->format) | (PIXMAP_FORMAT_IS_FLOAT(src->format) * DEPTH_FLOAT_BIT),
-		PIXMAP_FORMAT_DEPTH(dst->format) | (PIXMAP_FORMAT_IS_FLOAT(dst->format) * DEPTH_FLOAT_BIT)
-	);
+	struct fastconv_def *fcv = find_fast_conversion(src->format, format);
 
-	cv->func(
-		PIXMAP_FORMAT_LAYOUT(src->format),
-		PIXMAP_FORMAT_LAYOUT(dst->format),
-		num_pixels,
-		src->data.untyped,
-		dst->data.untyped,
-		NULL
-	);
+	if(fcv) {
+		size_t n = num_pixels;
+
+		if(fcv->per_channel) {
+			n *= PIXMAP_FORMAT_LAYOUT(format);
+		}
+
+		fcv->func(n, src->data.untyped, dst->data.untyped);
+		return;
+	}
+
+	convert_generic(src->format, format, num_pixels, src->data.untyped, dst->data.untyped);
+}
+
+void pixmap_convert_generic(const Pixmap *src, Pixmap *dst, PixmapFormat format) {
+	assert(dst->data.untyped != NULL);
+	pixmap_copy_meta(src, dst);
+	dst->format = format;
+	convert_generic(src->format, format, src->width * src->height, src->data.untyped, dst->data.untyped);
+}
+
+bool pixmap_convert_is_specialized(PixmapFormat format_in, PixmapFormat format_out) {
+	return find_fast_conversion(format_in, format_out) != NULL;
 }
 
 static int swizzle_idx(char s) {
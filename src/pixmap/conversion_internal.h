@@ -0,0 +1,18 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2026, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2026, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#pragma once
+#include "taisei.h"
+
+#include "pixmap.h"
+
+// Like pixmap_convert, but never takes a specialized fast path. Only useful for comparing against.
+void pixmap_convert_generic(const Pixmap *src, Pixmap *dst, PixmapFormat format) attr_nonnull(1, 2);
+
+// Whether pixmap_convert has a specialized fast path for this pair of formats.
+bool pixmap_convert_is_specialized(PixmapFormat format_in, PixmapFormat format_out);
@@ -1380,7 +1380,7 @@ void player_graze(Player *plr, cmplx pos, int pts, int effect_intensity, const C
 	pos = (pos + plr->pos) * 0.5;
 
 	player_add_points(plr, pts, pos);
-	play_sfx("graze");
+	play_sfx_handle(SFX_HANDLE("graze"));
 
 	Color *c = COLOR_COPY(color);
 	color_add(c, RGBA(1, 1, 1, 1));
@@ -1422,13 +1422,13 @@ static void player_add_fragments(Player *plr, int frags, int *pwhole, int *pfrag
 	*pfrags %= maxfrags;
 
 	if(up) {
-		play_sfx(upsnd);
+		(play_sfx)(upsnd);
 	}
 
 	if(frags) {
 		// FIXME: when we have the extra life/bomb sounds,
 		//        don't play this if upsnd was just played.
-		play_sfx(fragsnd);
+		(play_sfx)(fragsnd);
 	}
 
 	if(*pwhole >= maxwhole) {
@@ -1487,6 +1487,7 @@ static void scoretext_update(StageText *txt, int t, float a) {
 }
 
 #define SCORETEXT_PIV_BIT ((uintptr_t)1 << ((sizeof(uintptr_t) * 8) - 1))
+#define SCORETEXT_COMBINE_RADIUS 32
 
 static StageText *find_scoretext_combination_candidate(cmplx pos, bool is_piv) {
 	for(StageText *stxt = stagetext_list_head(); stxt; stxt = stxt->next) {
@@ -1494,7 +1495,7 @@ static StageText *find_scoretext_combination_candidate(cmplx pos, bool is_piv) {
 			stxt->custom.update == scoretext_update &&
 			stxt->time.spawn > global.frames &&
 			(bool)((uintptr_t)(stxt->custom.data2) & SCORETEXT_PIV_BIT) == is_piv &&
-			cabs(pos - stxt->pos) < 32
+			cabs(pos - stxt->pos) < SCORETEXT_COMBINE_RADIUS
 		) {
 			return stxt;
 		}
@@ -1503,9 +1504,7 @@ static StageText *find_scoretext_combination_candidate(cmplx pos, bool is_piv) {
 	return NULL;
 }
 
-static void add_score_text(Player *plr, cmplx location, uint points, bool is_piv) {
-	double rnd = rng_f64s();
-
+static void emit_score_text(Player *plr, cmplx location, uint points, bool is_piv, double rnd) {
 	StageText *stxt = find_scoretext_combination_candidate(location, is_piv);
 
 	if(stxt) {
@@ -1563,6 +1562,54 @@ static void add_score_text(Player *plr, cmplx location, uint points, bool is_piv
 	}
 }
 
+static void add_score_text(Player *plr, cmplx location, uint points, bool is_piv) {
+	// NOTE: always draw this here, even if batched, to keep the game RNG in sync with replays.
+	double rnd = rng_f64s();
+
+	if(plr->score_text_batch.active) {
+		auto batch = &plr->score_text_batch;
+
+		for(uint i = 0; i < batch->num_buckets; ++i) {
+			auto b = batch->buckets + i;
+
+			if(b->is_piv == is_piv && cabs(location - b->location) < SCORETEXT_COMBINE_RADIUS) {
+				b->points += points;
+				return;
+			}
+		}
+
+		if(batch->num_buckets < ARRAY_SIZE(batch->buckets)) {
+			batch->buckets[batch->num_buckets++] = (typeof(*batch->buckets)) {
+				.location = location,
+				.rnd = rnd,
+				.points = points,
+				.is_piv = is_piv,
+			};
+			return;
+		}
+	}
+
+	emit_score_text(plr, location, points, is_piv, rnd);
+}
+
+void player_begin_score_text_batch(Player *plr) {
+	assert(!plr->score_text_batch.active);
+	plr->score_text_batch.active = true;
+}
+
+void player_end_score_text_batch(Player *plr) {
+	auto batch = &plr->score_text_batch;
+	assert(batch->active);
+	batch->active = false;
+
+	for(uint i = 0; i < batch->num_buckets; ++i) {
+		auto b = batch->buckets + i;
+		emit_score_text(plr, b->location, b->points, b->is_piv, b->rnd);
+	}
+
+	batch->num_buckets = 0;
+}
+
 void player_add_points(Player *plr, uint points, cmplx location) {
 	plr->points += points;
 
@@ -158,6 +158,18 @@ DEFINE_ENTITY_TYPE(Player, {
 	float focus_circle_alpha;
 	float bomb_cutin_alpha;
 
+	// See player_begin_score_text_batch()
+	struct {
+		struct {
+			cmplx location;
+			double rnd;
+			uint points;
+			bool is_piv;
+		} buckets[32];
+		uint num_buckets;
+		bool active;
+	} score_text_batch;
+
 	bool gamepadmove;
 	bool iddqd;
 
@@ -217,6 +229,13 @@ void player_add_lives(Player *plr, int lives);
 void player_add_bombs(Player *plr, int bombs);
 void player_add_points(Player *plr, uint points, cmplx location);
 void player_add_piv(Player *plr, uint piv, cmplx location);
+
+// Between these calls, the floating score texts from player_add_points and player_add_piv
+// are merged per kind within the same radius that combines texts spawned on the same frame,
+// and placed where the first one of each group would have been.
+// Scores are still updated immediately.
+void player_begin_score_text_batch(Player *plr);
+void player_end_score_text_batch(Player *plr);
 void player_add_voltage(Player *plr, uint voltage);
 bool player_drain_voltage(Player *plr, uint voltage);
 void player_extend_powersurge(Player *plr, float pos, float neg);
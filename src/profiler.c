@@ -0,0 +1,217 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2026, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2026, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#include "taisei.h"
+
+#include "profiler.h"
+#include "util.h"
+
+// About 24 MiB worth of events; enough for a few minutes of gameplay with a dozen zones.
+#define PROF_TRACE_MAX_EVENTS (1 << 20)
+
+typedef struct ProfZoneData {
+	const char *name;
+	hrtime_t frame_time;
+	hrtime_t history[PROF_HISTORY];
+	uint nesting;
+} ProfZoneData;
+
+typedef struct ProfTraceEvent {
+	hrtime_t start;
+	hrtime_t duration;
+	uint zone;
+} ProfTraceEvent;
+
+static struct {
+	ProfZoneData zones[PROF_MAX_ZONES];
+	uint num_zones;
+	uint history_pos;
+	uint64_t num_frames;
+
+	struct {
+		DYNAMIC_ARRAY(ProfTraceEvent) events;
+		char *path;
+		hrtime_t epoch;
+		bool overflowed;
+	} trace;
+} prof;
+
+bool _prof_active;
+
+// Zone ids are cached in static ProfZone structs at each call site, which prof_shutdown() can't
+// reach; bumping this invalidates all of them at once. Starts at 1 so that new ones are stale too.
+static uint prof_generation = 1;
+
+void prof_init(void) {
+	const char *trace_path = env_get("TAISEI_PROFILER_TRACE", "");
+
+	if(*trace_path) {
+		prof.trace.path = strdup(trace_path);
+		prof.trace.epoch = time_get();
+		log_info("Recording a profiler trace into %s", prof.trace.path);
+		prof_enable();
+	}
+
+	if(env_get("TAISEI_PROFILER_OVERLAY", 0)) {
+		prof_enable();
+	}
+}
+
+void prof_enable(void) {
+	_prof_active = true;
+}
+
+static void prof_write_trace(SDL_RWops *out) {
+	SDL_RWprintf(out, "{\"traceEvents\":[\n");
+
+	dynarray_foreach(&prof.trace.events, int i, ProfTraceEvent *e, {
+		SDL_RWprintf(out,
+			"{\"name\":\"%s\",\"cat\":\"taisei\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}%s\n",
+			prof.zones[e->zone].name,
+			(e->start - prof.trace.epoch) * 1e6 / HRTIME_RESOLUTION,
+			e->duration * 1e6 / HRTIME_RESOLUTION,
+			i + 1 < prof.trace.events.num_elements ? "," : ""
+		);
+	});
+
+	SDL_RWprintf(out, "],\"displayTimeUnit\":\"ms\"}\n");
+}
+
+void prof_shutdown(void) {
+	if(prof.trace.path) {
+		SDL_RWops *out = SDL_RWFromFile(prof.trace.path, "w");
+
+		if(out) {
+			prof_write_trace(out);
+			SDL_RWclose(out);
+			log_info("Wrote %u profiler trace events into %s", prof.trace.events.num_elements, prof.trace.path);
+		} else {
+			log_sdl_error(LOG_ERROR, "SDL_RWFromFile");
+		}
+	}
+
+	dynarray_free_data(&prof.trace.events);
+	mem_free(prof.trace.path);
+	memset(&prof, 0, sizeof(prof));
+	_prof_active = false;
+	++prof_generation;
+}
+
+void prof_frame_end(void) {
+	if(!_prof_active) {
+		return;
+	}
+
+	uint pos = prof.history_pos;
+
+	for(uint i = 0; i < prof.num_zones; ++i) {
+		ProfZoneData *z = prof.zones + i;
+		z->history[pos] = z->frame_time;
+		z->frame_time = 0;
+	}
+
+	prof.history_pos = (pos + 1) % PROF_HISTORY;
+	++prof.num_frames;
+}
+
+uint64_t prof_num_frames(void) {
+	return prof.num_frames;
+}
+
+uint prof_num_zones(void) {
+	return prof.num_zones;
+}
+
+hrtime_t prof_get_zone_last(uint zone) {
+	assert(zone < prof.num_zones);
+	return prof.zones[zone].history[(prof.history_pos + PROF_HISTORY - 1) % PROF_HISTORY];
+}
+
+void prof_get_zone_stats(uint zone, ProfZoneStats *stats) {
+	assert(zone < prof.num_zones);
+	ProfZoneData *z = prof.zones + zone;
+	hrtime_t total = 0, max = 0;
+
+	for(uint i = 0; i < PROF_HISTORY; ++i) {
+		total += z->history[i];
+		max = umax(max, z->history[i]);
+	}
+
+	*stats = (ProfZoneStats) {
+		.name = z->name,
+		.last = prof_get_zone_last(zone),
+		.avg = total / PROF_HISTORY,
+		.max = max,
+	};
+}
+
+void prof_get_zone_graph(uint zone, hrtime_t scale, float out[PROF_HISTORY]) {
+	assert(zone < prof.num_zones);
+	ProfZoneData *z = prof.zones + zone;
+
+	for(uint i = 0; i < PROF_HISTORY; ++i) {
+		out[i] = fminf(1.0f, z->history[(prof.history_pos + i) % PROF_HISTORY] / (double)scale);
+	}
+}
+
+static int prof_register_zone(const char *name) {
+	// Different call sites may share a zone.
+	for(uint i = 0; i < prof.num_zones; ++i) {
+		if(!strcmp(prof.zones[i].name, name)) {
+			return i + 1;
+		}
+	}
+
+	if(prof.num_zones == PROF_MAX_ZONES) {
+		log_warn("Too many profiler zones, ignoring '%s'", name);
+		return -1;
+	}
+
+	prof.zones[prof.num_zones].name = name;
+	return ++prof.num_zones;
+}
+
+ProfZoneScope _prof_zone_begin(ProfZone *zone) {
+	assert(is_main_thread());
+
+	if(UNLIKELY(zone->generation != prof_generation)) {
+		zone->id = prof_register_zone(zone->name);
+		zone->generation = prof_generation;
+	}
+
+	if(UNLIKELY(zone->id < 0)) {
+		return (ProfZoneScope) { };
+	}
+
+	++prof.zones[zone->id - 1].nesting;
+	return (ProfZoneScope) { zone, time_get() };
+}
+
+void _prof_zone_end(ProfZoneScope *scope) {
+	hrtime_t duration = time_get() - scope->start;
+	uint idx = scope->zone->id - 1;
+	ProfZoneData *z = prof.zones + idx;
+
+	// Recursive entries are already covered by the outermost one.
+	if(--z->nesting == 0) {
+		z->frame_time += duration;
+	}
+
+	if(prof.trace.path) {
+		if(prof.trace.events.num_elements < PROF_TRACE_MAX_EVENTS) {
+			*dynarray_append(&prof.trace.events) = (ProfTraceEvent) {
+				.start = scope->start,
+				.duration = duration,
+				.zone = idx,
+			};
+		} else if(!prof.trace.overflowed) {
+			log_warn("Profiler trace is full, no more events will be recorded");
+			prof.trace.overflowed = true;
+		}
+	}
+}
@@ -0,0 +1,122 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2026, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2026, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#pragma once
+#include "taisei.h"
+
+#include "hirestime.h"
+#include "util/macrohax.h"
+
+/*
+ * Lightweight CPU profiler for hot paths.
+ *
+ * PROF_ZONE("name") times the rest of the enclosing block. PROF_BEGIN("name", scope) and
+ * PROF_END(scope) time the statements between them, for spans that don't match a block. The time
+ * spent in each zone is summed up over a frame, and the sums of the last PROF_HISTORY frames are
+ * kept in a ring buffer. The stage HUD draws them as graphs when TAISEI_PROFILER_OVERLAY=1 is set.
+ * If TAISEI_PROFILER_TRACE is set to a file path, every zone entry is also recorded and dumped
+ * there on exit in the Chrome trace event format (load it in chrome://tracing or Perfetto).
+ * --bench-replay reads the zones too.
+ *
+ * Zones are compiled in only if the profiler meson option is enabled, which is the default for
+ * debug builds. Otherwise everything here compiles to nothing. When compiled in, zones record
+ * nothing until the profiler is enabled by one of the above; until then, each one costs a branch
+ * on entry and exit.
+ *
+ * Zones may nest, but must only be used on the main thread.
+ */
+
+// The overlay draws this many samples per zone with the graph shader; see POINTS in graph.frag.glsl.
+#define PROF_HISTORY 120
+#define PROF_MAX_ZONES 32
+
+#ifdef TAISEI_BUILDCONF_PROFILER
+
+typedef struct ProfZone {
+	const char *name;
+	int id; // -1: out of zone slots
+	uint generation; // id is stale unless this matches the profiler's; see prof_shutdown
+} ProfZone;
+
+typedef struct ProfZoneScope {
+	ProfZone *zone;
+	hrtime_t start;
+} ProfZoneScope;
+
+typedef struct ProfZoneStats {
+	const char *name;
+	hrtime_t last;
+	hrtime_t avg;
+	hrtime_t max;
+} ProfZoneStats;
+
+extern bool _prof_active;
+
+void prof_init(void);
+
+// Forgets all zones. The per-call-site zone ids are invalidated too, so zones re-register on their
+// next entry if the profiler is initialized again.
+void prof_shutdown(void);
+
+// Starts recording zones, if not already enabled from the environment in prof_init.
+void prof_enable(void);
+
+// Closes the current frame; called once per main loop iteration.
+void prof_frame_end(void);
+
+// Number of frames closed since the profiler was enabled.
+uint64_t prof_num_frames(void);
+
+uint prof_num_zones(void);
+void prof_get_zone_stats(uint zone, ProfZoneStats *stats) attr_nonnull_all;
+
+// Time spent in a zone during the last closed frame.
+hrtime_t prof_get_zone_last(uint zone);
+
+// Writes the last PROF_HISTORY per-frame times of a zone, oldest first, as fractions of [scale],
+// clamped to 1.
+void prof_get_zone_graph(uint zone, hrtime_t scale, float out[PROF_HISTORY]) attr_nonnull_all;
+
+ProfZoneScope _prof_zone_begin(ProfZone *zone) attr_nonnull_all;
+void _prof_zone_end(ProfZoneScope *scope) attr_nonnull_all;
+
+INLINE ProfZoneScope prof_zone_begin(ProfZone *zone) {
+	return UNLIKELY(_prof_active) ? _prof_zone_begin(zone) : (ProfZoneScope) { };
+}
+
+INLINE void prof_zone_end(ProfZoneScope *scope) {
+	if(UNLIKELY(scope->zone)) {
+		_prof_zone_end(scope);
+	}
+}
+
+#define _PROF_ZONE(zname, zvar, svar) \
+	static ProfZone zvar = { .name = zname }; \
+	attr_cleanup(prof_zone_end) attr_unused ProfZoneScope svar = prof_zone_begin(&zvar)
+
+#define PROF_ZONE(zname) \
+	_PROF_ZONE(zname, MACROHAX_CONCAT(_prof_zone_, __LINE__), MACROHAX_CONCAT(_prof_scope_, __LINE__))
+
+#define PROF_BEGIN(zname, scope) \
+	static ProfZone MACROHAX_CONCAT(_prof_zone_, scope) = { .name = zname }; \
+	ProfZoneScope scope = prof_zone_begin(&MACROHAX_CONCAT(_prof_zone_, scope))
+
+#define PROF_END(scope) \
+	prof_zone_end(&(scope))
+
+#else
+
+#define PROF_ZONE(zname) ((void)0)
+#define PROF_BEGIN(zname, scope) ((void)0)
+#define PROF_END(scope) ((void)0)
+
+INLINE void prof_init(void) { }
+INLINE void prof_shutdown(void) { }
+INLINE void prof_frame_end(void) { }
+
+#endif
@@ -14,9 +14,33 @@
 #include "list.h"
 #include "stageobjects.h"
 #include "util/glm.h"
+#include "util/spatialgrid.h"
 
 static ht_ptr2int_t shader_sublayer_map;
 
+/*
+ * Broadphase for PROJ_PLAYER vs. enemy collisions.
+ *
+ * The grid is built lazily on the first player projectile query in a
+ * process_projectiles() pass, and dropped whenever arbitrary code that may have
+ * moved, spawned or removed enemies gets a chance to run: that is, any task
+ * resume, or any legacy projectile rule that isn't one of the known pure ones.
+ * Cells store indices into `enemies`, which mirrors the global enemy list, so
+ * the first hit found in a cell is always the same enemy the naive linear scan
+ * would have picked.
+ */
+static struct {
+	SpatialGrid grid;
+	DYNAMIC_ARRAY(Enemy*) enemies;
+	uint64_t resume_counter;
+	bool active;
+	bool valid;
+} enemy_broadphase;
+
+#define ENEMY_BROADPHASE_CELL_SIZE 32
+// Guards against rounding differences between the bounding box and the actual hit test.
+#define ENEMY_BROADPHASE_PADDING 1
+
 static ProjArgs defaults_proj = {
 	.sprite = "proj/",
 	.dest = &global.projs,
@@ -138,6 +162,10 @@ static inline char* event_name(int ev) {
 
 static Projectile* spawn_bullet_spawning_effect(Projectile *p);
 
+static inline bool proj_rule_is_pure(ProjRule rule) {
+	return rule == linear || rule == accelerated || rule == asymptotic;
+}
+
 static inline int proj_call_rule(Projectile *p, int t) {
 	int result = ACTION_NONE;
 
@@ -146,6 +174,10 @@ static inline int proj_call_rule(Projectile *p, int t) {
 	} else if(p->rule != NULL) {
 		result = p->rule(p, t);
 
+		if(!proj_rule_is_pure(p->rule)) {
+			enemy_broadphase.valid = false;
+		}
+
 		if(t < 0 && result != ACTION_ACK) {
 			set_debug_info(&p->debug);
 			log_fatal(
@@ -359,6 +391,84 @@ void delete_projectiles(ProjectileList *projlist) {
 	alist_foreach(projlist, foreach_delete_projectile, NULL);
 }
 
+static void enemy_broadphase_build(void) {
+	SpatialGrid *grid = &enemy_broadphase.grid;
+
+	if(!grid->cell_offsets.data) {
+		spatialgrid_init(grid, (Rect) { .bottom_right = CMPLX(VIEWPORT_W, VIEWPORT_H) }, ENEMY_BROADPHASE_CELL_SIZE);
+	}
+
+	spatialgrid_begin(grid);
+	enemy_broadphase.enemies.num_elements = 0;
+
+	for(Enemy *e = global.enemies.first; e; e = e->next) {
+		uint32_t id = enemy_broadphase.enemies.num_elements;
+		*dynarray_append(&enemy_broadphase.enemies) = e;
+
+		double r = fabs(e->hit_radius) + ENEMY_BROADPHASE_PADDING;
+		spatialgrid_insert(grid, id, (Rect) {
+			.top_left = e->pos - CMPLX(r, r),
+			.bottom_right = e->pos + CMPLX(r, r),
+		});
+	}
+
+	spatialgrid_build(grid);
+	enemy_broadphase.resume_counter = cotask_resume_counter();
+	enemy_broadphase.valid = true;
+}
+
+static void enemy_broadphase_begin(void) {
+	enemy_broadphase.active = true;
+	enemy_broadphase.valid = false;
+}
+
+static void enemy_broadphase_end(void) {
+	enemy_broadphase.active = false;
+	enemy_broadphase.valid = false;
+}
+
+static Enemy *find_enemy_hit_linear(Projectile *p) {
+	for(Enemy *e = global.enemies.first; e; e = e->next) {
+		if(
+			!(e->flags & EFLAG_NO_HIT) &&
+			cabs2(e->pos - p->pos) < e->hit_radius * e->hit_radius
+		) {
+			return e;
+		}
+	}
+
+	return NULL;
+}
+
+static Enemy *find_enemy_hit(Projectile *p) {
+	if(!enemy_broadphase.active) {
+		return find_enemy_hit_linear(p);
+	}
+
+	if(
+		!enemy_broadphase.valid ||
+		enemy_broadphase.resume_counter != cotask_resume_counter()
+	) {
+		enemy_broadphase_build();
+	}
+
+	uint num_ids;
+	const uint32_t *ids = spatialgrid_query_point(&enemy_broadphase.grid, p->pos, &num_ids);
+
+	for(uint i = 0; i < num_ids; ++i) {
+		Enemy *e = dynarray_get(&enemy_broadphase.enemies, ids[i]);
+
+		if(
+			!(e->flags & EFLAG_NO_HIT) &&
+			cabs2(e->pos - p->pos) < e->hit_radius * e->hit_radius
+		) {
+			return e;
+		}
+	}
+
+	return NULL;
+}
+
 void calc_projectile_collision(Projectile *p, ProjCollisionResult *out_col) {
 	out_col->type = PCOL_NONE;
 	out_col->entity = NULL;
@@ -372,11 +482,6 @@ void calc_projectile_collision(Projectile *p, ProjCollisionResult *out_col) {
 	}
 
 	if(p->type == PROJ_ENEMY) {
-		Ellipse e_proj = {
-			.axes = p->collision_size,
-			.angle = p->angle + M_PI/2,
-		};
-
 		LineSegment seg = {
 			.a = global.plr.pos - global.plr.velocity - p->prevpos,
 			.b = global.plr.pos - p->pos
@@ -401,31 +506,39 @@ void calc_projectile_collision(Projectile *p, ProjCollisionResult *out_col) {
 		}
 #endif
 
-		if(lineseg_ellipse_intersect(seg, e_proj)) {
-			out_col->type = PCOL_ENTITY;
-			out_col->entity = &global.plr.ent;
-			out_col->fatal = !(p->flags & PFLAG_INDESTRUCTIBLE);
-		} else {
-			e_proj.axes = projectile_graze_size(p);
+		// The hitbox and graze area share the same transform, so test both in one go.
+		cmplx axes[] = {
+			p->collision_size,
+			projectile_graze_size(p),
+		};
+
+		uint num_axes = creal(axes[1]) > 1 ? 2 : 1;
 
-			if(creal(e_proj.axes) > 1 && lineseg_ellipse_intersect(seg, e_proj)) {
+		switch(lineseg_ellipses_intersect(seg, 0, p->angle + M_PI/2, num_axes, axes)) {
+			case 0:
+				out_col->type = PCOL_ENTITY;
+				out_col->entity = &global.plr.ent;
+				out_col->fatal = !(p->flags & PFLAG_INDESTRUCTIBLE);
+				break;
+
+			case 1:
 				out_col->type = PCOL_PLAYER_GRAZE;
 				out_col->entity = &global.plr.ent;
 				out_col->location = p->pos;
-			}
+				break;
+
+			default:
+				break;
 		}
 	} else if(p->type == PROJ_PLAYER) {
-		for(Enemy *e = global.enemies.first; e; e = e->next) {
-			if(
-				!(e->flags & EFLAG_NO_HIT) &&
-				cabs2(e->pos - p->pos) < e->hit_radius * e->hit_radius
-			) {
-				out_col->type = PCOL_ENTITY;
-				out_col->entity = &e->ent;
-				out_col->fatal = !(p->flags & PFLAG_INDESTRUCTIBLE);
+		Enemy *e = find_enemy_hit(p);
 
-				return;
-			}
+		if(e) {
+			out_col->type = PCOL_ENTITY;
+			out_col->entity = &e->ent;
+			out_col->fatal = !(p->flags & PFLAG_INDESTRUCTIBLE);
+
+			return;
 		}
 
 		if(
@@ -483,11 +596,28 @@ void apply_projectile_collision(ProjectileList *projlist, Projectile *p, ProjCol
 	}
 }
 
+static void pdraw_basic_func(Projectile *proj, int t, ProjDrawRuleArgs args);
+static void pdraw_scalefade_func(Projectile *p, int t, ProjDrawRuleArgs args);
+static void projectile_clear_effect_draw(Projectile *p, int t, ProjDrawRuleArgs args);
+
+static inline bool proj_draw_rule_is_stateless(ProjDrawRule *rule) {
+	// These rules pass the projectile's shader and blend mode to the sprite batch
+	// explicitly (see projectile_sprite_params), and don't touch any other render
+	// state, so setting up the state for them is redundant. Skipping that lets
+	// ent_draw() avoid rolling back the state after each of them.
+	return
+		rule->func == pdraw_basic_func ||
+		rule->func == pdraw_scalefade_func ||
+		rule->func == projectile_clear_effect_draw;
+}
+
 static void ent_draw_projectile(EntityInterface *ent) {
 	Projectile *proj = ENT_CAST(ent, Projectile);
 
-	r_blend(proj->blend);
-	r_shader_ptr(proj->shader);
+	if(!proj_draw_rule_is_stateless(&proj->draw_rule)) {
+		r_blend(proj->blend);
+		r_shader_ptr(proj->shader);
+	}
 
 #ifdef PROJ_DEBUG
 	static Projectile prev_state;
@@ -582,6 +712,10 @@ void process_projectiles(ProjectileList *projlist, bool collision) {
 	int action;
 	bool stage_cleared = stage_is_cleared();
 
+	if(collision) {
+		enemy_broadphase_begin();
+	}
+
 	for(Projectile *proj = projlist->first, *next; proj; proj = next) {
 		next = proj->next;
 		proj->prevpos = proj->pos;
@@ -626,6 +760,10 @@ void process_projectiles(ProjectileList *projlist, bool collision) {
 		apply_projectile_collision(projlist, proj, &col);
 	}
 
+	if(collision) {
+		enemy_broadphase_end();
+	}
+
 	for(Projectile *proj = projlist->first, *next; proj; proj = next) {
 		next = proj->next;
 
@@ -1264,4 +1402,6 @@ void projectiles_preload(void) {
 
 void projectiles_free(void) {
 	ht_destroy(&shader_sublayer_map);
+	spatialgrid_free(&enemy_broadphase.grid);
+	dynarray_free_data(&enemy_broadphase.enemies);
 }
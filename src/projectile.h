@@ -103,16 +103,51 @@ typedef struct ProjCollisionResult {
 typedef struct ProjPrototype ProjPrototype;
 
 DEFINE_ENTITY_TYPE(Projectile, {
+	/*
+	 * NOTE: Fields are grouped by access frequency. The first group is touched by
+	 * process_projectiles() for every projectile on every frame, so keep it compact
+	 * and at the front of the struct, right after the entity header. Everything that
+	 * is only needed for drawing, spawning, or in event handlers goes further down.
+	 */
+
 	cmplx pos;
-	cmplx pos0;
 	cmplx prevpos; // used to lerp trajectory for collision detection; set this to pos if you intend to "teleport" the projectile in the rule!
+	MoveParams move;
 	cmplx size; // affects out-of-viewport culling and grazing
 	cmplx collision_size; // affects collision with player (TODO: make this work for player projectiles too?)
-	cmplx args[RULE_ARGC];
 	ProjRule rule;
+	Sprite *sprite;
+	ProjFlags flags;
+	ProjType type;
+	int birthtime;
+
+	// XXX: this is in frames of course, but needs to be float
+	// to avoid subtle truncation and integer division gotchas.
+	float timeout;
+
+	float angle;
+	float angle_delta;
+	int max_viewport_dist;
+	uint clear_flags;
+	float damage;
+	DamageType damage_type;
+
+	int graze_counter_reset_timer;
+	int graze_cooldown;
+	short graze_counter;
+
+	COEVENTS_ARRAY(
+		collision,
+		cleared,
+		killed
+	) events;
+
+	// Cold data below this point.
+
+	cmplx pos0;
+	cmplx args[RULE_ARGC];
 	ProjDrawRule draw_rule;
 	ShaderProgram *shader;
-	Sprite *sprite;
 	ProjPrototype *proto;
 
 	/*
@@ -133,35 +168,11 @@ DEFINE_ENTITY_TYPE(Projectile, {
 	*/
 	ProjCollisionResult *collision;
 
-	MoveParams move;
-	COEVENTS_ARRAY(
-		collision,
-		cleared,
-		killed
-	) events;
 	Color color;
 	BlendMode blend;
-	int birthtime;
-	float damage;
-	float angle;
-	float angle_delta;
-	ProjType type;
-	DamageType damage_type;
-	int max_viewport_dist;
-	ProjFlags flags;
-	uint clear_flags;
-
 	cmplxf scale;
 	float opacity;
 
-	// XXX: this is in frames of course, but needs to be float
-	// to avoid subtle truncation and integer division gotchas.
-	float timeout;
-
-	int graze_counter_reset_timer;
-	int graze_cooldown;
-	short graze_counter;
-
 	IF_PROJ_DEBUG(
 		DebugInfo debug;
 	)
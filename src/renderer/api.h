@@ -860,6 +860,7 @@ VertexArray* r_vertex_array_static_models(void) attr_returns_nonnull;
 
 void r_state_push(void);
 void r_state_pop(void);
+bool r_state_is_dirty(void);
 
 void r_draw_quad(void);
 void r_draw_quad_instanced(uint instances);
@@ -9,6 +9,7 @@
 #include "taisei.h"
 
 #include "shaderlib.h"
+#include "cache_private.h"
 
 #include "util.h"
 #include "util/sha256.h"
@@ -16,9 +17,64 @@
 #include "rwops/rwops_autobuf.h"
 #include "rwops/rwops_zstd.h"
 
+#if defined(TAISEI_BUILDCONF_HAVE_POSIX) && !defined(__EMSCRIPTEN__)
+	#include <errno.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+
+	#define SHADER_PACK_MMAP
+#endif
+
 #define CACHE_VERSION 5
 #define CRC_INIT 0
 
+/*
+ * Pack layout: all integers are little-endian.
+ *
+ *   Header:
+ *     char magic[8]                  PACK_MAGIC
+ *     u32 version                    PACK_VERSION
+ *     u32 num_indexed
+ *     u32 tail_ofs                   where the appended records begin
+ *     u32 session                    serial number of the last session that used the pack
+ *
+ *   Index, sorted by name (see pack_name_cmp):
+ *     { u32 name_ofs, name_len, data_ofs, data_size, last_used } [num_indexed]
+ *
+ *   Names and data of the indexed entries, up to tail_ofs.
+ *
+ *   Records appended at runtime, until the end of the file; later ones take precedence:
+ *     u32 magic                      PACK_RECORD_MAGIC
+ *     u16 name_len
+ *     u16 reserved
+ *     u32 data_size
+ *     char name[name_len]
+ *     u8 data[data_size]
+ *
+ * Compaction moves all live records into the index. Entries not used for PACK_GC_SESSIONS
+ * sessions are dropped then; most of those were built from shader sources that have changed
+ * since, so their hash will never be looked up again.
+ */
+
+#define PACK_FILE_NAME "shaders.pack"
+#define PACK_MAGIC "TSHDPACK"
+#define PACK_VERSION 2
+#define PACK_HEADER_SIZE 24
+#define PACK_INDEX_ENTRY_SIZE 20
+#define PACK_RECORD_MAGIC 0x52434853  // "SHCR"
+#define PACK_RECORD_HEADER_SIZE 12
+#define PACK_MAX_SIZE UINT32_MAX
+#define PACK_GC_SESSIONS 64
+// Compact at startup once this many records have been appended.
+#define PACK_MAX_TAIL_RECORDS 256
+
+// Written once the directory layout has been imported into the pack. Bump the version to import
+// it again.
+#define SHADER_CACHE_MIGRATION_MARKER "cache/shaders.migrated"
+#define SHADER_CACHE_MIGRATION_VERSION 1
+
 #define MAX_CONTENT_SIZE          (1024 * 1024)
 #define MAX_GLSL_ATTRIBS          255
 #define MAX_GLSL_MACROS           255
@@ -224,9 +280,104 @@ fail:
 	return false;
 }
 
-bool shader_cache_get(const char *hash, const char *key, ShaderSource *entry) {
+static void pack_close_locked(void);
+
+static struct {
+	SDL_mutex *mutex;
+	char *path;  // NULL if there's no filesystem path for the pack; only the directory layout is used then
+
+	struct {
+		uint8_t *data;
+		size_t size;
+		bool mapped;
+	} file;
+
+	const uint8_t *index;
+	uint32_t num_indexed;
+	// which indexed entries were looked up since the pack was opened
+	bool *used;
+
+	// serial number of this session, and of the last one according to the header
+	uint32_t session;
+	uint32_t header_session;
+
+	// Length of the well-formed part of the file; 0 if there is no valid pack on disk.
+	size_t valid_size;
+	bool needs_compaction;
+
+	// name -> record header, for the appended records
+	ht_str2ptr_t tail;
+	// records appended during this session; not covered by the mapping
+	DYNAMIC_ARRAY(uint8_t*) new_records;
+} pack;
+
+INLINE uint16_t read_le16(const uint8_t *p) {
+	uint16_t v;
+	memcpy(&v, p, sizeof(v));
+	return SDL_SwapLE16(v);
+}
+
+INLINE uint32_t read_le32(const uint8_t *p) {
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return SDL_SwapLE32(v);
+}
+
+INLINE void write_le16(uint8_t *p, uint16_t v) {
+	v = SDL_SwapLE16(v);
+	memcpy(p, &v, sizeof(v));
+}
+
+INLINE void write_le32(uint8_t *p, uint32_t v) {
+	v = SDL_SwapLE32(v);
+	memcpy(p, &v, sizeof(v));
+}
+
+static bool shader_cache_entry_name(const char *hash, const char *key, char name[SHADER_CACHE_MAX_NAME_LEN + 1]) {
+	size_t len = snprintf(name, SHADER_CACHE_MAX_NAME_LEN + 1, "%s/%s", hash, key);
+
+	if(len > SHADER_CACHE_MAX_NAME_LEN) {
+		log_error("Cache entry name is too long: %s/%s", hash, key);
+		return false;
+	}
+
+	return true;
+}
+
+static uint8_t *shader_cache_compress(const uint8_t *entry, size_t entry_size, size_t *out_size) {
+	uint8_t *buf;
+	SDL_RWops *abuf = SDL_RWAutoBuffer((void**)&buf, BUFSIZ);
+	SDL_RWops *out = NOT_NULL(SDL_RWWrapZstdWriter(abuf, RW_ZSTD_LEVEL_DEFAULT, false));
+	SDL_RWwrite(out, entry, entry_size, 1);
+	SDL_RWclose(out);
+
+	*out_size = SDL_RWtell(abuf);
+	uint8_t *result = memdup(buf, *out_size);
+	SDL_RWclose(abuf);
+	return result;
+}
+
+bool shader_cache_decode_blob(ShaderCacheBlob blob, ShaderSource *out_src) {
+	SDL_RWops *stream = SDL_RWFromConstMem(blob.data, blob.size);
+
+	if(UNLIKELY(!stream)) {
+		log_sdl_error(LOG_ERROR, "SDL_RWFromConstMem");
+		return false;
+	}
+
+	stream = NOT_NULL(SDL_RWWrapZstdReader(stream, true));
+	bool result = shader_cache_load_entry(stream, out_src);
+	SDL_RWclose(stream);
+	return result;
+}
+
+/*
+ * Directory layout
+ */
+
+bool shader_cache_dir_read(const char *root, const char *name, ShaderCacheBlob *out_blob) {
 	char path[256];
-	snprintf(path, sizeof(path), "cache/shaders/%s/%s", hash, key);
+	snprintf(path, sizeof(path), "%s/%s", root, name);
 
 	SDL_RWops *stream = vfs_open(path, VFS_MODE_READ);
 
@@ -234,21 +385,41 @@ bool shader_cache_get(const char *hash, const char *key, ShaderSource *entry) {
 		return false;
 	}
 
-	stream = NOT_NULL(SDL_RWWrapZstdReader(stream, true));
-	bool result = shader_cache_load_entry(stream, entry);
+	int64_t size = SDL_RWsize(stream);
+	uint8_t *data = NULL;
+
+	if(size <= 0 || size > MAX_CONTENT_SIZE) {
+		log_error("%s: bad cache entry size %"PRIi64, path, size);
+		goto fail;
+	}
+
+	data = mem_alloc(size);
+
+	if(SDL_RWread(stream, data, size, 1) != 1) {
+		log_sdl_error(LOG_ERROR, "SDL_RWread");
+		goto fail;
+	}
+
 	SDL_RWclose(stream);
+	*out_blob = (ShaderCacheBlob) { data, size };
+	return true;
 
-	log_debug("Retrieved %s/%s from cache", hash, key);
-	return result;
+fail:
+	mem_free(data);
+	SDL_RWclose(stream);
+	return false;
 }
 
-static bool shader_cache_set_raw(const char *hash, const char *key, uint8_t *entry, size_t entry_size) {
+bool shader_cache_dir_write(const char *root, const char *name, ShaderCacheBlob blob) {
+	const char *sep = strchr(name, '/');
+	assert(sep != NULL);
+
 	char path[256];
 
-	vfs_mkdir("cache/shaders");
-	snprintf(path, sizeof(path), "cache/shaders/%s", hash);
+	vfs_mkdir(root);
+	snprintf(path, sizeof(path), "%s/%.*s", root, (int)(sep - name), name);
 	vfs_mkdir(path);
-	snprintf(path, sizeof(path), "cache/shaders/%s/%s", hash, key);
+	snprintf(path, sizeof(path), "%s/%s", root, name);
 
 	SDL_RWops *out = vfs_open(path, VFS_MODE_WRITE);
 
@@ -257,25 +428,930 @@ static bool shader_cache_set_raw(const char *hash, const char *key, uint8_t *ent
 		return false;
 	}
 
-	out = NOT_NULL(SDL_RWWrapZstdWriter(out, RW_ZSTD_LEVEL_DEFAULT, true));
-	SDL_RWwrite(out, entry, entry_size, 1);
+	SDL_RWwrite(out, blob.data, blob.size, 1);
 	SDL_RWclose(out);
 
 	return true;
 }
 
+static bool shader_cache_dir_get(const char *name, ShaderSource *out_src) {
+	char path[256];
+	snprintf(path, sizeof(path), SHADER_CACHE_DIR "/%s", name);
+
+	SDL_RWops *stream = vfs_open(path, VFS_MODE_READ);
+
+	if(stream == NULL) {
+		return false;
+	}
+
+	stream = NOT_NULL(SDL_RWWrapZstdReader(stream, true));
+	bool result = shader_cache_load_entry(stream, out_src);
+	SDL_RWclose(stream);
+
+	return result;
+}
+
+/*
+ * Filesystem access
+ *
+ * The VFS can't map, append to, partially overwrite, rename or delete files, and the pack needs
+ * all of that. This section is the only part of the shader cache that works with real paths
+ * instead of the VFS. They are derived from the syspath of the "cache" directory, which is
+ * resolved once in pack_resolve_path(). If it has no syspath, the pack is disabled and the cache
+ * falls back to the directory layout, which only uses the VFS.
+ */
+
+static bool pack_resolve_path(void) {
+	char *dir = vfs_syspath("cache");
+
+	if(!dir) {
+		return false;
+	}
+
+	pack.path = vfs_syspath_join_alloc(dir, PACK_FILE_NAME);
+	mem_free(dir);
+	return true;
+}
+
+static SDL_RWops *pack_file_open(const char *path, const char *mode) {
+	SDL_RWops *stream = SDL_RWFromFile(path, mode);
+
+	if(!stream) {
+		log_sdl_error(LOG_WARN, "SDL_RWFromFile");
+	}
+
+	return stream;
+}
+
+static void pack_file_remove(const char *path) {
+	vfs_syspath_remove(path);
+}
+
+// Replaces [dst] with [src], or removes [src] if that fails.
+static bool pack_file_replace(const char *src, const char *dst) {
+	if(!vfs_syspath_rename(src, dst)) {
+		log_error("%s", vfs_get_error());
+		pack_file_remove(src);
+		return false;
+	}
+
+	return true;
+}
+
+static bool pack_map_file(void) {
+#ifdef SHADER_PACK_MMAP
+	int fd = open(pack.path, O_RDONLY);
+
+	if(fd < 0) {
+		if(errno != ENOENT) {
+			log_warn("%s: open() failed: %s", pack.path, strerror(errno));
+		}
+
+		return false;
+	}
+
+	struct stat st;
+	void *data = MAP_FAILED;
+
+	if(fstat(fd, &st) != 0) {
+		log_warn("%s: fstat() failed: %s", pack.path, strerror(errno));
+	} else if(st.st_size > 0 && st.st_size <= PACK_MAX_SIZE) {
+		data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+		if(data == MAP_FAILED) {
+			log_warn("%s: mmap() failed: %s", pack.path, strerror(errno));
+		}
+	}
+
+	close(fd);
+
+	if(data == MAP_FAILED) {
+		return false;
+	}
+
+	pack.file.data = data;
+	pack.file.size = st.st_size;
+	pack.file.mapped = true;
+	return true;
+#else
+	SDL_RWops *stream = SDL_RWFromFile(pack.path, "rb");
+
+	if(!stream) {
+		return false;
+	}
+
+	int64_t size = SDL_RWsize(stream);
+
+	if(size > 0 && size <= PACK_MAX_SIZE) {
+		pack.file.data = mem_alloc(size);
+		pack.file.size = size;
+
+		if(SDL_RWread(stream, pack.file.data, size, 1) != 1) {
+			log_sdl_error(LOG_WARN, "SDL_RWread");
+			mem_free(pack.file.data);
+			pack.file.data = NULL;
+			pack.file.size = 0;
+		}
+	}
+
+	SDL_RWclose(stream);
+	return pack.file.data != NULL;
+#endif
+}
+
+static void pack_unmap_file(void) {
+#ifdef SHADER_PACK_MMAP
+	if(pack.file.mapped) {
+		munmap(pack.file.data, pack.file.size);
+	}
+#else
+	mem_free(pack.file.data);
+#endif
+
+	pack.file.data = NULL;
+	pack.file.size = 0;
+	pack.file.mapped = false;
+}
+
+// Stamps the header and the entries looked up during this session with the session number, in place.
+static void pack_file_write_usage(void) {
+	SDL_RWops *stream = pack_file_open(pack.path, "r+b");
+
+	if(!stream) {
+		return;
+	}
+
+	uint8_t buf[4];
+	write_le32(buf, pack.session);
+	bool ok = SDL_RWseek(stream, 20, RW_SEEK_SET) >= 0 && SDL_RWwrite(stream, buf, sizeof(buf), 1) == 1;
+
+	for(uint32_t i = 0; ok && i < pack.num_indexed; ++i) {
+		if(pack.used[i] && read_le32(pack.index + i * PACK_INDEX_ENTRY_SIZE + 16) != pack.session) {
+			int64_t ofs = PACK_HEADER_SIZE + i * PACK_INDEX_ENTRY_SIZE + 16;
+			ok = SDL_RWseek(stream, ofs, RW_SEEK_SET) >= 0 && SDL_RWwrite(stream, buf, sizeof(buf), 1) == 1;
+		}
+	}
+
+	if(!ok) {
+		log_sdl_error(LOG_WARN, "SDL_RWwrite");
+	}
+
+	SDL_RWclose(stream);
+}
+
+bool shader_cache_dir_remove(const char *root) {
+	char *root_syspath = vfs_syspath(root);
+
+	if(!root_syspath) {
+		return false;
+	}
+
+	VFSDir *hashes = vfs_dir_open(root);
+	bool ok = true;
+
+	if(hashes) {
+		for(const char *hash; (hash = vfs_dir_read(hashes));) {
+			char path[256];
+			snprintf(path, sizeof(path), "%s/%s", root, hash);
+			char *hash_syspath = vfs_syspath_join_alloc(root_syspath, hash);
+			VFSDir *keys = vfs_dir_open(path);
+
+			if(keys) {
+				for(const char *key; (key = vfs_dir_read(keys));) {
+					char *key_syspath = vfs_syspath_join_alloc(hash_syspath, key);
+					ok = vfs_syspath_remove(key_syspath) && ok;
+					mem_free(key_syspath);
+				}
+
+				vfs_dir_close(keys);
+			}
+
+			ok = vfs_syspath_remove(hash_syspath) && ok;
+			mem_free(hash_syspath);
+		}
+
+		vfs_dir_close(hashes);
+	}
+
+	ok = vfs_syspath_remove(root_syspath) && ok;
+	mem_free(root_syspath);
+
+	if(!ok) {
+		log_warn("Failed to remove %s: %s", root, vfs_get_error());
+	}
+
+	return ok;
+}
+
+/*
+ * Pack layout
+ */
+
+static void pack_write_header(uint8_t header[PACK_HEADER_SIZE], uint32_t num_indexed, uint32_t tail_ofs, uint32_t session) {
+	memcpy(header, PACK_MAGIC, sizeof(PACK_MAGIC) - 1);
+	write_le32(header + 8, PACK_VERSION);
+	write_le32(header + 12, num_indexed);
+	write_le32(header + 16, tail_ofs);
+	write_le32(header + 20, session);
+}
+
+static int pack_name_cmp(const char *a, size_t alen, const char *b, size_t blen) {
+	int cmp = memcmp(a, b, umin(alen, blen));
+	return cmp ? cmp : (alen > blen) - (alen < blen);
+}
+
+static bool pack_parse_index(void) {
+	const uint8_t *data = pack.file.data;
+	size_t size = pack.file.size;
+
+	if(size < PACK_HEADER_SIZE || memcmp(data, PACK_MAGIC, sizeof(PACK_MAGIC) - 1)) {
+		log_warn("%s: not a shader cache pack, ignoring", pack.path);
+		return false;
+	}
+
+	if(read_le32(data + 8) != PACK_VERSION) {
+		log_info("%s: pack version mismatch, ignoring", pack.path);
+		return false;
+	}
+
+	uint32_t num_indexed = read_le32(data + 12);
+	uint32_t tail_ofs = read_le32(data + 16);
+
+	if(tail_ofs > size || PACK_HEADER_SIZE + (uint64_t)num_indexed * PACK_INDEX_ENTRY_SIZE > tail_ofs) {
+		log_warn("%s: corrupted pack header, ignoring", pack.path);
+		return false;
+	}
+
+	const uint8_t *index = data + PACK_HEADER_SIZE;
+
+	for(uint32_t i = 0; i < num_indexed; ++i) {
+		const uint8_t *e = index + i * PACK_INDEX_ENTRY_SIZE;
+
+		if(
+			read_le32(e + 4) > SHADER_CACHE_MAX_NAME_LEN ||
+			(uint64_t)read_le32(e + 0) + read_le32(e + 4) > tail_ofs ||
+			(uint64_t)read_le32(e + 8) + read_le32(e + 12) > tail_ofs
+		) {
+			log_warn("%s: corrupted pack index, ignoring", pack.path);
+			return false;
+		}
+	}
+
+	pack.index = index;
+	pack.num_indexed = num_indexed;
+	pack.header_session = read_le32(data + 20);
+	pack.valid_size = tail_ofs;
+	return true;
+}
+
+static void pack_scan_tail(void) {
+	const uint8_t *data = pack.file.data;
+	size_t size = pack.file.size;
+	size_t ofs = pack.valid_size;
+
+	while(size - ofs >= PACK_RECORD_HEADER_SIZE) {
+		const uint8_t *rec = data + ofs;
+		uint name_len = read_le16(rec + 4);
+		size_t rec_size = PACK_RECORD_HEADER_SIZE + name_len + (size_t)read_le32(rec + 8);
+
+		if(
+			read_le32(rec) != PACK_RECORD_MAGIC ||
+			name_len > SHADER_CACHE_MAX_NAME_LEN ||
+			rec_size > size - ofs
+		) {
+			break;
+		}
+
+		char name[name_len + 1];
+		memcpy(name, rec + PACK_RECORD_HEADER_SIZE, name_len);
+		name[name_len] = 0;
+		ht_set(&pack.tail, name, (void*)rec);
+
+		ofs += rec_size;
+	}
+
+	if(ofs != size) {
+		// Most likely an interrupted write
+		log_warn("%s: %zu bytes of garbage at the end of the pack", pack.path, size - ofs);
+		pack.needs_compaction = true;
+	}
+
+	pack.valid_size = ofs;
+}
+
+static bool pack_open_locked(void) {
+	pack_close_locked();
+
+	if(!pack_map_file()) {
+		return false;
+	}
+
+	if(!pack_parse_index()) {
+		pack_unmap_file();
+		return false;
+	}
+
+	pack_scan_tail();
+
+	if(pack.num_indexed) {
+		pack.used = ALLOC_ARRAY(pack.num_indexed, bool);
+	}
+
+	log_debug("%s: %u indexed entries, %u appended", pack.path, pack.num_indexed, pack.tail.num_elements_occupied);
+	return true;
+}
+
+static void pack_close_locked(void) {
+	pack_unmap_file();
+	pack.index = NULL;
+	pack.num_indexed = 0;
+	mem_free(pack.used);
+	pack.used = NULL;
+	pack.valid_size = 0;
+	ht_unset_all(&pack.tail);
+
+	dynarray_foreach_elem(&pack.new_records, uint8_t **rec, {
+		mem_free(*rec);
+	});
+
+	pack.new_records.num_elements = 0;
+}
+
+bool shader_cache_pack_open(void) {
+	if(!pack.path) {
+		return false;
+	}
+
+	SDL_LockMutex(pack.mutex);
+	bool result = pack_open_locked();
+	SDL_UnlockMutex(pack.mutex);
+	return result;
+}
+
+void shader_cache_pack_close(void) {
+	if(!pack.path) {
+		return;
+	}
+
+	SDL_LockMutex(pack.mutex);
+	pack_close_locked();
+	SDL_UnlockMutex(pack.mutex);
+}
+
+size_t shader_cache_pack_size(void) {
+	return pack.file.size;
+}
+
+const char *shader_cache_pack_path(void) {
+	return pack.path;
+}
+
+INLINE ShaderCacheBlob pack_record_blob(const uint8_t *rec) {
+	return (ShaderCacheBlob) {
+		.data = rec + PACK_RECORD_HEADER_SIZE + read_le16(rec + 4),
+		.size = read_le32(rec + 8),
+	};
+}
+
+static bool pack_find_indexed(const char *name, size_t name_len, ShaderCacheBlob *out_blob) {
+	const uint8_t *data = pack.file.data;
+	uint32_t lo = 0, hi = pack.num_indexed;
+
+	while(lo < hi) {
+		uint32_t mid = lo + (hi - lo) / 2;
+		const uint8_t *e = pack.index + mid * PACK_INDEX_ENTRY_SIZE;
+		int cmp = pack_name_cmp(name, name_len, (const char*)data + read_le32(e + 0), read_le32(e + 4));
+
+		if(cmp == 0) {
+			*out_blob = (ShaderCacheBlob) { data + read_le32(e + 8), read_le32(e + 12) };
+			pack.used[mid] = true;
+			return true;
+		}
+
+		if(cmp < 0) {
+			hi = mid;
+		} else {
+			lo = mid + 1;
+		}
+	}
+
+	return false;
+}
+
+bool shader_cache_pack_find(const char *name, ShaderCacheBlob *out_blob) {
+	if(!pack.path) {
+		return false;
+	}
+
+	SDL_LockMutex(pack.mutex);
+
+	const uint8_t *rec = ht_get(&pack.tail, name, NULL);
+	bool found;
+
+	if(rec) {
+		*out_blob = pack_record_blob(rec);
+		found = true;
+	} else {
+		found = pack_find_indexed(name, strlen(name), out_blob);
+	}
+
+	SDL_UnlockMutex(pack.mutex);
+	return found;
+}
+
+void shader_cache_pack_foreach(ShaderCacheBlobVisitor visit, void *arg) {
+	if(!pack.path) {
+		return;
+	}
+
+	SDL_LockMutex(pack.mutex);
+
+	ht_str2ptr_iter_t iter;
+	ht_iter_begin(&pack.tail, &iter);
+
+	for(; iter.has_data; ht_iter_next(&iter)) {
+		visit(iter.key, pack_record_blob(iter.value), arg);
+	}
+
+	ht_iter_end(&iter);
+
+	for(uint32_t i = 0; i < pack.num_indexed; ++i) {
+		const uint8_t *e = pack.index + i * PACK_INDEX_ENTRY_SIZE;
+		uint name_len = read_le32(e + 4);
+		char name[name_len + 1];
+		memcpy(name, pack.file.data + read_le32(e + 0), name_len);
+		name[name_len] = 0;
+
+		if(!ht_get(&pack.tail, name, NULL)) {
+			visit(name, (ShaderCacheBlob) { pack.file.data + read_le32(e + 8), read_le32(e + 12) }, arg);
+		}
+	}
+
+	SDL_UnlockMutex(pack.mutex);
+}
+
+static void pack_append(const char *name, ShaderCacheBlob blob) {
+	size_t name_len = strlen(name);
+	size_t rec_size = PACK_RECORD_HEADER_SIZE + name_len + blob.size;
+	uint8_t *rec = mem_alloc(rec_size);
+
+	write_le32(rec, PACK_RECORD_MAGIC);
+	write_le16(rec + 4, name_len);
+	write_le16(rec + 6, 0);
+	write_le32(rec + 8, blob.size);
+	memcpy(rec + PACK_RECORD_HEADER_SIZE, name, name_len);
+	memcpy(rec + PACK_RECORD_HEADER_SIZE + name_len, blob.data, blob.size);
+
+	SDL_LockMutex(pack.mutex);
+
+	// Keep the record in memory, so that it can be found during this session without remapping.
+	*dynarray_append(&pack.new_records) = rec;
+	ht_set(&pack.tail, name, rec);
+
+	if(pack.valid_size + rec_size > PACK_MAX_SIZE) {
+		log_warn("%s: pack is too large, not appending %s", pack.path, name);
+		goto done;
+	}
+
+	bool new_file = pack.valid_size == 0;
+	SDL_RWops *out = pack_file_open(pack.path, new_file ? "wb" : "ab");
+
+	if(!out) {
+		goto done;
+	}
+
+	if(new_file) {
+		uint8_t header[PACK_HEADER_SIZE];
+		pack_write_header(header, 0, PACK_HEADER_SIZE, pack.session);
+
+		if(SDL_RWwrite(out, header, sizeof(header), 1) != 1) {
+			log_sdl_error(LOG_WARN, "SDL_RWwrite");
+			SDL_RWclose(out);
+			goto done;
+		}
+
+		pack.valid_size = PACK_HEADER_SIZE;
+	}
+
+	if(SDL_RWwrite(out, rec, rec_size, 1) == 1) {
+		pack.valid_size += rec_size;
+	} else {
+		log_sdl_error(LOG_WARN, "SDL_RWwrite");
+	}
+
+	SDL_RWclose(out);
+
+done:
+	SDL_UnlockMutex(pack.mutex);
+}
+
+/*
+ * Compaction
+ */
+
+typedef struct PackCompactEntry {
+	char *name;
+	ShaderCacheBlob blob;
+	uint32_t last_used;
+} PackCompactEntry;
+
+typedef struct PackCompactor {
+	DYNAMIC_ARRAY(PackCompactEntry) entries;
+	DYNAMIC_ARRAY(uint8_t*) owned_data;
+	ht_str2int_t seen;
+	uint num_dropped;
+	uint num_expired;
+} PackCompactor;
+
+INLINE bool pack_session_expired(uint32_t last_used) {
+	return pack.session - last_used > PACK_GC_SESSIONS;
+}
+
+static void pack_compact_add(PackCompactor *c, const char *name, ShaderCacheBlob blob, uint32_t last_used) {
+	if(ht_get(&c->seen, name, 0)) {
+		return;
+	}
+
+	ht_set(&c->seen, name, 1);
+
+	if(pack_session_expired(last_used)) {
+		log_debug("Dropping entry %s, unused for %u sessions", name, pack.session - last_used);
+		++c->num_expired;
+		return;
+	}
+
+	// Also weeds out entries written by older versions of the cache format.
+	ShaderSource src;
+
+	if(!shader_cache_decode_blob(blob, &src)) {
+		log_info("Dropping stale or corrupted entry %s", name);
+		++c->num_dropped;
+		return;
+	}
+
+	shader_free_source(&src);
+
+	*dynarray_append(&c->entries) = (PackCompactEntry) {
+		.name = strdup(name),
+		.blob = blob,
+		.last_used = last_used,
+	};
+}
+
+// Must be called with pack.mutex held.
+static void pack_compact_collect(PackCompactor *c) {
+	// Appended records take precedence, and haven't been around long enough to expire.
+	ht_str2ptr_iter_t iter;
+	ht_iter_begin(&pack.tail, &iter);
+
+	for(; iter.has_data; ht_iter_next(&iter)) {
+		pack_compact_add(c, iter.key, pack_record_blob(iter.value), pack.session);
+	}
+
+	ht_iter_end(&iter);
+
+	for(uint32_t i = 0; i < pack.num_indexed; ++i) {
+		const uint8_t *e = pack.index + i * PACK_INDEX_ENTRY_SIZE;
+		uint name_len = read_le32(e + 4);
+		char name[name_len + 1];
+		memcpy(name, pack.file.data + read_le32(e + 0), name_len);
+		name[name_len] = 0;
+
+		pack_compact_add(
+			c, name,
+			(ShaderCacheBlob) { pack.file.data + read_le32(e + 8), read_le32(e + 12) },
+			pack.used[i] ? pack.session : read_le32(e + 16)
+		);
+	}
+}
+
+static void pack_compact_import_dir(PackCompactor *c) {
+	VFSDir *hashes = vfs_dir_open(SHADER_CACHE_DIR);
+
+	if(!hashes) {
+		return;
+	}
+
+	for(const char *hash; (hash = vfs_dir_read(hashes));) {
+		char path[256];
+		snprintf(path, sizeof(path), SHADER_CACHE_DIR "/%s", hash);
+		VFSDir *keys = vfs_dir_open(path);
+
+		if(!keys) {
+			continue;
+		}
+
+		for(const char *key; (key = vfs_dir_read(keys));) {
+			char name[SHADER_CACHE_MAX_NAME_LEN + 1];
+			ShaderCacheBlob blob;
+
+			if(
+				!shader_cache_entry_name(hash, key, name) ||
+				ht_get(&c->seen, name, 0) ||
+				!shader_cache_dir_read(SHADER_CACHE_DIR, name, &blob)
+			) {
+				continue;
+			}
+
+			*dynarray_append(&c->owned_data) = (uint8_t*)blob.data;
+			pack_compact_add(c, name, blob, pack.session);
+		}
+
+		vfs_dir_close(keys);
+	}
+
+	vfs_dir_close(hashes);
+}
+
+static int pack_compact_entry_cmp(const void *pa, const void *pb) {
+	const PackCompactEntry *a = pa;
+	const PackCompactEntry *b = pb;
+	return pack_name_cmp(a->name, strlen(a->name), b->name, strlen(b->name));
+}
+
+static bool pack_compact_write(PackCompactor *c, const char *path) {
+	uint32_t num_entries = c->entries.num_elements;
+	uint64_t names_ofs = PACK_HEADER_SIZE + (uint64_t)num_entries * PACK_INDEX_ENTRY_SIZE;
+	uint64_t data_ofs = names_ofs;
+
+	dynarray_foreach_elem(&c->entries, PackCompactEntry *e, {
+		data_ofs += strlen(e->name);
+	});
+
+	uint64_t total_size = data_ofs;
+
+	dynarray_foreach_elem(&c->entries, PackCompactEntry *e, {
+		total_size += e->blob.size;
+	});
+
+	if(total_size > PACK_MAX_SIZE) {
+		log_error("Compacted pack would be too large (%"PRIu64" bytes)", total_size);
+		return false;
+	}
+
+	// Everything up to the data is built in memory, then the entries' data is written as is.
+	uint8_t *meta = mem_alloc(data_ofs);
+	pack_write_header(meta, num_entries, total_size, pack.session);
+
+	uint32_t name_pos = names_ofs;
+	uint32_t data_pos = data_ofs;
+
+	dynarray_foreach(&c->entries, int i, PackCompactEntry *e, {
+		uint8_t *ie = meta + PACK_HEADER_SIZE + i * PACK_INDEX_ENTRY_SIZE;
+		size_t name_len = strlen(e->name);
+
+		write_le32(ie + 0, name_pos);
+		write_le32(ie + 4, name_len);
+		write_le32(ie + 8, data_pos);
+		write_le32(ie + 12, e->blob.size);
+		write_le32(ie + 16, e->last_used);
+
+		memcpy(meta + name_pos, e->name, name_len);
+		name_pos += name_len;
+		data_pos += e->blob.size;
+	});
+
+	SDL_RWops *out = pack_file_open(path, "wb");
+	bool ok = out != NULL;
+
+	if(out) {
+		ok = SDL_RWwrite(out, meta, data_ofs, 1) == 1;
+
+		dynarray_foreach_elem(&c->entries, PackCompactEntry *e, {
+			if(!ok) {
+				break;
+			}
+
+			ok = SDL_RWwrite(out, e->blob.data, e->blob.size, 1) == 1;
+		});
+
+		if(!ok) {
+			log_sdl_error(LOG_ERROR, "SDL_RWwrite");
+		}
+
+		SDL_RWclose(out);
+	}
+
+	mem_free(meta);
+	return ok;
+}
+
+bool shader_cache_compact(void) {
+	if(!pack.path) {
+		log_error("The shader cache pack is not available");
+		return false;
+	}
+
+	size_t old_size = pack.file.size;
+	PackCompactor c = { };
+	ht_create(&c.seen);
+
+	SDL_LockMutex(pack.mutex);
+	pack_compact_collect(&c);
+	SDL_UnlockMutex(pack.mutex);
+
+	pack_compact_import_dir(&c);
+
+	if(c.entries.num_elements) {
+		dynarray_qsort(&c.entries, pack_compact_entry_cmp);
+	}
+
+	char *tmp_path = strfmt("%s.tmp", pack.path);
+	bool ok = pack_compact_write(&c, tmp_path);
+
+	dynarray_foreach_elem(&c.entries, PackCompactEntry *e, {
+		mem_free(e->name);
+	});
+
+	dynarray_foreach_elem(&c.owned_data, uint8_t **data, {
+		mem_free(*data);
+	});
+
+	uint num_entries = c.entries.num_elements;
+	dynarray_free_data(&c.entries);
+	dynarray_free_data(&c.owned_data);
+	ht_destroy(&c.seen);
+
+	SDL_LockMutex(pack.mutex);
+
+	// The old file must be unmapped before it can be replaced on some systems.
+	pack_close_locked();
+	pack.needs_compaction = false;
+
+	if(ok) {
+		ok = pack_file_replace(tmp_path, pack.path);
+	} else {
+		pack_file_remove(tmp_path);
+	}
+
+	pack_open_locked();
+	SDL_UnlockMutex(pack.mutex);
+
+	if(ok) {
+		log_info(
+			"Compacted %s: %u entries (%u dropped, %u expired), %zu -> %zu bytes",
+			pack.path, num_entries, c.num_dropped, c.num_expired, old_size, pack.file.size
+		);
+
+		// Everything usable from the directory layout is in the pack now.
+		if(vfs_query(SHADER_CACHE_DIR).exists) {
+			shader_cache_dir_remove(SHADER_CACHE_DIR);
+		}
+	}
+
+	mem_free(tmp_path);
+	return ok;
+}
+
+static bool pack_has_expired_entries(void) {
+	for(uint32_t i = 0; i < pack.num_indexed; ++i) {
+		if(pack_session_expired(read_le32(pack.index + i * PACK_INDEX_ENTRY_SIZE + 16))) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool shader_cache_migrated(void) {
+	SDL_RWops *stream = vfs_open(SHADER_CACHE_MIGRATION_MARKER, VFS_MODE_READ);
+
+	if(!stream) {
+		return false;
+	}
+
+	char buf[16];
+	bool result = SDL_RWgets(stream, buf, sizeof(buf)) && strtol(buf, NULL, 10) >= SHADER_CACHE_MIGRATION_VERSION;
+	SDL_RWclose(stream);
+	return result;
+}
+
+static void shader_cache_set_migrated(void) {
+	SDL_RWops *stream = vfs_open(SHADER_CACHE_MIGRATION_MARKER, VFS_MODE_WRITE);
+
+	if(!stream) {
+		log_warn("VFS error: %s", vfs_get_error());
+		return;
+	}
+
+	SDL_RWprintf(stream, "%i\n", SHADER_CACHE_MIGRATION_VERSION);
+	SDL_RWclose(stream);
+}
+
+/*
+ * Public API
+ */
+
+void shader_cache_init(void) {
+	if(pack.mutex) {
+		return;
+	}
+
+	if(!(pack.mutex = SDL_CreateMutex())) {
+		log_sdl_error(LOG_ERROR, "SDL_CreateMutex");
+		return;
+	}
+
+	ht_create(&pack.tail);
+
+	if(!pack_resolve_path()) {
+		log_debug("The cache directory has no filesystem path; using the directory layout for shaders");
+		return;
+	}
+
+	pack.session = shader_cache_pack_open() ? pack.header_session + 1 : 1;
+
+	// Entries from the old directory layout are imported by compaction, which then deletes it.
+	// That's only attempted until it succeeds once, so a directory that can't be removed
+	// doesn't cause a compaction on every startup.
+	bool migrate = !shader_cache_migrated();
+
+	if(
+		pack.needs_compaction ||
+		pack.tail.num_elements_occupied >= PACK_MAX_TAIL_RECORDS ||
+		pack_has_expired_entries() ||
+		(migrate && vfs_query(SHADER_CACHE_DIR).exists)
+	) {
+		migrate = shader_cache_compact() && migrate;
+	}
+
+	if(migrate) {
+		shader_cache_set_migrated();
+	}
+}
+
+void shader_cache_shutdown(void) {
+	if(!pack.mutex) {
+		return;
+	}
+
+	if(pack.path && pack.valid_size) {
+		pack_file_write_usage();
+	}
+
+	pack_close_locked();
+	dynarray_free_data(&pack.new_records);
+	ht_destroy(&pack.tail);
+	mem_free(pack.path);
+	SDL_DestroyMutex(pack.mutex);
+	memset(&pack, 0, sizeof(pack));
+}
+
+bool shader_cache_get(const char *hash, const char *key, ShaderSource *entry) {
+	char name[SHADER_CACHE_MAX_NAME_LEN + 1];
+
+	if(!shader_cache_entry_name(hash, key, name)) {
+		return false;
+	}
+
+	ShaderCacheBlob blob;
+
+	if(shader_cache_pack_find(name, &blob)) {
+		bool result = shader_cache_decode_blob(blob, entry);
+
+		if(result) {
+			log_debug("Retrieved %s from cache", name);
+		}
+
+		return result;
+	}
+
+	if(pack.path || !shader_cache_dir_get(name, entry)) {
+		return false;
+	}
+
+	log_debug("Retrieved %s from the cache directory", name);
+	return true;
+}
+
 bool shader_cache_set(const char *hash, const char *key, const ShaderSource *src) {
+	char name[SHADER_CACHE_MAX_NAME_LEN + 1];
+
+	if(!shader_cache_entry_name(hash, key, name)) {
+		return false;
+	}
+
 	size_t entry_size;
 	uint8_t *entry = shader_cache_construct_entry(src, NULL, &entry_size);
 
-	if(entry != NULL) {
-		shader_cache_set_raw(hash, key, entry, entry_size);
-		mem_free(entry);
-		log_debug("Stored %s/%s in cache", hash, key);
-		return true;
+	if(entry == NULL) {
+		return false;
 	}
 
-	return false;
+	ShaderCacheBlob blob;
+	uint8_t *compressed = shader_cache_compress(entry, entry_size, &blob.size);
+	blob.data = compressed;
+	mem_free(entry);
+
+	if(pack.path) {
+		pack_append(name, blob);
+	} else {
+		shader_cache_dir_write(SHADER_CACHE_DIR, name, blob);
+	}
+
+	mem_free(compressed);
+	log_debug("Stored %s in cache", name);
+	return true;
 }
 
 bool shader_cache_hash(const ShaderSource *src, const ShaderMacro *macros, size_t buf_size, char out_buf[buf_size]) {
@@ -293,8 +1369,6 @@ bool shader_cache_hash(const ShaderSource *src, const ShaderMacro *macros, size_
 	sha256_hexdigest(entry, entry_size, out_buf, buf_size);
 	snprintf(out_buf + sha_size, buf_size - sha_size, "-%zx", entry_size);
 
-	// shader_cache_set_raw(out_buf, "orig", entry, entry_size);
-
 	mem_free(entry);
 	return true;
 }
@@ -25,3 +25,12 @@ bool shader_cache_get(const char *hash, const char *key, ShaderSource *out_src)
 
 bool shader_cache_set(const char *hash, const char *key, const ShaderSource *src)
 	attr_nonnull(1, 2, 3);
+
+// Opens the shader cache pack; must be called before any other shader cache function.
+void shader_cache_init(void);
+void shader_cache_shutdown(void);
+
+// Rewrites the pack, moving all live entries into its index. Corrupted entries, entries from
+// older cache versions and entries that haven't been used in a long while are dropped, and
+// entries from the old one-file-per-entry directory layout are imported.
+bool shader_cache_compact(void);
@@ -0,0 +1,53 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2026, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2026, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#pragma once
+#include "taisei.h"
+
+#include "cache.h"
+
+// Directory layout: one zstd-compressed entry per file, at <root>/<hash>/<key>.
+#define SHADER_CACHE_DIR "cache/shaders"
+
+// Entries are named "<hash>/<key>" in both layouts.
+#define SHADER_CACHE_MAX_NAME_LEN 255
+
+// A zstd-compressed cache entry, as stored on disk.
+typedef struct ShaderCacheBlob {
+	const uint8_t *data;
+	size_t size;
+} ShaderCacheBlob;
+
+typedef void (*ShaderCacheBlobVisitor)(const char *name, ShaderCacheBlob blob, void *arg);
+
+bool shader_cache_decode_blob(ShaderCacheBlob blob, ShaderSource *out_src)
+	attr_nonnull(2) attr_nodiscard;
+
+// Reads the raw contents of an entry stored in the directory layout; free the data with mem_free.
+bool shader_cache_dir_read(const char *root, const char *name, ShaderCacheBlob *out_blob)
+	attr_nonnull(1, 2, 3) attr_nodiscard;
+bool shader_cache_dir_write(const char *root, const char *name, ShaderCacheBlob blob)
+	attr_nonnull(1, 2);
+
+// Deletes a cache directory along with all its entries.
+bool shader_cache_dir_remove(const char *root)
+	attr_nonnull(1);
+
+// (Re)maps the pack file; returns false if it is unavailable.
+bool shader_cache_pack_open(void);
+void shader_cache_pack_close(void);
+size_t shader_cache_pack_size(void);
+const char *shader_cache_pack_path(void);
+
+// The returned blob stays valid until the pack is closed.
+bool shader_cache_pack_find(const char *name, ShaderCacheBlob *out_blob)
+	attr_nonnull(1, 2) attr_nodiscard;
+
+// Visits every live entry of the pack once, in no particular order.
+void shader_cache_pack_foreach(ShaderCacheBlobVisitor visit, void *arg)
+	attr_nonnull(1);
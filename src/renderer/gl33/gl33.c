@@ -29,7 +29,6 @@
 #include "util/env.h"
 
 // #define GL33_DEBUG_TEXUNITS
-// #define GL33_DRAW_STATS
 
 typedef struct TextureUnit {
 	LIST_INTERFACE(struct TextureUnit);
@@ -130,6 +129,8 @@ static struct {
 		hrtime_t draw_time;
 		uint draw_calls;
 		uint texture_rebinds;
+		uint uniform_commits;
+		uint uniform_uploads;
 	} stats;
 	#endif
 } R;
@@ -215,10 +216,18 @@ static inline void gl33_stats_post_draw(void) {
 	#endif
 }
 
+#ifdef GL33_DRAW_STATS
+void gl33_stats_uniform_sync(uint num_committed, uint num_uploaded) {
+	R.stats.uniform_commits += num_committed;
+	R.stats.uniform_uploads += num_uploaded;
+}
+#endif
+
 static inline void gl33_stats_post_frame(void) {
 	#ifdef GL33_DRAW_STATS
 	log_debug("%.1fµs spent in %u draw calls", R.stats.draw_time / (HRTIME_RESOLUTION / 1000000.0) , R.stats.draw_calls);
 	log_debug("%u texture rebinds", R.stats.texture_rebinds);
+	log_debug("%u uniforms committed, %u uploaded", R.stats.uniform_commits, R.stats.uniform_uploads);
 	memset(&R.stats, 0, sizeof(R.stats));
 	#endif
 }
@@ -15,6 +15,8 @@
 #include "../common/backend.h"
 #include "common_buffer.h"
 
+// #define GL33_DRAW_STATS
+
 typedef struct TextureUnit TextureUnit;
 
 typedef enum BufferBindingIndex {
@@ -29,6 +31,10 @@ typedef enum BufferBindingIndex {
 
 // Internal helper functions
 
+#ifdef GL33_DRAW_STATS
+void gl33_stats_uniform_sync(uint num_committed, uint num_uploaded);
+#endif
+
 GLenum gl33_prim_to_gl_prim(Primitive prim);
 void gl33_begin_draw(VertexArray *varr, void **state);
 void gl33_end_draw(void *state);
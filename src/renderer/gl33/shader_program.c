@@ -169,6 +169,15 @@ static MagicUniformSpec magic_unfiroms[] = {
 };
 static_assert_nomsg(ARRAY_SIZE(magic_unfiroms) == NUM_MAGIC_UNIFORMS);
 
+static void gl33_mark_uniform_dirty(Uniform *uniform) {
+	uint idx = uniform->index;
+
+	if(idx != INVALID_UNIFORM_INDEX) {
+		assert(idx < uniform->prog->active_uniforms.num_elements);
+		uniform->prog->dirty_uniforms.data[idx / 64] |= UINT64_C(1) << (idx % 64);
+	}
+}
+
 static void gl33_update_uniform(Uniform *uniform, uint offset, uint count, const void *data) {
 	// these are validated properly in gl33_uniform
 	assert(offset < uniform->array_size);
@@ -189,13 +198,17 @@ static void gl33_update_uniform(Uniform *uniform, uint offset, uint count, const
 	if(idx_last > uniform->cache.update_last_idx) {
 		uniform->cache.update_last_idx = idx_last;
 	}
+
+	gl33_mark_uniform_dirty(uniform);
 }
 
-static void gl33_commit_uniform(Uniform *uniform) {
+static uint gl33_commit_uniform(Uniform *uniform) {
 	if(uniform->cache.update_first_idx > uniform->cache.update_last_idx) {
-		return;
+		return 0;
 	}
 
+	uint uploaded = 0;
+
 	uint update_count = uniform->cache.update_last_idx - uniform->cache.update_first_idx + 1;
 	size_t update_ofs = uniform->cache.update_first_idx * uniform->elem_size;
 	size_t update_sz  = update_count * uniform->elem_size;
@@ -211,10 +224,13 @@ static void gl33_commit_uniform(Uniform *uniform) {
 			update_count,
 			uniform->cache.commited + update_ofs
 		);
+
+		uploaded = 1;
 	}
 
 	uniform->cache.update_first_idx = uniform->array_size;
 	uniform->cache.update_last_idx = 0;
+	return uploaded;
 }
 
 static GLuint get_texture_target(Texture *tex, UniformType utype) {
@@ -229,45 +245,60 @@ static GLuint get_texture_target(Texture *tex, UniformType utype) {
 	}
 }
 
-static void *gl33_sync_uniform(const char *key, void *value, void *arg) {
-	Uniform *uniform = value;
-
-	// special case: for sampler uniforms, we have to construct the actual data from the texture pointers array.
+static void gl33_sync_sampler(Uniform *uniform) {
+	// For sampler uniforms, we have to construct the actual data from the texture pointers array.
+	// The textures have to be bound on every sync, because texture units are not guaranteed to retain them between draws.
 	UniformType utype = uniform->type;
-	if(UNIFORM_TYPE_IS_SAMPLER(utype)) {
-		Uniform *size_uniform = uniform->size_uniform;
+	Uniform *size_uniform = uniform->size_uniform;
 
-		for(uint i = 0; i < uniform->array_size; ++i) {
-			Texture *tex = uniform->textures[i];
-			GLuint preferred_unit = CASTPTR_ASSUME_ALIGNED(uniform->cache.pending, int)[i];
-			GLuint unit = gl33_bind_texture(tex, get_texture_target(tex, utype), preferred_unit);
+	for(uint i = 0; i < uniform->array_size; ++i) {
+		Texture *tex = uniform->textures[i];
+		GLuint preferred_unit = CASTPTR_ASSUME_ALIGNED(uniform->cache.pending, int)[i];
+		GLuint unit = gl33_bind_texture(tex, get_texture_target(tex, utype), preferred_unit);
 
-			if(unit != preferred_unit) {
-				gl33_update_uniform(uniform, i, 1, &unit);
-			}
+		if(unit != preferred_unit) {
+			gl33_update_uniform(uniform, i, 1, &unit);
+		}
 
-			if(size_uniform) {
-				uint w, h;
+		if(size_uniform && (!tex || uniform->cache.sized_textures[i] != tex)) {
+			uint w, h;
 
-				if(tex) {
-					r_texture_get_size(tex, 0, &w, &h);
-				} else {
-					w = h = 0;
-				}
-
-				vec2_noalign size = { w, h };
-				gl33_update_uniform(size_uniform, i, 1, &size);
-				gl33_commit_uniform(size_uniform);
+			if(tex) {
+				r_texture_get_size(tex, 0, &w, &h);
+			} else {
+				w = h = 0;
 			}
+
+			vec2_noalign size = { w, h };
+			gl33_update_uniform(size_uniform, i, 1, &size);
+			uniform->cache.sized_textures[i] = tex;
 		}
 	}
-
-	gl33_commit_uniform(uniform);
-	return NULL;
 }
 
 void gl33_sync_uniforms(ShaderProgram *prog) {
-	ht_foreach(&prog->uniforms, gl33_sync_uniform, NULL);
+	dynarray_foreach_elem(&prog->samplers, Uniform **u, {
+		gl33_sync_sampler(*u);
+	});
+
+	uint num_committed = 0, num_uploaded = 0;
+
+	dynarray_foreach(&prog->dirty_uniforms, uint word_idx, uint64_t *word, {
+		for(uint64_t bits = *word; bits; bits &= bits - 1) {
+			uint idx = word_idx * 64 + __builtin_ctzll(bits);
+			num_uploaded += gl33_commit_uniform(dynarray_get(&prog->active_uniforms, idx));
+			++num_committed;
+		}
+
+		*word = 0;
+	});
+
+	#ifdef GL33_DRAW_STATS
+	gl33_stats_uniform_sync(num_committed, num_uploaded);
+	#else
+	(void)num_committed;
+	(void)num_uploaded;
+	#endif
 }
 
 void gl33_uniform(Uniform *uniform, uint offset, uint count, const void *data) {
@@ -302,6 +333,54 @@ void gl33_uniform(Uniform *uniform, uint offset, uint count, const void *data) {
 	}
 }
 
+static void index_uniforms(ShaderProgram *prog) {
+	prog->active_uniforms.num_elements = 0;
+	prog->samplers.num_elements = 0;
+
+	ht_str2ptr_iter_t iter;
+	ht_iter_begin(&prog->uniforms, &iter);
+
+	for(; iter.has_data; ht_iter_next(&iter)) {
+		Uniform *u = NOT_NULL(iter.value);
+
+		if(u->array_size == 0) {
+			// deactivated by gl33_shader_program_transfer
+			u->index = INVALID_UNIFORM_INDEX;
+			continue;
+		}
+
+		u->index = prog->active_uniforms.num_elements;
+		*dynarray_append(&prog->active_uniforms) = u;
+
+		if(UNIFORM_TYPE_IS_SAMPLER(u->type)) {
+			*dynarray_append(&prog->samplers) = u;
+		}
+	}
+
+	ht_iter_end(&iter);
+
+	// Everything starts out dirty, so that changes made before indexing are not lost.
+	uint num_words = (prog->active_uniforms.num_elements + 63) / 64;
+	prog->dirty_uniforms.num_elements = 0;
+	dynarray_ensure_capacity(&prog->dirty_uniforms, num_words);
+
+	for(uint i = 0; i < num_words; ++i) {
+		*dynarray_append(&prog->dirty_uniforms) = UINT64_MAX;
+	}
+
+	uint tail_bits = prog->active_uniforms.num_elements % 64;
+
+	if(tail_bits) {
+		dynarray_set(&prog->dirty_uniforms, num_words - 1, (UINT64_C(1) << tail_bits) - 1);
+	}
+}
+
+static void free_uniform_index(ShaderProgram *prog) {
+	dynarray_free_data(&prog->active_uniforms);
+	dynarray_free_data(&prog->samplers);
+	dynarray_free_data(&prog->dirty_uniforms);
+}
+
 static bool cache_uniforms(ShaderProgram *prog) {
 	int maxlen = 0;
 	GLint unicount;
@@ -321,7 +400,7 @@ static bool cache_uniforms(ShaderProgram *prog) {
 	for(int i = 0; i < unicount; ++i) {
 		GLenum type;
 		GLint size, loc;
-		Uniform uni = { .prog = prog };
+		Uniform uni = { .prog = prog, .index = INVALID_UNIFORM_INDEX };
 
 		glGetActiveUniform(prog->gl_handle, i, maxlen, NULL, &size, &type, name);
 		loc = glGetUniformLocation(prog->gl_handle, name);
@@ -458,13 +537,30 @@ static bool cache_uniforms(ShaderProgram *prog) {
 			}
 		}
 
+		if(u->size_uniform) {
+			u->cache.sized_textures = ALLOC_ARRAY(u->array_size, typeof(*u->cache.sized_textures));
+		}
+
 		ht_iter_next(&iter);
 	}
 	ht_iter_end(&iter);
 
+	index_uniforms(prog);
 	return true;
 }
 
+static void invalidate_sized_texture(Uniform *u, Texture *tex) {
+	if(!u->cache.sized_textures) {
+		return;
+	}
+
+	for(uint i = 0; i < u->array_size; ++i) {
+		if(u->cache.sized_textures[i] == tex) {
+			u->cache.sized_textures[i] = NULL;
+		}
+	}
+}
+
 void gl33_unref_texture_from_samplers(Texture *tex) {
 	for(Uniform *u = sampler_uniforms; u; u = u->next) {
 		assert(UNIFORM_TYPE_IS_SAMPLER(u->type));
@@ -479,6 +575,8 @@ void gl33_unref_texture_from_samplers(Texture *tex) {
 				*slot = NULL;
 			}
 		}
+
+		invalidate_sized_texture(u, tex);
 	}
 }
 
@@ -492,6 +590,10 @@ void gl33_uniforms_handle_texture_pointer_renamed(Texture *pold, Texture *pnew)
 				*slot = pnew;
 			}
 		}
+
+		// The texture may have been replaced with one of a different size.
+		invalidate_sized_texture(u, pold);
+		invalidate_sized_texture(u, pnew);
 	}
 }
 
@@ -521,6 +623,7 @@ static void *free_uniform(const char *key, void *data, void *arg) {
 	mem_free(uniform->textures);
 	mem_free(uniform->cache.commited);
 	mem_free(uniform->cache.pending);
+	mem_free(uniform->cache.sized_textures);
 	mem_free(uniform);
 	return NULL;
 }
@@ -530,6 +633,7 @@ void gl33_shader_program_destroy(ShaderProgram *prog) {
 	glDeleteProgram(prog->gl_handle);
 	ht_foreach(&prog->uniforms, free_uniform, NULL);
 	ht_destroy(&prog->uniforms);
+	free_uniform_index(prog);
 	mem_free(prog);
 }
 
@@ -628,6 +732,7 @@ bool gl33_shader_program_transfer(ShaderProgram *dst, ShaderProgram *src) {
 		mem_free(uold->textures);
 		mem_free(uold->cache.pending);
 		mem_free(uold->cache.commited);
+		mem_free(uold->cache.sized_textures);
 
 		if(unew) {
 			uold->textures = unew->textures;
@@ -653,6 +758,7 @@ bool gl33_shader_program_transfer(ShaderProgram *dst, ShaderProgram *src) {
 			uold->textures = NULL;
 			uold->cache.pending = NULL;
 			uold->cache.commited = NULL;
+			uold->cache.sized_textures = NULL;
 		}
 	}
 
@@ -684,7 +790,10 @@ bool gl33_shader_program_transfer(ShaderProgram *dst, ShaderProgram *src) {
 
 	ht_destroy(&old_new_map);
 	ht_destroy(&src->uniforms);
+	free_uniform_index(src);
 	mem_free(src);
 
+	index_uniforms(dst);
+
 	return true;
 }
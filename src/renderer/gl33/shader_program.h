@@ -11,6 +11,7 @@
 
 #include "util.h"
 #include "hashtable.h"
+#include "dynarray.h"
 #include "../api.h"
 #include "opengl.h"
 #include "resource/shader_program.h"
@@ -33,10 +34,19 @@ struct ShaderProgram {
 	GLuint gl_handle;
 	ht_str2ptr_t uniforms;
 	Uniform *magic_uniforms[NUM_MAGIC_UNIFORMS];
+
+	// Active uniforms in a flat array, indexed by Uniform.index.
+	DYNAMIC_ARRAY(Uniform*) active_uniforms;
+	// The sampler uniforms among them; these must be synced on every draw to bind their textures.
+	DYNAMIC_ARRAY(Uniform*) samplers;
+	// One bit per active uniform that has pending changes.
+	DYNAMIC_ARRAY(uint64_t) dirty_uniforms;
+
 	char debug_label[R_DEBUG_LABEL_SIZE];
 };
 
 #define INVALID_UNIFORM_LOCATION 0xffffffff
+#define INVALID_UNIFORM_INDEX 0xffffffff
 
 struct Uniform {
 	// these are for sampler uniforms
@@ -47,6 +57,7 @@ struct Uniform {
 	size_t elem_size; // bytes
 	uint array_size; // elements
 	uint location;
+	uint index;  // in prog->active_uniforms
 	UniformType type;
 
 	// corresponding _SIZE uniform (for samplers; optional)
@@ -57,6 +68,9 @@ struct Uniform {
 		char *pending;
 		char *commited;
 
+		// for samplers with a size_uniform: textures whose sizes it currently holds
+		Texture **sized_textures;
+
 		uint update_first_idx;
 		uint update_last_idx;
 	} cache;
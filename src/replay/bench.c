@@ -0,0 +1,195 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2026, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2026, Andrei Alexeyev <akari@taisei-project.org>.
+*/
+
+#include "taisei.h"
+
+#include "bench.h"
+#include "profiler.h"
+#include "stageobjects.h"
+#include "util.h"
+
+typedef DYNAMIC_ARRAY(hrtime_t) BenchSamples;
+
+typedef struct BenchPoolPeak {
+	char tag[32];
+	size_t peak_usage;
+	size_t capacity;
+	uint num_slabs;
+} BenchPoolPeak;
+
+static bool _replay_bench_active;
+
+static struct {
+	// Indexed by profiler zone
+	BenchSamples samples[PROF_MAX_ZONES];
+	hrtime_t first_frame_time;
+	hrtime_t last_frame_time;
+	uint64_t last_prof_frame;
+	uint num_frames;
+	DYNAMIC_ARRAY(BenchPoolPeak) pool_peaks;
+} bench;
+
+void replay_bench_init(void) {
+	assert(!_replay_bench_active);
+	memset(&bench, 0, sizeof(bench));
+	prof_enable();
+	bench.last_prof_frame = prof_num_frames();
+	_replay_bench_active = true;
+}
+
+void replay_bench_shutdown(void) {
+	for(uint i = 0; i < ARRAY_SIZE(bench.samples); ++i) {
+		dynarray_free_data(bench.samples + i);
+	}
+
+	dynarray_free_data(&bench.pool_peaks);
+	_replay_bench_active = false;
+}
+
+void replay_bench_frame_end(void) {
+	if(!_replay_bench_active) {
+		return;
+	}
+
+	uint64_t prof_frame = prof_num_frames();
+
+	if(prof_frame == bench.last_prof_frame) {
+		// No main loop iteration since the last call; nothing new to collect.
+		return;
+	}
+
+	bench.last_prof_frame = prof_frame;
+	hrtime_t now = time_get();
+
+	if(!bench.num_frames) {
+		// Count wall time from the end of the first instrumented frame; close enough.
+		bench.first_frame_time = now;
+	}
+
+	uint num_zones = prof_num_zones();
+
+	for(uint i = 0; i < num_zones; ++i) {
+		BenchSamples *s = bench.samples + i;
+
+		// Zones register when first entered; they took no time in the frames before that.
+		while(s->num_elements < bench.num_frames) {
+			*dynarray_append(s) = 0;
+		}
+
+		*dynarray_append(s) = prof_get_zone_last(i);
+	}
+
+	bench.last_frame_time = now;
+	++bench.num_frames;
+}
+
+void replay_bench_sample_objpools(void) {
+	if(!_replay_bench_active) {
+		return;
+	}
+
+	ObjectPool **pools = &stage_object_pools.first;
+	uint num_pools = sizeof(stage_object_pools) / sizeof(*pools);
+
+	for(uint i = 0; i < num_pools; ++i) {
+		ObjectPoolStats stats;
+		objpool_get_stats(pools[i], &stats);
+
+		BenchPoolPeak *peak = NULL;
+
+		dynarray_foreach_elem(&bench.pool_peaks, BenchPoolPeak *p, {
+			if(!strcmp(p->tag, stats.tag)) {
+				peak = p;
+				break;
+			}
+		});
+
+		if(!peak) {
+			// Copy the tag; the pool is about to be freed along with it.
+			peak = dynarray_append(&bench.pool_peaks);
+			*peak = (BenchPoolPeak) { };
+			strlcpy(peak->tag, stats.tag, sizeof(peak->tag));
+		}
+
+		peak->peak_usage = umax(peak->peak_usage, stats.peak_usage);
+		peak->capacity = umax(peak->capacity, stats.capacity);
+		peak->num_slabs = umax(peak->num_slabs, stats.num_slabs);
+	}
+}
+
+static int cmp_hrtime(const void *a, const void *b) {
+	hrtime_t ta = *(const hrtime_t*)a;
+	hrtime_t tb = *(const hrtime_t*)b;
+	return (ta > tb) - (ta < tb);
+}
+
+INLINE double to_usec(hrtime_t t) {
+	return t * 1e6 / HRTIME_RESOLUTION;
+}
+
+void replay_bench_write_report(SDL_RWops *out) {
+	replay_bench_frame_end();
+
+	uint n = bench.num_frames;
+	double wall_time = (bench.last_frame_time - bench.first_frame_time) / (double)HRTIME_RESOLUTION;
+
+	SDL_RWprintf(out, "{\n");
+	SDL_RWprintf(out, "  \"frames\": %u,\n", n);
+	SDL_RWprintf(out, "  \"wall_time_sec\": %.6f,\n", wall_time);
+	SDL_RWprintf(out, "  \"fps\": %.2f,\n", wall_time > 0 ? (n - 1) / wall_time : 0.0);
+	SDL_RWprintf(out, "  \"zones_usec\": {\n");
+
+	uint num_zones = prof_num_zones();
+
+	for(uint i = 0; i < num_zones; ++i) {
+		BenchSamples *s = bench.samples + i;
+		hrtime_t total = 0, p50 = 0, p99 = 0, pmax = 0;
+
+		if(s->num_elements > 0) {
+			dynarray_foreach_elem(s, hrtime_t *t, {
+				total += *t;
+			});
+
+			qsort(s->data, s->num_elements, sizeof(*s->data), cmp_hrtime);
+			p50 = dynarray_get(s, (s->num_elements - 1) * 50 / 100);
+			p99 = dynarray_get(s, (s->num_elements - 1) * 99 / 100);
+			pmax = dynarray_get(s, s->num_elements - 1);
+		}
+
+		ProfZoneStats stats;
+		prof_get_zone_stats(i, &stats);
+
+		SDL_RWprintf(out,
+			"    \"%s\": { \"total\": %.1f, \"mean\": %.3f, \"p50\": %.3f, \"p99\": %.3f, \"max\": %.3f }%s\n",
+			stats.name,
+			to_usec(total),
+			n ? to_usec(total) / n : 0.0,
+			to_usec(p50),
+			to_usec(p99),
+			to_usec(pmax),
+			i + 1 < num_zones ? "," : ""
+		);
+	}
+
+	SDL_RWprintf(out, "  },\n");
+	SDL_RWprintf(out, "  \"objpools\": {\n");
+
+	dynarray_foreach(&bench.pool_peaks, int i, BenchPoolPeak *p, {
+		SDL_RWprintf(out,
+			"    \"%s\": { \"peak_usage\": %zu, \"capacity\": %zu, \"slabs\": %u }%s\n",
+			p->tag,
+			p->peak_usage,
+			p->capacity,
+			p->num_slabs,
+			i + 1 < bench.pool_peaks.num_elements ? "," : ""
+		);
+	});
+
+	SDL_RWprintf(out, "  }\n");
+	SDL_RWprintf(out, "}\n");
+}
@@ -0,0 +1,42 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2026, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2026, Andrei Alexeyev <akari@taisei-project.org>.
+*/
+
+#pragma once
+#include "taisei.h"
+
+#include <SDL.h>
+
+/*
+ * Per-frame CPU timings collected while running a replay with --bench-replay.
+ * The timings come from the profiler zones (see profiler.h), which the benchmark enables, so this
+ * is only available in builds with the profiler compiled in.
+ */
+
+#ifdef TAISEI_BUILDCONF_PROFILER
+
+void replay_bench_init(void);
+void replay_bench_shutdown(void);
+
+// Collects the profiler zone timings of the last closed profiler frame, if not collected yet.
+void replay_bench_frame_end(void);
+
+// Records peak usage of the stage object pools; call before they are freed.
+void replay_bench_sample_objpools(void);
+
+// Writes the JSON report.
+void replay_bench_write_report(SDL_RWops *out) attr_nonnull_all;
+
+#else
+
+INLINE void replay_bench_init(void) { }
+INLINE void replay_bench_shutdown(void) { }
+INLINE void replay_bench_frame_end(void) { }
+INLINE void replay_bench_sample_objpools(void) { }
+INLINE void replay_bench_write_report(SDL_RWops *out) { }
+
+#endif
@@ -17,6 +17,7 @@
 #include "config.h"
 #include "events.h"
 #include "renderer/api.h"
+#include "taskmanager.h"
 #include "util.h"
 #include "util/glm.h"
 #include "util/graphics.h"
@@ -317,38 +318,57 @@ static FT_Face load_font_face(char *vfspath, long index) {
 		return NULL;
 	}
 
-	log_info("Loaded font '%s' (face %li)", syspath, index);
 	return face;
 }
 
-static FT_Error set_font_size(Font *fnt, uint pxsize, double scale) {
-	FT_Error err = FT_Err_Ok;
+static void free_font_face(FT_Face face) {
+	FT_Stream stream = face->stream;
+	FT_Done_Face_Thread_Safe(face);
 
-	assert(fnt != NULL);
-	assert(fnt->face != NULL);
+	if(stream) {
+		mem_free(stream->pathname.pointer);
+		mem_free(stream);
+	}
+}
+
+static FT_Error set_face_size(FT_Face face, FT_Stroker *stroker, uint pxsize, double scale) {
+	FT_Error err = FT_Err_Ok;
 
 	FT_Fixed fixed_scale = round(scale * (2 << 15));
 	pxsize = FT_MulFix(pxsize * 64, fixed_scale);
 
-	if((err = FT_Set_Char_Size(fnt->face, 0, pxsize, 0, 0))) {
+	if((err = FT_Set_Char_Size(face, 0, pxsize, 0, 0))) {
 		log_error("FT_Set_Char_Size(%u) failed: %s", pxsize, ft_error_str(err));
 		return err;
 	}
 
-	if(fnt->stroker) {
-		FT_Stroker_Done(fnt->stroker);
+	if(*stroker) {
+		FT_Stroker_Done(*stroker);
+		*stroker = NULL;
 	}
 
-	if((err = FT_Stroker_New(globals.lib, &fnt->stroker))) {
+	if((err = FT_Stroker_New(globals.lib, stroker))) {
 		log_error("FT_Stroker_New() failed: %s", ft_error_str(err));
 		return err;
 	}
 
-	FT_Stroker_Set(fnt->stroker, FT_MulFix(1.5 * 64, fixed_scale), FT_STROKER_LINECAP_ROUND, FT_STROKER_LINEJOIN_ROUND, 0);
+	FT_Stroker_Set(*stroker, FT_MulFix(1.5 * 64, fixed_scale), FT_STROKER_LINECAP_ROUND, FT_STROKER_LINEJOIN_ROUND, 0);
+	return err;
+}
+
+static FT_Error set_font_size(Font *fnt, uint pxsize, double scale) {
+	FT_Error err = FT_Err_Ok;
+
+	assert(fnt != NULL);
+	assert(fnt->face != NULL);
+
+	if((err = set_face_size(fnt->face, &fnt->stroker, pxsize, scale))) {
+		return err;
+	}
 
 	// Based on SDL_ttf
 	FT_Face face = fnt->face;
-	fixed_scale = face->size->metrics.y_scale;
+	FT_Fixed fixed_scale = face->size->metrics.y_scale;
 	fnt->metrics.ascent = FT_CEIL(FT_MulFix(face->ascender, fixed_scale));
 	fnt->metrics.descent = FT_CEIL(FT_MulFix(face->descender, fixed_scale));
 	fnt->metrics.max_glyph_height = fnt->metrics.ascent - fnt->metrics.descent;
@@ -408,17 +428,9 @@ static SpriteSheet* add_spritesheet(SpriteSheetAnchor *spritesheets) {
 // The padding is needed to prevent glyph edges from bleeding in due to linear filtering.
 #define GLYPH_SPRITE_PADDING 1
 
-static bool add_glyph_to_spritesheet(Glyph *glyph, Pixmap *pixmap, SpriteSheet *ss) {
-	uint padded_w = pixmap->width + 2 * GLYPH_SPRITE_PADDING;
-	uint padded_h = pixmap->height + 2 * GLYPH_SPRITE_PADDING;
-
-	glyph->spritesheet_section = rectpack_add(ss->rectpack, padded_w, padded_h);
-
-	if(glyph->spritesheet_section == NULL) {
-		return false;
-	}
-
+static void upload_glyph(Glyph *glyph, Pixmap *pixmap, SpriteSheet *ss, RectPackSection *section) {
 	glyph->spritesheet = ss;
+	glyph->spritesheet_section = section;
 
 	cmplx ofs = GLYPH_SPRITE_PADDING * (1+I);
 
@@ -447,7 +459,19 @@ static bool add_glyph_to_spritesheet(Glyph *glyph, Pixmap *pixmap, SpriteSheet *
 	});
 
 	++ss->glyphs;
+}
+
+static bool add_glyph_to_spritesheet(Glyph *glyph, Pixmap *pixmap, SpriteSheet *ss) {
+	uint padded_w = pixmap->width + 2 * GLYPH_SPRITE_PADDING;
+	uint padded_h = pixmap->height + 2 * GLYPH_SPRITE_PADDING;
 
+	RectPackSection *section = rectpack_add(ss->rectpack, padded_w, padded_h);
+
+	if(section == NULL) {
+		return false;
+	}
+
+	upload_glyph(glyph, pixmap, ss, section);
 	return true;
 }
 
@@ -484,27 +508,44 @@ static void delete_spritesheet(SpriteSheetAnchor *spritesheets, SpriteSheet *ss)
 	mem_free(ss);
 }
 
-static Glyph* load_glyph(Font *font, FT_UInt gindex, SpriteSheetAnchor *spritesheets) {
+typedef struct RasterizedGlyph {
+	GlyphMetrics metrics;
+	// data is NULL for invisible glyphs
+	Pixmap pixmap;
+	FT_UInt ft_index;
+	bool ok;
+
+	// Optionally, where to put the glyph, if space was already allocated for it
+	SpriteSheet *spritesheet;
+	RectPackSection *spritesheet_section;
+} RasterizedGlyph;
+
+// Renders a glyph into a CPU-side pixmap. Safe to call from any thread, as long as the face
+// and stroker are not used by any other thread at the same time.
+static bool rasterize_glyph(FT_Face face, FT_Stroker stroker, FT_UInt gindex, RasterizedGlyph *out) {
 	// log_debug("Loading glyph 0x%08x", gindex);
 
-	FT_Error err = FT_Load_Glyph(font->face, gindex, FT_LOAD_NO_BITMAP | FT_LOAD_TARGET_LIGHT);
+	FT_Error err = FT_Load_Glyph(face, gindex, FT_LOAD_NO_BITMAP | FT_LOAD_TARGET_LIGHT);
 
 	if(err) {
 		log_warn("FT_Load_Glyph(%u) failed: %s", gindex, ft_error_str(err));
-		return NULL;
+		return false;
 	}
 
-	Glyph *glyph = dynarray_append(&font->glyphs);
-
-	glyph->metrics.bearing_x = FT_FLOOR(font->face->glyph->metrics.horiBearingX);
-	glyph->metrics.bearing_y = FT_FLOOR(font->face->glyph->metrics.horiBearingY);
-	glyph->metrics.width = FT_CEIL(font->face->glyph->metrics.width);
-	glyph->metrics.height = FT_CEIL(font->face->glyph->metrics.height);
-	glyph->metrics.advance = FT_CEIL(font->face->glyph->metrics.horiAdvance);
+	*out = (RasterizedGlyph) {
+		.ft_index = gindex,
+		.metrics = {
+			.bearing_x = FT_FLOOR(face->glyph->metrics.horiBearingX),
+			.bearing_y = FT_FLOOR(face->glyph->metrics.horiBearingY),
+			.width = FT_CEIL(face->glyph->metrics.width),
+			.height = FT_CEIL(face->glyph->metrics.height),
+			.advance = FT_CEIL(face->glyph->metrics.horiAdvance),
+		},
+	};
 
 	FT_Glyph g_src = NULL, g_fill = NULL, g_border = NULL, g_inner = NULL;
 	FT_BitmapGlyph g_bm_fill = NULL, g_bm_border = NULL, g_bm_inner = NULL;
-	FT_Get_Glyph(font->face->glyph, &g_src);
+	FT_Get_Glyph(face->glyph, &g_src);
 	FT_Glyph_Copy(g_src, &g_fill);
 	FT_Glyph_Copy(g_src, &g_border);
 	FT_Glyph_Copy(g_src, &g_inner);
@@ -517,14 +558,12 @@ static Glyph* load_glyph(Font *font, FT_UInt gindex, SpriteSheetAnchor *spritesh
 		have_bitmap = ((FT_BitmapGlyph)g_fill)->bitmap.width > 0;
 	}
 
-	if(!have_bitmap) {
-		// Some glyphs may be invisible, but we still need the metrics data for them (e.g. space)
-		memset(&glyph->sprite, 0, sizeof(Sprite));
-	} else {
-		FT_Glyph_StrokeBorder(&g_border, font->stroker, false, true);
+	// Some glyphs may be invisible, but we still need the metrics data for them (e.g. space)
+	if(have_bitmap) {
+		FT_Glyph_StrokeBorder(&g_border, stroker, false, true);
 		FT_Glyph_To_Bitmap(&g_border, FT_RENDER_MODE_LIGHT, NULL, true);
 
-		FT_Glyph_StrokeBorder(&g_inner, font->stroker, true, true);
+		FT_Glyph_StrokeBorder(&g_inner, stroker, true, true);
 		FT_Glyph_To_Bitmap(&g_inner, FT_RENDER_MODE_LIGHT, NULL, true);
 
 		g_bm_fill = (FT_BitmapGlyph)g_fill;
@@ -547,8 +586,7 @@ static Glyph* load_glyph(Font *font, FT_UInt gindex, SpriteSheetAnchor *spritesh
 			FT_Done_Glyph(g_fill);
 			FT_Done_Glyph(g_border);
 			FT_Done_Glyph(g_inner);
-			font->glyphs.num_elements--;
-			return NULL;
+			return false;
 		}
 
 		Pixmap px;
@@ -612,48 +650,75 @@ static Glyph* load_glyph(Font *font, FT_UInt gindex, SpriteSheetAnchor *spritesh
 			}
 		}
 
+		out->pixmap = px;
+	}
+
+	FT_Done_Glyph(g_src);
+	FT_Done_Glyph(g_fill);
+	FT_Done_Glyph(g_border);
+	FT_Done_Glyph(g_inner);
+
+	return true;
+}
+
+// Adds a rasterized glyph to the font and uploads its bitmap into a spritesheet.
+// Must be called on the main thread. Takes ownership of the pixmap data.
+static Glyph* commit_glyph(Font *font, RasterizedGlyph *rg, SpriteSheetAnchor *spritesheets) {
+	Glyph *glyph = dynarray_append(&font->glyphs);
+	glyph->metrics = rg->metrics;
+
+	Pixmap *px = &rg->pixmap;
+
+	if(!px->data.untyped) {
+		memset(&glyph->sprite, 0, sizeof(Sprite));
+	} else {
 		TextureTypeQueryResult qr = { 0 };
 
 		// TODO: Only query this once on init.
-		if(r_texture_type_query(SS_TEXTURE_TYPE, SS_TEXTURE_FLAGS, px.format, px.origin, &qr)) {
-			pixmap_convert_inplace_realloc(&px, qr.optimal_pixmap_format);
-			pixmap_flip_to_origin_inplace(&px, qr.optimal_pixmap_origin);
+		if(r_texture_type_query(SS_TEXTURE_TYPE, SS_TEXTURE_FLAGS, px->format, px->origin, &qr)) {
+			pixmap_convert_inplace_realloc(px, qr.optimal_pixmap_format);
+			pixmap_flip_to_origin_inplace(px, qr.optimal_pixmap_origin);
 		} else {
 			log_error("Texture query failed!");
 			assert(0);
 		}
 
-		if(!add_glyph_to_spritesheets(glyph, &px, spritesheets)) {
+		if(rg->spritesheet_section) {
+			upload_glyph(glyph, px, rg->spritesheet, rg->spritesheet_section);
+		} else if(!add_glyph_to_spritesheets(glyph, px, spritesheets)) {
 			log_error(
 				"Glyph %u fill can't fit into any spritesheets (padded bitmap size: %ux%u; max spritesheet size: %ux%u)",
-				gindex,
-				px.width + 2 * GLYPH_SPRITE_PADDING,
-				px.height + 2 * GLYPH_SPRITE_PADDING,
+				rg->ft_index,
+				px->width + 2 * GLYPH_SPRITE_PADDING,
+				px->height + 2 * GLYPH_SPRITE_PADDING,
 				SS_WIDTH,
 				SS_HEIGHT
 			);
 
-			mem_free(px.data.rg8);
-			FT_Done_Glyph(g_src);
-			FT_Done_Glyph(g_fill);
-			FT_Done_Glyph(g_border);
-			FT_Done_Glyph(g_inner);
+			mem_free(px->data.untyped);
+			px->data.untyped = NULL;
 			--font->glyphs.num_elements;
 			return NULL;
 		}
 
-		mem_free(px.data.rg8);
+		mem_free(px->data.untyped);
+		px->data.untyped = NULL;
 	}
 
-	FT_Done_Glyph(g_src);
-	FT_Done_Glyph(g_fill);
-	FT_Done_Glyph(g_border);
-	FT_Done_Glyph(g_inner);
-
-	glyph->ft_index = gindex;
+	glyph->ft_index = rg->ft_index;
 	return glyph;
 }
 
+static Glyph* load_glyph(Font *font, FT_UInt gindex, SpriteSheetAnchor *spritesheets) {
+	RasterizedGlyph rg;
+
+	if(!rasterize_glyph(font->face, font->stroker, gindex, &rg)) {
+		return NULL;
+	}
+
+	return commit_glyph(font, &rg, spritesheets);
+}
+
 static Glyph* get_glyph(Font *fnt, charcode_t cp) {
 	int64_t ofs;
 
@@ -678,6 +743,190 @@ static Glyph* get_glyph(Font *fnt, charcode_t cp) {
 	return ofs < 0 ? NULL : dynarray_get_ptr(&fnt->glyphs, ofs);
 }
 
+// Below this many glyphs, prewarming isn't worth opening extra faces for.
+#define GLYPH_PREWARM_MIN_PER_TASK 16
+
+typedef struct GlyphPrewarmJob {
+	Font *font;
+	RasterizedGlyph *glyphs;
+	uint num_glyphs;
+} GlyphPrewarmJob;
+
+static void rasterize_glyphs(FT_Face face, FT_Stroker stroker, RasterizedGlyph *glyphs, uint num_glyphs) {
+	for(uint i = 0; i < num_glyphs; ++i) {
+		glyphs[i].ok = rasterize_glyph(face, stroker, glyphs[i].ft_index, glyphs + i);
+	}
+}
+
+static void *glyph_prewarm_task(void *arg) {
+	GlyphPrewarmJob *job = arg;
+	Font *font = job->font;
+
+	// FreeType faces are not thread-safe, so every task opens its own.
+	FT_Face face = load_font_face(font->source_path, font->base_face_idx);
+
+	if(!face) {
+		// The main thread will load these glyphs itself.
+		return NULL;
+	}
+
+	FT_Stroker stroker = NULL;
+
+	if(!set_face_size(face, &stroker, font->base_size, font->metrics.scale)) {
+		rasterize_glyphs(face, stroker, job->glyphs, job->num_glyphs);
+	}
+
+	if(stroker) {
+		FT_Stroker_Done(stroker);
+	}
+
+	free_font_face(face);
+	return NULL;
+}
+
+// Allocates spritesheet space for a batch of glyphs at once, which packs them more tightly.
+static void pack_rasterized_glyphs(uint num_glyphs, RasterizedGlyph glyphs[num_glyphs], SpriteSheetAnchor *spritesheets) {
+	auto requests = ALLOC_ARRAY(num_glyphs, RectPackRequest);
+	auto request_glyphs = ALLOC_ARRAY(num_glyphs, RasterizedGlyph*);
+	uint num_requests = 0;
+
+	for(uint i = 0; i < num_glyphs; ++i) {
+		RasterizedGlyph *rg = glyphs + i;
+
+		if(rg->ok && rg->pixmap.data.untyped) {
+			request_glyphs[num_requests] = rg;
+			requests[num_requests++] = (RectPackRequest) {
+				.width = rg->pixmap.width + 2 * GLYPH_SPRITE_PADDING,
+				.height = rg->pixmap.height + 2 * GLYPH_SPRITE_PADDING,
+			};
+		}
+	}
+
+	uint num_remaining = num_requests;
+	SpriteSheet *ss = spritesheets->first;
+
+	while(num_remaining > 0) {
+		bool new_sheet = false;
+
+		if(!ss) {
+			ss = add_spritesheet(spritesheets);
+			new_sheet = true;
+		}
+
+		uint num_added = rectpack_add_batch(ss->rectpack, num_requests, requests);
+
+		for(uint i = 0; i < num_requests; ++i) {
+			if(requests[i].section && !request_glyphs[i]->spritesheet_section) {
+				request_glyphs[i]->spritesheet = ss;
+				request_glyphs[i]->spritesheet_section = requests[i].section;
+			}
+		}
+
+		if(new_sheet && num_added == 0) {
+			// Whatever is left can't fit anywhere; commit_glyph will report it.
+			delete_spritesheet(spritesheets, ss);
+			break;
+		}
+
+		num_remaining -= num_added;
+		ss = ss->next;
+	}
+
+	mem_free(requests);
+	mem_free(request_glyphs);
+}
+
+void font_prewarm_ucs4(Font *font, const uint32_t *charset) {
+	DYNAMIC_ARRAY(RasterizedGlyph) pending = { };
+	ht_int2int_t pending_set;
+	ht_create(&pending_set);
+
+	for(const uint32_t *c = charset; *c; ++c) {
+		if(ht_lookup(&font->charcodes_to_glyph_ofs, *c, NULL)) {
+			continue;
+		}
+
+		FT_UInt ft_index = FT_Get_Char_Index(font->face, *c);
+
+		if(
+			ft_index == 0 ||
+			ht_lookup(&font->ftindex_to_glyph_ofs, ft_index, NULL) ||
+			ht_lookup(&pending_set, ft_index, NULL)
+		) {
+			continue;
+		}
+
+		ht_set(&pending_set, ft_index, 1);
+		*dynarray_append(&pending) = (RasterizedGlyph) { .ft_index = ft_index };
+	}
+
+	ht_destroy(&pending_set);
+
+	if(pending.num_elements == 0) {
+		dynarray_free_data(&pending);
+		return;
+	}
+
+	uint num_jobs = imin(SDL_GetCPUCount(), pending.num_elements / GLYPH_PREWARM_MIN_PER_TASK);
+
+	if(num_jobs > 1) {
+		GlyphPrewarmJob jobs[num_jobs];
+		Task *tasks[num_jobs];
+		uint per_job = (pending.num_elements + num_jobs - 1) / num_jobs;
+
+		for(uint i = 0; i < num_jobs; ++i) {
+			uint first = i * per_job;
+			jobs[i] = (GlyphPrewarmJob) {
+				.font = font,
+				.glyphs = pending.data + first,
+				.num_glyphs = imin(per_job, pending.num_elements - first),
+			};
+			tasks[i] = taskmgr_global_submit((TaskParams) { glyph_prewarm_task, jobs + i });
+
+			if(!tasks[i]) {
+				glyph_prewarm_task(jobs + i);
+			}
+		}
+
+		for(uint i = 0; i < num_jobs; ++i) {
+			if(tasks[i]) {
+				task_finish(tasks[i], NULL);
+			}
+		}
+	} else {
+		rasterize_glyphs(font->face, font->stroker, pending.data, pending.num_elements);
+	}
+
+	pack_rasterized_glyphs(pending.num_elements, pending.data, &globals.spritesheets);
+
+	// Commit in charset order, so that the glyph array doesn't depend on thread timing.
+	dynarray_foreach_elem(&pending, RasterizedGlyph *rg, {
+		Glyph *glyph;
+
+		if(rg->ok) {
+			glyph = commit_glyph(font, rg, &globals.spritesheets);
+		} else {
+			glyph = load_glyph(font, rg->ft_index, &globals.spritesheets);
+		}
+
+		int64_t ofs = glyph ? dynarray_indexof(&font->glyphs, glyph) : -1;
+		ht_set(&font->ftindex_to_glyph_ofs, rg->ft_index, ofs);
+	});
+
+	dynarray_free_data(&pending);
+
+	// Now fill in the charcode mappings. This is cheap, since all the glyphs are cached.
+	for(const uint32_t *c = charset; *c; ++c) {
+		get_glyph(font, *c);
+	}
+}
+
+void font_prewarm(Font *font, const char *charset) {
+	uint32_t *ucs4 = utf8_to_ucs4_alloc(charset);
+	font_prewarm_ucs4(font, ucs4);
+	mem_free(ucs4);
+}
+
 attr_nonnull(1)
 static void wipe_glyph_cache(Font *font) {
 	dynarray_foreach_elem(&font->glyphs, Glyph *g, {
@@ -708,13 +957,7 @@ static void wipe_glyph_cache(Font *font) {
 
 static void free_font_resources(Font *font) {
 	if(font->face) {
-		FT_Stream stream = font->face->stream;
-		FT_Done_Face_Thread_Safe(font->face);
-
-		if(stream) {
-			mem_free(stream->pathname.pointer);
-			mem_free(stream);
-		}
+		free_font_face(font->face);
 	}
 
 	if(font->stroker) {
@@ -758,8 +1001,11 @@ void load_font(ResourceLoadState *st) {
 	if(!(font.face = load_font_face(font.source_path, font.base_face_idx))) {
 		free_font_resources(&font);
 		res_load_failed(st);
+		return;
 	}
 
+	log_info("Loaded font '%s' (face %li)", (char*)font.face->stream->pathname.pointer, font.base_face_idx);
+
 	if(set_font_size(&font, font.base_size, global_font_scale())) {
 		free_font_resources(&font);
 		res_load_failed(st);
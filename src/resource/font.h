@@ -89,6 +89,12 @@ double font_get_lineskip(Font *font) attr_nonnull(1);
 
 const GlyphMetrics* font_get_char_metrics(Font *font, charcode_t c) attr_nonnull(1);
 
+// Rasterize and upload all glyphs needed to draw the characters in [charset] ahead of time,
+// so that drawing them for the first time doesn't cause a frame spike.
+// Large batches are rasterized in parallel on the global task manager.
+void font_prewarm(Font *font, const char *charset) attr_nonnull(1, 2);
+void font_prewarm_ucs4(Font *font, const uint32_t *charset) attr_nonnull(1, 2);
+
 double text_draw(const char *text, const TextParams *params) attr_nonnull(1, 2);
 double text_ucs4_draw(const uint32_t *text, const TextParams *params) attr_nonnull(1, 2);
 
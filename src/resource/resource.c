@@ -60,6 +60,14 @@ typedef enum LoadStatus {
 	LOAD_CONT,
 } LoadStatus;
 
+typedef enum AsyncLoadEventCode {
+	// data1 is an InternalResource awaiting finalization on the main thread
+	ASYNCLOAD_FINALIZE,
+
+	// Some load has finished; re-examine the resources that are waiting for their dependencies
+	ASYNCLOAD_WAKE,
+} AsyncLoadEventCode;
+
 typedef struct InternalResource InternalResource;
 typedef struct InternalResLoadState InternalResLoadState;
 
@@ -126,6 +134,11 @@ struct InternalResource {
 	// For simplicity of implementation, this is a counted set (a multiset)
 	ht_ires_counted_set_t dependents;
 
+	// When the last load of this resource started and finished; used for the startup report.
+	// Written by whichever thread runs the load, so access is guarded by res_gstate.timing_lock.
+	hrtime_t load_begin;
+	hrtime_t load_end;
+
 #if DEBUG_LOCKS
 	SDL_atomic_t num_locks;
 #endif
@@ -146,7 +159,9 @@ typedef struct FileWatchHandlerData {
 
 static struct {
 	hrtime_t frame_threshold;
+	hrtime_t init_time;
 	uchar loaded_this_frame : 1;
+	uchar startup_report_pending : 1;
 	struct {
 		uchar no_async_load : 1;
 		uchar no_preload : 1;
@@ -166,6 +181,19 @@ static struct {
 
 	// Static data for filewatch event handler
 	FileWatchHandlerData fw_handler_data;
+
+	// Resources whose finalization on the main thread is blocked by dependencies that are still
+	// loading. These are revisited whenever some other load finishes (see ASYNCLOAD_WAKE).
+	// Main thread only.
+	IResPtrArray awaiting_deps;
+
+	// Set while an ASYNCLOAD_WAKE event is queued, so that they don't pile up.
+	SDL_atomic_t wake_pending;
+
+	SDL_atomic_t loads_in_flight;
+
+	// Guards InternalResource.load_begin and .load_end.
+	SDL_SpinLock timing_lock;
 } res_gstate;
 
 INLINE ResourceHandler *get_handler(ResourceType type) {
@@ -659,6 +687,12 @@ static ResourceStatus pump_or_wait_for_resource_load_nolock(
 
 		Task *task = load_state->async_task;
 
+		if(task && pump_only && task_status(task) == TASK_RUNNING) {
+			// Being loaded by another thread right now. Don't block on it; whoever is pumping
+			// will be notified via ASYNCLOAD_WAKE once it's done.
+			return RES_STATUS_LOADING;
+		}
+
 		if(task) {
 			// If there's an async load task for this resource, wait for it to complete.
 			// If it's not yet running, it will be offloaded to this thread instead.
@@ -848,7 +882,7 @@ retry:
 					st->status = LOAD_CONT_ON_MAIN;
 					st->ready_to_finalize = true;
 					ires_cond_broadcast(ires);
-					events_emit(TE_RESOURCE_ASYNC_LOADED, 0, ires, NULL);
+					events_emit(TE_RESOURCE_ASYNC_LOADED, ASYNCLOAD_FINALIZE, ires, NULL);
 					break;
 				} else {
 					st->status = LOAD_NONE;
@@ -864,7 +898,7 @@ retry:
 			if(pump_dependencies(st) == RES_STATUS_LOADING || !is_main_thread()) {
 				st->ready_to_finalize = true;
 				ires_cond_broadcast(ires);
-				events_emit(TE_RESOURCE_ASYNC_LOADED, 0, ires, NULL);
+				events_emit(TE_RESOURCE_ASYNC_LOADED, ASYNCLOAD_FINALIZE, ires, NULL);
 				break;
 			}
 		// fallthrough
@@ -924,6 +958,14 @@ static bool unload_resource(InternalResource *ires) {
 	SDL_PumpEvents();
 	SDL_FilterEvents(filter_asyncload_event, ires);
 
+	uint num_awaiting = 0;
+	dynarray_foreach_elem(&res_gstate.awaiting_deps, InternalResource **pawaiting, {
+		if(*pawaiting != ires) {
+			dynarray_get(&res_gstate.awaiting_deps, num_awaiting++) = *pawaiting;
+		}
+	});
+	res_gstate.awaiting_deps.num_elements = num_awaiting;
+
 	ires_unmake_dependent(ires, &ires->dependencies);
 	ires_remove_watched_paths(ires);
 
@@ -975,35 +1017,114 @@ static bool should_defer_load(InternalResLoadState *st) {
 	return false;
 }
 
-static bool resource_asyncload_handler(SDL_Event *evt, void *arg) {
-	assert(is_main_thread());
+static void resource_load_done(void) {
+	SDL_AtomicDecRef(&res_gstate.loads_in_flight);
 
-	InternalResource *ires = evt->user.data1;
-	InternalResLoadState *st = ires->load;
+	if(!res_gstate.env.no_async_load && SDL_AtomicCAS(&res_gstate.wake_pending, 0, 1)) {
+		events_emit(TE_RESOURCE_ASYNC_LOADED, ASYNCLOAD_WAKE, NULL, NULL);
+	}
+}
 
-	if(st == NULL) {
-		return true;
+typedef struct ResLoadTimes {
+	hrtime_t begin;
+	hrtime_t end;
+} ResLoadTimes;
+
+static ResLoadTimes ires_get_load_times(InternalResource *ires) {
+	SDL_AtomicLock(&res_gstate.timing_lock);
+	ResLoadTimes t = { ires->load_begin, ires->load_end };
+	SDL_AtomicUnlock(&res_gstate.timing_lock);
+	return t;
+}
+
+static void resource_report_startup(void) {
+	// Walk back from the resource that finished last, each time following the dependency that
+	// finished last while its dependent was already loading, i.e. the one that held it up.
+
+	InternalResource *last = NULL;
+	ResLoadTimes last_times = { 0 };
+	ht_str2ptr_ts_iter_t iter;
+	uint num_loaded = 0;
+
+	for(ResourceType type = 0; type < RES_NUMTYPES; ++type) {
+		ht_iter_begin(&get_handler(type)->private.mapping, &iter);
+
+		for(; iter.has_data; ht_iter_next(&iter)) {
+			InternalResource *ires = iter.value;
+			ResLoadTimes t = ires_get_load_times(ires);
+
+			if(t.end) {
+				++num_loaded;
+
+				if(!last || t.end > last_times.end) {
+					last = ires;
+					last_times = t;
+				}
+			}
+		}
+
+		ht_iter_end(&iter);
 	}
 
-	if(should_defer_load(st)) {
-		events_defer(evt);
-		return true;
+	if(!last) {
+		return;
 	}
 
-	ires_lock(ires);
+	log_info(
+		"%u resources loaded in %.2f ms since init; critical path:",
+		num_loaded, (last_times.end - res_gstate.init_time) * 1e3 / HRTIME_RESOLUTION
+	);
 
-	ResourceStatus dep_status = pump_dependencies(st);
+	for(InternalResource *ires = last, *next; ires; ires = next) {
+		ResLoadTimes t = ires_get_load_times(ires);
 
-	if(dep_status == RES_STATUS_LOADING) {
-		// log_debug("Deferring %s '%s' because some dependencies are not satisfied", type_name(ires->res.type), st->st.name);
+		log_info(
+			"    %s '%s': %.2f ms",
+			type_name(ires->res.type), ires->name,
+			(t.end - t.begin) * 1e3 / HRTIME_RESOLUTION
+		);
 
-		// FIXME: Make this less braindead.
-		// This will retry every frame until dependencies are satisfied.
+		next = NULL;
+		hrtime_t next_end = 0;
+
+		dynarray_foreach_elem(&ires->dependencies, InternalResource **pdep, {
+			InternalResource *dep = *pdep;
+			hrtime_t dep_end = ires_get_load_times(dep).end;
+
+			if(
+				dep_end > t.begin &&
+				dep_end < t.end &&
+				(!next || dep_end > next_end)
+			) {
+				next = dep;
+				next_end = dep_end;
+			}
+		});
+	}
+}
+
+static void resource_check_startup_report(void) {
+	if(res_gstate.startup_report_pending && SDL_AtomicGet(&res_gstate.loads_in_flight) == 0) {
+		res_gstate.startup_report_pending = false;
+		resource_report_startup();
+	}
+}
+
+static bool resource_asyncload_try_finalize(InternalResource *ires) {
+	ires_lock(ires);
+
+	InternalResLoadState *st = ires->load;
+
+	if(st == NULL) {
 		ires_unlock(ires);
-		events_defer(evt);
 		return true;
 	}
 
+	if(pump_dependencies(st) == RES_STATUS_LOADING) {
+		ires_unlock(ires);
+		return false;
+	}
+
 	Task *task = st->async_task;
 	assert(!task || ires->status == RES_STATUS_LOADING);
 	st->async_task = NULL;
@@ -1028,6 +1149,63 @@ static bool resource_asyncload_handler(SDL_Event *evt, void *arg) {
 	return true;
 }
 
+static void resource_asyncload_wake(SDL_Event *evt) {
+	SDL_AtomicSet(&res_gstate.wake_pending, 0);
+
+	IResPtrArray *awaiting = &res_gstate.awaiting_deps;
+	uint num_awaiting = 0;
+	bool deferred = false;
+
+	dynarray_foreach_elem(awaiting, InternalResource **pires, {
+		InternalResource *ires = *pires;
+
+		if(!deferred && ires->load && should_defer_load(ires->load)) {
+			deferred = true;
+		}
+
+		if(deferred || !resource_asyncload_try_finalize(ires)) {
+			dynarray_get(awaiting, num_awaiting++) = ires;
+		}
+	});
+
+	awaiting->num_elements = num_awaiting;
+
+	if(deferred && SDL_AtomicCAS(&res_gstate.wake_pending, 0, 1)) {
+		events_defer(evt);
+	}
+
+	resource_check_startup_report();
+}
+
+static bool resource_asyncload_handler(SDL_Event *evt, void *arg) {
+	assert(is_main_thread());
+
+	if(evt->user.code == ASYNCLOAD_WAKE) {
+		resource_asyncload_wake(evt);
+		return true;
+	}
+
+	InternalResource *ires = evt->user.data1;
+	InternalResLoadState *st = ires->load;
+
+	if(st == NULL) {
+		return true;
+	}
+
+	if(should_defer_load(st)) {
+		events_defer(evt);
+		return true;
+	}
+
+	if(!resource_asyncload_try_finalize(ires)) {
+		// Some dependencies are not satisfied yet. Park it until another load finishes.
+		// log_debug("Deferring %s '%s' because some dependencies are not satisfied", type_name(ires->res.type), st->st.name);
+		*dynarray_append(&res_gstate.awaiting_deps) = ires;
+	}
+
+	return true;
+}
+
 static InternalResLoadState *make_persistent_loadstate(InternalResLoadState *st_transient) {
 	if(st_transient->ires->load != NULL) {
 		assert(st_transient->ires->load == st_transient);
@@ -1075,6 +1253,13 @@ static void load_resource(
 	name = ires->name;
 	path = handler->procs.find(name);
 
+	hrtime_t load_begin = time_get();
+	SDL_AtomicLock(&res_gstate.timing_lock);
+	ires->load_begin = load_begin;
+	ires->load_end = 0;
+	SDL_AtomicUnlock(&res_gstate.timing_lock);
+	SDL_AtomicIncRef(&res_gstate.loads_in_flight);
+
 	if(path) {
 		assert(handler->procs.check(path));
 	} else {
@@ -1255,6 +1440,12 @@ static void load_resource_finish(InternalResLoadState *st) {
 	mem_free(ires->load);
 	ires->load = NULL;
 
+	hrtime_t load_end = time_get();
+	SDL_AtomicLock(&res_gstate.timing_lock);
+	ires->load_end = load_end;
+	SDL_AtomicUnlock(&res_gstate.timing_lock);
+	resource_load_done();
+
 	ires_cond_broadcast(ires);
 	assert(ires->status != RES_STATUS_LOADING);
 
@@ -1491,6 +1682,7 @@ static bool resource_filewatch_handler(SDL_Event *e, void *a) {
 }
 
 void init_resources(void) {
+	res_gstate.init_time = time_get();
 	res_gstate.env.no_async_load = env_get("TAISEI_NOASYNC", false);
 	res_gstate.env.no_preload = env_get("TAISEI_NOPRELOAD", false);
 	res_gstate.env.no_unload = env_get("TAISEI_NOUNLOAD", false);
@@ -1619,6 +1811,9 @@ void load_resources(void) {
 		log_info("Attempting to load all resources now due to TAISEI_AGGRESSIVE_PRELOAD");
 		vfs_dir_walk("res/", preload_all, NULL);
 	}
+
+	res_gstate.startup_report_pending = true;
+	resource_check_startup_report();
 }
 
 static void _free_resources(IResPtrArray *tmp_ires_array, bool all) {
@@ -1701,6 +1896,7 @@ void shutdown_resources(void) {
 
 	ht_watch2iresset_destroy(&res_gstate.watch_to_iresset);
 	res_gstate.ires_freelist = NULL;
+	dynarray_free_data(&res_gstate.awaiting_deps);
 
 	if(!res_gstate.env.no_async_load) {
 		events_unregister_handler(resource_asyncload_handler);
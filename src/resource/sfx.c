@@ -22,6 +22,13 @@ static bool check_sound_path(const char *path) {
 	return sfxbgm_check_path(SFX_PATH_PREFIX, path, false);
 }
 
+static void load_sound_stage2(ResourceLoadState *st) {
+	SFX *sfx = st->opaque;
+	// Resolve the handle here rather than on first play, which may be in the middle of a frame.
+	audio_sfx_bind_handle(sfx, st->name);
+	res_load_finished(st, sfx);
+}
+
 static void load_sound(ResourceLoadState *st) {
 	SFX *sfx = audio_sfx_load(st->name, st->path);
 
@@ -30,7 +37,7 @@ static void load_sound(ResourceLoadState *st) {
 		return;
 	}
 
-	res_load_finished(st, sfx);
+	res_load_continue_on_main(st, load_sound_stage2, sfx);
 }
 
 static void unload_sound(void *vsnd) {
@@ -166,6 +166,16 @@ static void load_shader_object_stage2(ResourceLoadState *st) {
 	}
 }
 
+static void init_shader_objects(void) {
+	shader_cache_init();
+	spirv_init_compiler();
+}
+
+static void shutdown_shader_objects(void) {
+	spirv_shutdown_compiler();
+	shader_cache_shutdown();
+}
+
 static void unload_shader_object(void *vsha) {
 	r_shader_object_destroy(vsha);
 }
@@ -180,8 +190,8 @@ ResourceHandler shader_object_res_handler = {
 	.subdir = SHOBJ_PATH_PREFIX,
 
 	.procs = {
-		.init = spirv_init_compiler,
-		.shutdown = spirv_shutdown_compiler,
+		.init = init_shader_objects,
+		.shutdown = shutdown_shader_objects,
 		.find = shader_object_path,
 		.check = check_shader_object_path,
 		.load = load_shader_object_stage1,
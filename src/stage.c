@@ -16,6 +16,8 @@
 #include "replay/state.h"
 #include "replay/stage.h"
 #include "replay/struct.h"
+#include "profiler.h"
+#include "replay/bench.h"
 #include "config.h"
 #include "player.h"
 #include "menu/ingamemenu.h"
@@ -562,10 +564,17 @@ static void stage_input(StageFrameState *fstate) {
 static void stage_logic(void) {
 	process_boss(&global.boss);
 	process_enemies(&global.enemies);
+
+	PROF_BEGIN("process_projectiles", prof_projs);
 	process_projectiles(&global.projs, true);
+	PROF_END(prof_projs);
+
 	process_items();
 	process_lasers();
+
+	PROF_BEGIN("process_particles", prof_particles);
 	process_projectiles(&global.particles, false);
+	PROF_END(prof_particles);
 
 	if(global.dialog) {
 		dialog_update(global.dialog);
@@ -647,7 +656,7 @@ static bool proximity_predicate(EntityInterface *ent, void *varg) {
 	switch(ent->type) {
 		case ENT_TYPE_ID(Projectile): {
 			Projectile *p = ENT_CAST(ent, Projectile);
-			return cabs(p->pos - area->origin) < area->radius;
+			return point_in_circle_bbox(p->pos, *area) && cabs(p->pos - area->origin) < area->radius;
 		}
 
 		case ENT_TYPE_ID(Laser): {
@@ -659,18 +668,23 @@ static bool proximity_predicate(EntityInterface *ent, void *varg) {
 	}
 }
 
+typedef struct EllipseArea {
+	Ellipse ellipse;
+	Rect bbox;
+} EllipseArea;
+
 static bool ellipse_predicate(EntityInterface *ent, void *varg) {
-	Ellipse *e = varg;
+	EllipseArea *area = varg;
 
 	switch(ent->type) {
 		case ENT_TYPE_ID(Projectile): {
 			Projectile *p = ENT_CAST(ent, Projectile);
-			return point_in_ellipse(p->pos, *e);
+			return point_in_ellipse_with_bbox(p->pos, area->ellipse, area->bbox);
 		}
 
 		case ENT_TYPE_ID(Laser): {
 			Laser *l = ENT_CAST(ent, Laser);
-			return laser_intersects_ellipse(l, *e);
+			return laser_intersects_ellipse(l, area->ellipse);
 		}
 
 		default: UNREACHABLE;
@@ -683,7 +697,8 @@ void stage_clear_hazards_at(cmplx origin, double radius, ClearHazardsFlags flags
 }
 
 void stage_clear_hazards_in_ellipse(Ellipse e, ClearHazardsFlags flags) {
-	stage_clear_hazards_predicate(ellipse_predicate, &e, flags);
+	EllipseArea area = { e, ellipse_bbox(e) };
+	stage_clear_hazards_predicate(ellipse_predicate, &area, flags);
 }
 
 TASK(clear_dialog) {
@@ -861,6 +876,7 @@ static LogicFrameAction stage_logic_frame(void *arg) {
 	StageFrameState *fstate = arg;
 	StageInfo *stage = fstate->stage;
 
+	replay_bench_frame_end();
 	stage_update_fps(fstate);
 
 	if(stage_is_skip_mode()) {
@@ -966,7 +982,9 @@ static RenderFrameAction stage_render_frame(void *arg) {
 	rng_lock(&global.rand_game);
 	rng_make_active(&global.rand_visual);
 	BEGIN_DRAW_CODE();
+	PROF_BEGIN("stage_draw_scene", prof_scene);
 	stage_draw_scene(stage);
+	PROF_END(prof_scene);
 	END_DRAW_CODE();
 	rng_unlock(&global.rand_game);
 	rng_make_active(&global.rand_game);
@@ -1173,6 +1191,7 @@ void stage_end_loop(void *ctx) {
 	free_all_refs();
 	ent_shutdown();
 	rng_make_active(&global.rand_visual);
+	replay_bench_sample_objpools();
 	stage_objpools_free();
 	stop_all_sfx();
 
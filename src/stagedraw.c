@@ -16,6 +16,7 @@
 #include "entity.h"
 #include "util/fbmgr.h"
 #include "replay/struct.h"
+#include "profiler.h"
 
 #ifdef DEBUG
 	#define GRAPHS_DEFAULT 1
@@ -28,6 +29,9 @@
 #define SPELL_INTRO_DURATION 120
 #define SPELL_INTRO_TIME_FACTOR 0.8
 
+// Number of samples the graph shader takes; must be kept in sync with POINTS in graph.frag.glsl.
+#define GRAPH_SHADER_POINTS 120
+
 static struct {
 	struct {
 		ShaderProgram *shader;
@@ -66,6 +70,10 @@ static struct {
 	bool framerate_graphs;
 	bool objpool_stats;
 
+	#ifdef TAISEI_BUILDCONF_PROFILER
+		bool profiler_overlay;
+	#endif
+
 	#ifdef DEBUG
 		Sprite dummy;
 	#endif
@@ -328,12 +336,39 @@ void stage_draw_pre_init(void) {
 			"monotiny",
 		NULL);
 	}
+
+#ifdef TAISEI_BUILDCONF_PROFILER
+	stagedraw.profiler_overlay = env_get("TAISEI_PROFILER_OVERLAY", 0);
+
+	if(stagedraw.profiler_overlay) {
+		preload_resources(RES_SHADER_PROGRAM, RESF_PERMANENT,
+			"graph",
+		NULL);
+
+		preload_resources(RES_FONT, RESF_PERMANENT,
+			"monotiny",
+		NULL);
+	}
+#endif
 }
 
 void stage_draw_init(void) {
 	stagedraw.viewport_pp = get_resource_data(RES_POSTPROCESS, "viewport", RESF_OPTIONAL);
 	stagedraw.hud_text.shader = res_shader("text_hud");
 	stagedraw.hud_text.font = res_font("standard");
+
+	// Glyphs are cached across stages, so this only does real work the first time.
+	const char *charset =
+		" !\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~";
+	font_prewarm(stagedraw.hud_text.font, charset);
+	font_prewarm(res_font("small"), charset);
+	font_prewarm(res_font("mono"), charset);
+
+	// Dialog text is drawn with the standard font, and uses these on top of ASCII (see src/dialog).
+	font_prewarm(stagedraw.hud_text.font, "‘’“”—…ōū");
+
+	// Titles of the stage clear and spell bonus tables; their rows use the standard font.
+	font_prewarm(res_font("big"), charset);
 	stagedraw.shaders.fxaa = res_shader("fxaa");
 	stagedraw.shaders.copy_depth = res_shader("copy_depth");
 
@@ -1512,9 +1547,8 @@ void stage_draw_bottom_text(void) {
 		static int max = 0;
 		float graph[framespan];
 
-		if(graphspan > 120) {
-			// shader limitation
-			graphspan = 120;
+		if(graphspan > GRAPH_SHADER_POINTS) {
+			graphspan = GRAPH_SHADER_POINTS;
 		}
 
 		// hack to update the graph every frame
@@ -1601,6 +1635,59 @@ static void stage_draw_framerate_graphs(float x, float y, float w, float h) {
 	r_state_pop();
 }
 
+#ifdef TAISEI_BUILDCONF_PROFILER
+static_assert(PROF_HISTORY == GRAPH_SHADER_POINTS, "The profiler overlay draws one point per frame of history");
+
+static void stage_draw_profiler_overlay(float x, float y, float w) {
+	static float samples[PROF_HISTORY];
+	Font *font = res_font("monotiny");
+	float h = font_get_lineskip(font);
+	uint num_zones = prof_num_zones();
+
+	r_state_push();
+
+	// Full height is one whole frame's worth of time.
+	for(uint i = 0; i < num_zones; ++i) {
+		r_shader("graph");
+		prof_get_zone_graph(i, HRTIME_RESOLUTION / FPS, samples);
+		r_uniform_vec3("color_low",  0.0, 0.6, 1.0);
+		r_uniform_vec3("color_mid",  1.0, 1.0, 0.0);
+		r_uniform_vec3("color_high", 1.0, 0.0, 0.0);
+		r_uniform_float_array("points[0]", 0, PROF_HISTORY, samples);
+		draw_graph(x, y + i * h, w, h);
+	}
+
+	r_shader("text_default");
+
+	for(uint i = 0; i < num_zones; ++i) {
+		ProfZoneStats stats;
+		char buf[32];
+		prof_get_zone_stats(i, &stats);
+
+		snprintf(buf, sizeof(buf), "%6.3f | %6.3f ms",
+			stats.avg * 1e3 / HRTIME_RESOLUTION,
+			stats.max * 1e3 / HRTIME_RESOLUTION
+		);
+
+		float ty = y + (i + 0.8) * h;
+
+		text_draw(stats.name, &(TextParams) {
+			.pos = { x + 2, ty },
+			.font_ptr = font,
+			.align = ALIGN_LEFT,
+		});
+
+		text_draw(buf, &(TextParams) {
+			.pos = { x + w - 2, ty },
+			.font_ptr = font,
+			.align = ALIGN_RIGHT,
+		});
+	}
+
+	r_state_pop();
+}
+#endif
+
 void stage_draw_hud(void) {
 	// Background
 	r_mat_mv_push();
@@ -1810,6 +1897,12 @@ void stage_draw_hud(void) {
 			.color = RGBA(1 - red, 1 - red, 1 - red, 1 - red),
 		});
 	}
+
+#ifdef TAISEI_BUILDCONF_PROFILER
+	if(stagedraw.profiler_overlay) {
+		stage_draw_profiler_overlay(VIEWPORT_X + 8, VIEWPORT_Y + 8, 240);
+	}
+#endif
 }
 
 void stage_display_clear_screen(const StageClearBonus *bonus) {
@@ -94,7 +94,7 @@ TASK(TShoot, { BoxedBoss boss; real ang; real ang_s; real dist; real spd_inc; re
 
 		bool phase2 = t > 0.6 * time;
 
-		play_sfx(phase2 ? "shot1" : "shot2");
+		(play_sfx)(phase2 ? "shot1" : "shot2");
 
 		PROJECTILE(
 			.proto = phase2 ? pp_crystal : pp_card,
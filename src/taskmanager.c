@@ -17,6 +17,7 @@ struct TaskManager {
 	SDL_mutex *mutex;
 	SDL_cond *cond;
 	uint numthreads;
+	uint numidle;
 	uint running : 1;
 	uint aborted : 1;
 	SDL_atomic_t numtasks;
@@ -32,7 +33,9 @@ struct Task {
 	int prio;
 	SDL_mutex *mutex;
 	SDL_cond *cond;
-	TaskStatus status;
+	// TaskStatus; transitions out of TASK_PENDING are claimed with a CAS, so that cancelling and
+	// starting a task doesn't need the mutex. Everything else is written under the mutex.
+	SDL_atomic_t status;
 	void *result;
 	uint disowned : 1;
 	uint in_queue : 1;
@@ -40,6 +43,17 @@ struct Task {
 
 static TaskManager *g_taskmgr;
 
+// Released tasks are recycled along with their mutex and cond, so that submitting a task
+// normally doesn't have to create any kernel objects. Tasks released past TASK_POOL_MAX_FREE are
+// destroyed, so that a burst of submissions doesn't pin its kernel objects forever.
+#define TASK_POOL_MAX_FREE 256
+
+static struct {
+	SDL_SpinLock lock;
+	Task *freelist;
+	uint num_free;
+} task_pool;
+
 static void taskmgr_free(TaskManager *mgr) {
 	if(mgr->mutex != NULL) {
 		SDL_DestroyMutex(mgr->mutex);
@@ -52,6 +66,56 @@ static void taskmgr_free(TaskManager *mgr) {
 	mem_free(mgr);
 }
 
+static void task_destroy(Task *task) {
+	if(task->mutex != NULL) {
+		SDL_DestroyMutex(task->mutex);
+	}
+
+	if(task->cond != NULL) {
+		SDL_DestroyCond(task->cond);
+	}
+
+	mem_free(task);
+}
+
+static Task *task_alloc(const TaskParams *params, TaskStatus status) {
+	SDL_AtomicLock(&task_pool.lock);
+	Task *task = task_pool.freelist;
+	if(task) {
+		task_pool.freelist = task->next;
+		--task_pool.num_free;
+	}
+	SDL_AtomicUnlock(&task_pool.lock);
+
+	if(task == NULL) {
+		task = ALLOC(Task);
+
+		if(!(task->mutex = SDL_CreateMutex())) {
+			log_sdl_error(LOG_WARN, "SDL_CreateMutex");
+			task_destroy(task);
+			return NULL;
+		}
+
+		if(!(task->cond = SDL_CreateCond())) {
+			log_sdl_error(LOG_WARN, "SDL_CreateCond");
+			task_destroy(task);
+			return NULL;
+		}
+	}
+
+	task->next = task->prev = NULL;
+	task->callback = params->callback;
+	task->userdata_free_callback = params->userdata_free_callback;
+	task->userdata = params->userdata;
+	task->prio = params->prio;
+	task->result = NULL;
+	task->disowned = false;
+	task->in_queue = false;
+	SDL_AtomicSet(&task->status, status);
+
+	return task;
+}
+
 static void task_free(Task *task) {
 	assert(!task->in_queue);
 	assert(task->disowned);
@@ -60,15 +124,54 @@ static void task_free(Task *task) {
 		task->userdata_free_callback(task->userdata);
 	}
 
-	if(task->mutex != NULL) {
-		SDL_DestroyMutex(task->mutex);
+	SDL_AtomicLock(&task_pool.lock);
+	bool pooled = task_pool.num_free < TASK_POOL_MAX_FREE;
+	if(pooled) {
+		task->next = task_pool.freelist;
+		task_pool.freelist = task;
+		++task_pool.num_free;
 	}
+	SDL_AtomicUnlock(&task_pool.lock);
 
-	if(task->cond != NULL) {
-		SDL_DestroyCond(task->cond);
+	if(!pooled) {
+		task_destroy(task);
 	}
+}
 
-	mem_free(task);
+static void task_pool_shutdown(void) {
+	SDL_AtomicLock(&task_pool.lock);
+	Task *freelist = task_pool.freelist;
+	task_pool.freelist = NULL;
+	task_pool.num_free = 0;
+	SDL_AtomicUnlock(&task_pool.lock);
+
+	for(Task *next; freelist; freelist = next) {
+		next = freelist->next;
+		task_destroy(freelist);
+	}
+}
+
+INLINE TaskStatus task_get_status(Task *task) {
+	return SDL_AtomicGet(&task->status);
+}
+
+INLINE bool task_claim(Task *task, TaskStatus new_status) {
+	return SDL_AtomicCAS(&task->status, TASK_PENDING, new_status);
+}
+
+// task_wait reads the result without the mutex once it sees TASK_FINISHED, so the result must be
+// visible before the status is.
+INLINE void task_publish_result(Task *task, void *result) {
+	task->result = result;
+	SDL_MemoryBarrierRelease();
+	SDL_AtomicSet(&task->status, TASK_FINISHED);
+}
+
+static void task_complete(Task *task, void *result) {
+	SDL_LockMutex(task->mutex);
+	task_publish_result(task, result);
+	SDL_CondBroadcast(task->cond);
+	SDL_UnlockMutex(task->mutex);
 }
 
 static int taskmgr_thread(void *arg) {
@@ -103,49 +206,44 @@ static int taskmgr_thread(void *arg) {
 		aborted = mgr->aborted;
 
 		if(running && task == NULL && !aborted) {
+			++mgr->numidle;
 			SDL_CondWait(mgr->cond, mgr->mutex);
+			--mgr->numidle;
 		}
 
 		SDL_UnlockMutex(mgr->mutex);
 
 		if(task != NULL) {
-			SDL_LockMutex(task->mutex);
-
-			if(aborted && task->status == TASK_PENDING) {
-				task->status = TASK_CANCELLED;
+			if(aborted) {
+				task_claim(task, TASK_CANCELLED);
 			}
 
-			if(task->status == TASK_PENDING) {
-				task->status = TASK_RUNNING;
+			void *result = NULL;
+			bool executed = task_claim(task, TASK_RUNNING);
 
-				SDL_UnlockMutex(task->mutex);
-				task->result = task->callback(task->userdata);
-				SDL_LockMutex(task->mutex);
+			if(executed) {
+				result = task->callback(task->userdata);
+			} else {
+				// Cancelled, or claimed by task_wait on another thread.
+				attr_unused TaskStatus status = task_get_status(task);
+				assert(status == TASK_CANCELLED || status == TASK_RUNNING || status == TASK_FINISHED);
+			}
 
-				assert(task->in_queue);
-				task->in_queue = false;
-				(void)SDL_AtomicDecRef(&mgr->numtasks);
-
-				if(task->disowned) {
-					SDL_UnlockMutex(task->mutex);
-					task_free(task);
-				} else {
-					task->status = TASK_FINISHED;
-					SDL_CondBroadcast(task->cond);
-					SDL_UnlockMutex(task->mutex);
-				}
-			} else if(task->status == TASK_CANCELLED || task->status == TASK_RUNNING || task->status == TASK_FINISHED) {
-				assert(task->in_queue);
-				task->in_queue = false;
-				(void)SDL_AtomicDecRef(&mgr->numtasks);
-				bool task_disowned = task->disowned;
-				SDL_UnlockMutex(task->mutex);
+			SDL_LockMutex(task->mutex);
+			assert(task->in_queue);
+			task->in_queue = false;
+			(void)SDL_AtomicDecRef(&mgr->numtasks);
+			bool task_disowned = task->disowned;
+
+			if(executed && !task_disowned) {
+				task_publish_result(task, result);
+				SDL_CondBroadcast(task->cond);
+			}
 
-				if(task_disowned) {
-					task_free(task);
-				}
-			} else {
-				UNREACHABLE;
+			SDL_UnlockMutex(task->mutex);
+
+			if(task_disowned) {
+				task_free(task);
 			}
 		} else if(!running) {
 			break;
@@ -236,22 +334,10 @@ static int task_prio_func(List *ltask) {
 Task *taskmgr_submit(TaskManager *mgr, TaskParams params) {
 	assert(params.callback != NULL);
 
-	auto task = ALLOC(Task, {
-		.callback = params.callback,
-		.userdata_free_callback = params.userdata_free_callback,
-		.userdata = params.userdata,
-		.prio = params.prio,
-		.status = TASK_PENDING,
-	});
-
-	if(!(task->mutex = SDL_CreateMutex())) {
-		log_sdl_error(LOG_WARN, "SDL_CreateMutex");
-		goto fail;
-	}
+	Task *task = task_alloc(&params, TASK_PENDING);
 
-	if(!(task->cond = SDL_CreateCond())) {
-		log_sdl_error(LOG_WARN, "SDL_CreateCond");
-		goto fail;
+	if(task == NULL) {
+		return NULL;
 	}
 
 	SDL_LockMutex(mgr->mutex);
@@ -264,14 +350,14 @@ Task *taskmgr_submit(TaskManager *mgr, TaskParams params) {
 
 	task->in_queue = true;
 	SDL_AtomicIncRef(&mgr->numtasks);
-	SDL_CondSignal(mgr->cond);
+
+	if(mgr->numidle > 0) {
+		SDL_CondSignal(mgr->cond);
+	}
+
 	SDL_UnlockMutex(mgr->mutex);
 
 	return task;
-
-fail:
-	task_free(task);
-	return NULL;
 }
 
 uint taskmgr_remaining(TaskManager *mgr) {
@@ -312,84 +398,58 @@ void taskmgr_abort(TaskManager *mgr) {
 }
 
 TaskStatus task_status(Task *task) {
-	TaskStatus result = TASK_INVALID;
-
-	if(task != NULL) {
-		SDL_LockMutex(task->mutex);
-		result = task->status;
-		SDL_UnlockMutex(task->mutex);
+	if(task == NULL) {
+		return TASK_INVALID;
 	}
 
-	return result;
-}
-
-static void *task_offload(Task *task) {
-	assert(task->status == TASK_PENDING);
-	task->status = TASK_RUNNING;
-	SDL_UnlockMutex(task->mutex);
-	void *result = task->callback(task->userdata);
-	SDL_LockMutex(task->mutex);
-	assert(!task->disowned);
-	task->status = TASK_FINISHED;
-	task->result = result;
-	SDL_CondBroadcast(task->cond);
-	return result;
+	return task_get_status(task);
 }
 
 bool task_wait(Task *task, void **result) {
-	bool success = false;
-
 	if(task == NULL) {
-		return success;
+		return false;
 	}
 
-	void *_result = NULL;
+	for(;;) {
+		switch(task_get_status(task)) {
+			case TASK_FINISHED:
+				// Pairs with the barrier in task_publish_result.
+				SDL_MemoryBarrierAcquire();
+				if(result != NULL) {
+					*result = task->result;
+				}
+				return true;
 
-	SDL_LockMutex(task->mutex);
+			case TASK_CANCELLED:
+				return false;
 
-	if(task->status == TASK_CANCELLED) {
-		success = false;
-	} else if(task->status == TASK_FINISHED) {
-		success = true;
-		_result = task->result;
-	} else if(task->status == TASK_RUNNING) {
-		SDL_CondWait(task->cond, task->mutex);
-		_result = task->result;
-		success = (task->status == TASK_FINISHED);
-	} else if(task->status == TASK_PENDING) {
-		// fine, i'll do it myself
-		_result = task_offload(task);
-		success = true;
-	} else {
-		UNREACHABLE;
-	}
+			case TASK_PENDING:
+				if(task_claim(task, TASK_RUNNING)) {
+					// fine, i'll do it myself
+					assert(!task->disowned);
+					task_complete(task, task->callback(task->userdata));
+				}
+				break;
 
-	SDL_UnlockMutex(task->mutex);
+			case TASK_RUNNING:
+				SDL_LockMutex(task->mutex);
+				while(task_get_status(task) == TASK_RUNNING) {
+					SDL_CondWait(task->cond, task->mutex);
+				}
+				SDL_UnlockMutex(task->mutex);
+				break;
 
-	if(success && result != NULL) {
-		*result = _result;
+			default: UNREACHABLE;
+		}
 	}
-
-	return success;
 }
 
 bool task_cancel(Task *task) {
-	bool success = false;
-
 	if(task == NULL) {
-		return success;
+		return false;
 	}
 
-	SDL_LockMutex(task->mutex);
-
-	if(task->status == TASK_PENDING) {
-		task->status = TASK_CANCELLED;
-		success = true;
-	}
-
-	SDL_UnlockMutex(task->mutex);
-
-	return success;
+	return task_claim(task, TASK_CANCELLED);
 }
 
 bool task_detach(Task *task) {
@@ -436,16 +496,19 @@ void taskmgr_global_shutdown(void) {
 		taskmgr_finish(g_taskmgr);
 		g_taskmgr = NULL;
 	}
+
+	task_pool_shutdown();
 }
 
 Task *taskmgr_global_submit(TaskParams params) {
 	if(g_taskmgr == NULL) {
-		return ALLOC(Task, {
-			.callback = params.callback,
-			.userdata = params.userdata,
-			.userdata_free_callback = params.userdata_free_callback,
-			.result = params.callback(params.userdata),
-		});
+		Task *task = task_alloc(&params, TASK_RUNNING);
+
+		if(task != NULL) {
+			task_publish_result(task, params.callback(params.userdata));
+		}
+
+		return task;
 	}
 
 	return taskmgr_submit(g_taskmgr, params);
@@ -255,6 +255,10 @@ typedef _Complex double cmplx;
 #define attr_printf(fmt_index, firstarg_index) \
 	__attribute__ ((format(FORMAT_ATTR, fmt_index, firstarg_index)))
 
+// Variable is passed by pointer to the specified function when it goes out of scope.
+#define attr_cleanup(func) \
+	__attribute__ ((cleanup(func)))
+
 // Function must be inlined regardless of optimization settings.
 #define attr_must_inline \
 	__attribute__ ((always_inline))
@@ -20,14 +20,16 @@ Rect ellipse_bbox(Ellipse e) {
 }
 
 bool point_in_ellipse(cmplx p, Ellipse e) {
+	return point_in_ellipse_with_bbox(p, e, ellipse_bbox(e));
+}
+
+bool point_in_ellipse_with_bbox(cmplx p, Ellipse e, Rect e_bbox) {
 	double Xp = creal(p);
 	double Yp = cimag(p);
 	double Xe = creal(e.origin);
 	double Ye = cimag(e.origin);
 	double a = e.angle;
 
-	Rect e_bbox = ellipse_bbox(e);
-
 	return point_in_rect(p, e_bbox) && (
 		pow(cos(a) * (Xp - Xe) + sin(a) * (Yp - Ye), 2) / pow(creal(e.axes)/2, 2) +
 		pow(sin(a) * (Xp - Xe) - cos(a) * (Yp - Ye), 2) / pow(cimag(e.axes)/2, 2)
@@ -92,29 +94,66 @@ static double lineseg_circle_intersect_fallback(LineSegment seg, Circle c) {
 	return -1;
 }
 
-bool lineseg_ellipse_intersect(LineSegment seg, Ellipse e) {
-	if(segment_ellipse_nonintersection_heuristic(seg, e)) {
-		return false;
-	}
-
-	// Transform the coordinate system so that the ellipse becomes a circle
-	// with origin at (0, 0) and diameter equal to its X axis. Then we can
-	// calculate the segment-circle intersection.
+// Transform the coordinate system so that the ellipse becomes a circle
+// with origin at (0, 0) and diameter equal to its X axis. Then we can
+// calculate the segment-circle intersection.
+//
+// The translation and rotation only depend on the ellipse's origin and angle,
+// so they're split out to be shared between ellipses that only differ in size.
 
-	seg.a -= e.origin;
-	seg.b -= e.origin;
+static inline LineSegment lineseg_to_ellipse_space(LineSegment seg, cmplx origin, double angle) {
+	seg.a -= origin;
+	seg.b -= origin;
 
-	double ratio = creal(e.axes) / cimag(e.axes);
-	cmplx rotation = cexp(I * -e.angle);
+	cmplx rotation = cexp(I * -angle);
 	seg.a *= rotation;
 	seg.b *= rotation;
+
+	return seg;
+}
+
+static inline bool lineseg_rotated_ellipse_intersect(LineSegment seg, cmplx axes) {
+	double ratio = creal(axes) / cimag(axes);
 	seg.a = creal(seg.a) + I * ratio * cimag(seg.a);
 	seg.b = creal(seg.b) + I * ratio * cimag(seg.b);
 
-	Circle c = { .radius = creal(e.axes) / 2 };
+	Circle c = { .radius = creal(axes) / 2 };
 	return lineseg_circle_intersect_fallback(seg, c) >= 0;
 }
 
+bool lineseg_ellipse_intersect(LineSegment seg, Ellipse e) {
+	if(segment_ellipse_nonintersection_heuristic(seg, e)) {
+		return false;
+	}
+
+	seg = lineseg_to_ellipse_space(seg, e.origin, e.angle);
+	return lineseg_rotated_ellipse_intersect(seg, e.axes);
+}
+
+int lineseg_ellipses_intersect(LineSegment seg, cmplx origin, double angle, uint num_ellipses, const cmplx axes[num_ellipses]) {
+	LineSegment tseg = { 0 };
+	bool transformed = false;
+
+	for(uint i = 0; i < num_ellipses; ++i) {
+		Ellipse e = { .origin = origin, .axes = axes[i], .angle = angle };
+
+		if(segment_ellipse_nonintersection_heuristic(seg, e)) {
+			continue;
+		}
+
+		if(!transformed) {
+			tseg = lineseg_to_ellipse_space(seg, origin, angle);
+			transformed = true;
+		}
+
+		if(lineseg_rotated_ellipse_intersect(tseg, axes[i])) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
 double lineseg_circle_intersect(LineSegment seg, Circle c) {
 	Ellipse e = { .origin = c.origin, .axes = 2*c.radius + I*2*c.radius };
 	if(segment_ellipse_nonintersection_heuristic(seg, e)) {
@@ -92,8 +92,14 @@ typedef struct UnevenCapsule {
 Rect ellipse_bbox(Ellipse e) attr_const;
 Rect lineseg_bbox(LineSegment seg) attr_const;
 bool point_in_ellipse(cmplx p, Ellipse e) attr_const;
+// Like point_in_ellipse(), with e_bbox = ellipse_bbox(e) computed once for testing many points.
+bool point_in_ellipse_with_bbox(cmplx p, Ellipse e, Rect e_bbox) attr_const;
 double lineseg_circle_intersect(LineSegment seg, Circle c) attr_const;
 bool lineseg_ellipse_intersect(LineSegment seg, Ellipse e) attr_const;
+
+// Same as calling lineseg_ellipse_intersect() for each ellipse with the given origin, angle and
+// axes in order, but cheaper. Returns the index of the first intersecting ellipse, or -1.
+int lineseg_ellipses_intersect(LineSegment seg, cmplx origin, double angle, uint num_ellipses, const cmplx axes[num_ellipses]) attr_pure;
 double lineseg_closest_factor(LineSegment seg, cmplx p) attr_const;
 cmplx lineseg_closest_point(LineSegment seg, cmplx p) attr_const;
 bool lineseg_lineseg_intersection(LineSegment seg0, LineSegment seg1, cmplx *out);
@@ -152,6 +158,15 @@ void rect_move(Rect *r, cmplx pos) {
 }
 
 bool point_in_rect(cmplx p, Rect r);
+
+// Cheap pre-test for cabs(p - c.origin) < c.radius, done per axis.
+// Never rejects a point that the exact test would accept: |z| can't be smaller than either component.
+INLINE attr_const
+bool point_in_circle_bbox(cmplx p, Circle c) {
+	cmplx d = p - c.origin;
+	return fabs(creal(d)) < c.radius && fabs(cimag(d)) < c.radius;
+}
+
 bool rect_in_rect(Rect inner, Rect outer) attr_const;
 bool rect_rect_intersect(Rect r1, Rect r2, bool edges, bool corners) attr_const;
 bool rect_rect_intersection(Rect r1, Rect r2, bool edges, bool corners, Rect *out) attr_pure attr_nonnull(5);
@@ -15,6 +15,8 @@
  *  This implements a slightly modified Guillotine rect-packing algorithm.
  *  All subdivisions are tracked with a tree data structure, which enables fairly
  *  efficient deallocation.
+ *  Free sections are indexed by the magnitude of their width and height, so that
+ *  finding the best fit doesn't have to look at every free section.
  *  Rotations are not supported.
  */
 
@@ -35,19 +37,60 @@ struct RectPackSection {
 	RectPackSection *children[2];
 };
 
+// Bucket 0 holds sizes below 1; bucket n holds sizes in [2^(n-1), 2^n); the last one is unbounded.
+#define RP_NUM_BUCKETS 16
+
 struct RectPack {
 	RectPackSection root;
-	RectPackSection *freelist;
+	RectPackSection *free_buckets[RP_NUM_BUCKETS][RP_NUM_BUCKETS];  // [width][height]
+	uint16_t nonempty_buckets[RP_NUM_BUCKETS];  // bit h of [w] is set if free_buckets[w][h] has sections
 };
 
+static_assert(RP_NUM_BUCKETS <= sizeof(((RectPack*)0)->nonempty_buckets[0]) * CHAR_BIT, "Bucket mask too small");
+
+static inline uint size_bucket(double size) {
+	if(size < 1) {
+		return 0;
+	}
+
+	int exp;
+	frexp(size, &exp);
+	return imin(exp, RP_NUM_BUCKETS - 1);
+}
+
+static inline double bucket_min_size(uint bucket) {
+	return bucket ? ldexp(1, bucket - 1) : 0;
+}
+
 static inline bool section_is_free(RectPackSection *s) {
 	return s->next != s;
 }
 
+static void section_link_free(RectPack *rp, RectPackSection *s) {
+	uint bw = size_bucket(rect_width(s->rect));
+	uint bh = size_bucket(rect_height(s->rect));
+	list_push(&rp->free_buckets[bw][bh], s);
+	rp->nonempty_buckets[bw] |= 1u << bh;
+}
+
+static void section_unlink_free(RectPack *rp, RectPackSection *s) {
+	uint bw = size_bucket(rect_width(s->rect));
+	uint bh = size_bucket(rect_height(s->rect));
+	list_unlink(&rp->free_buckets[bw][bh], s);
+
+	if(!rp->free_buckets[bw][bh]) {
+		rp->nonempty_buckets[bw] &= ~(1u << bh);
+	}
+}
+
+static inline void section_mark_used(RectPackSection *s) {
+	s->next = s->prev = s;
+}
+
 static inline void section_make_used(RectPack *rp, RectPackSection *s) {
 	assert(section_is_free(s));
-	list_unlink(&rp->freelist, s);
-	s->next = s->prev = s;
+	section_unlink_free(rp, s);
+	section_mark_used(s);
 }
 
 RectPack* rectpack_new(double width, double height) {
@@ -57,18 +100,14 @@ RectPack* rectpack_new(double width, double height) {
 			.bottom_right = CMPLX(width, height),
 		},
 	});
-	list_push(&rp->freelist, &rp->root);
+	section_link_free(rp, &rp->root);
 	assert(rectpack_is_empty(rp));
 	return rp;
 }
 
 bool rectpack_is_empty(RectPack *rp) {
-	if(rp->freelist == &rp->root) {
-		assert(rp->root.next == NULL);
-		return true;
-	}
-
-	return false;
+	// The root is only free when nothing is allocated; otherwise it's split or used.
+	return section_is_free(&rp->root);
 }
 
 static void delete_subsections(RectPackSection *restrict s) {
@@ -89,6 +128,9 @@ static void delete_subsections(RectPackSection *restrict s) {
 
 void rectpack_reset(RectPack *rp) {
 	delete_subsections(&rp->root);
+	memset(rp->free_buckets, 0, sizeof(rp->free_buckets));
+	memset(rp->nonempty_buckets, 0, sizeof(rp->nonempty_buckets));
+	section_link_free(rp, &rp->root);
 }
 
 void rectpack_free(RectPack *rp) {
@@ -128,7 +170,7 @@ void rectpack_reclaim(RectPack *rp, RectPackSection *s) {
 		assert(!section_is_free(s->parent));
 		assert(!section_is_free(s));
 
-		list_unlink(&rp->freelist, s->sibling);
+		section_unlink_free(rp, s->sibling);
 
 		// NOTE: the following frees s->sibling and s, in unspecified order
 
@@ -145,7 +187,7 @@ void rectpack_reclaim(RectPack *rp, RectPackSection *s) {
 		RP_DEBUG("done reclaiming parent of %p", (void*)s);
 	} else {
 		RP_DEBUG("added to free list");
-		list_push(&rp->freelist, s);
+		section_link_free(rp, s);
 		assert(s != &rp->root || rectpack_is_empty(rp));
 	}
 
@@ -158,19 +200,48 @@ static RectPackSection *select_fittest_section(RectPack *rp, double width, doubl
 
 	RP_DEBUG("trying to fit %gx%g...", width, height);
 
-	for(RectPackSection *s = rp->freelist; s; s = s->next) {
-		assume(s->children[0] == NULL);
-		assume(s->children[1] == NULL);
+	uint min_bh = size_bucket(height);
+
+	// Fitness is at least (section_width - width) and (section_height - height), so a bucket
+	// can be skipped as soon as its smallest possible sections can't beat the best candidate.
+	for(uint bw = size_bucket(width); bw < RP_NUM_BUCKETS; ++bw) {
+		double min_fitness_w = fmax(0, bucket_min_size(bw) - width);
+
+		if(min_fitness_w >= fitness) {
+			break;
+		}
+
+		uint mask = rp->nonempty_buckets[bw] & ~((1u << min_bh) - 1);
 
-		double f = section_fitness(s, width, height);
+		while(mask) {
+			uint bh = __builtin_ctz(mask);
+			mask &= mask - 1;
 
-		if(!isnan(f) && f < fitness) {
-			best = s;
-			fitness = f;
-			RP_DEBUG("candidate: %g (%gx%g)", fitness, rect_width(best->rect), rect_height(best->rect));
+			if(fmax(min_fitness_w, bucket_min_size(bh) - height) >= fitness) {
+				break;
+			}
+
+			for(RectPackSection *s = rp->free_buckets[bw][bh]; s; s = s->next) {
+				assume(s->children[0] == NULL);
+				assume(s->children[1] == NULL);
+
+				double f = section_fitness(s, width, height);
+
+				if(!isnan(f) && f < fitness) {
+					best = s;
+					fitness = f;
+					RP_DEBUG("candidate: %g (%gx%g)", fitness, rect_width(best->rect), rect_height(best->rect));
+
+					if(f == 0) {
+						goto done;
+					}
+				}
+			}
 		}
 	}
 
+done:
+
 	if(best) {
 		RP_DEBUG("fitness for %gx%g: %f (%gx%g)", width, height, fitness, rect_width(best->rect), rect_height(best->rect));
 	} else {
@@ -207,7 +278,7 @@ static RectPackSection *split_horizontal(RectPack *rp, RectPackSection *s, doubl
 		height
 	);
 
-	section_make_used(rp, sub);
+	section_mark_used(sub);
 
 	sub->parent = s;
 	s->children[0] = sub;
@@ -222,7 +293,7 @@ static RectPackSection *split_horizontal(RectPack *rp, RectPackSection *s, doubl
 	s->children[1]->parent = s;
 	sub->sibling = s->children[1];
 	s->children[1]->sibling = sub;
-	list_push(&rp->freelist, s->children[1]);
+	section_link_free(rp, s->children[1]);
 
 	RP_DEBUG("made new subsections from %p: %p[%gx%g]; %p[%gx%g]",
 		(void*)s,
@@ -257,7 +328,7 @@ static RectPackSection *split_vertical(RectPack *rp, RectPackSection *s, double
 		rect_height(s->rect)
 	);
 
-	section_make_used(rp, sub);
+	section_mark_used(sub);
 
 	sub->parent = s;
 	s->children[0] = sub;
@@ -272,7 +343,7 @@ static RectPackSection *split_vertical(RectPack *rp, RectPackSection *s, double
 	s->children[1]->parent = s;
 	sub->sibling = s->children[1];
 	s->children[1]->sibling = sub;
-	list_push(&rp->freelist, s->children[1]);
+	section_link_free(rp, s->children[1]);
 
 	RP_DEBUG("made new subsections from %p: %p[%gx%g]; %p[%gx%g]",
 		(void*)s,
@@ -314,6 +385,49 @@ RectPackSection *rectpack_add(RectPack *rp, double width, double height) {
 	return split(rp, s, width, height);
 }
 
+static int rectpack_request_cmp(const void *a, const void *b) {
+	const RectPackRequest *ra = *(const RectPackRequest**)a;
+	const RectPackRequest *rb = *(const RectPackRequest**)b;
+
+	if(ra->height != rb->height) {
+		return ra->height < rb->height ? 1 : -1;
+	}
+
+	if(ra->width != rb->width) {
+		return ra->width < rb->width ? 1 : -1;
+	}
+
+	// Keep the order stable
+	return (ra > rb) - (ra < rb);
+}
+
+uint rectpack_add_batch(RectPack *rp, uint num_requests, RectPackRequest requests[num_requests]) {
+	auto order = ALLOC_ARRAY(num_requests, RectPackRequest*);
+	uint num_pending = 0;
+
+	for(uint i = 0; i < num_requests; ++i) {
+		if(!requests[i].section) {
+			order[num_pending++] = requests + i;
+		}
+	}
+
+	// Placing the tallest rects first leaves much less wasted space.
+	qsort(order, num_pending, sizeof(*order), rectpack_request_cmp);
+
+	uint num_added = 0;
+
+	for(uint i = 0; i < num_pending; ++i) {
+		RectPackRequest *r = order[i];
+
+		if((r->section = rectpack_add(rp, r->width, r->height))) {
+			++num_added;
+		}
+	}
+
+	mem_free(order);
+	return num_added;
+}
+
 Rect rectpack_section_rect(RectPackSection *s) {
 	return s->rect;
 }
@@ -26,6 +26,17 @@ void rectpack_free(RectPack *rp)
 RectPackSection *rectpack_add(RectPack *rp, double width, double height)
 	attr_nonnull(1);
 
+typedef struct RectPackRequest {
+	double width;
+	double height;
+	RectPackSection *section;  // set on success; requests that already have one are skipped
+} RectPackRequest;
+
+// Adds several rects at once, tallest first, which packs much tighter than adding them in
+// arbitrary order. Returns the number of rects that were placed.
+uint rectpack_add_batch(RectPack *rp, uint num_requests, RectPackRequest requests[num_requests])
+	attr_nonnull(1);
+
 Rect rectpack_section_rect(RectPackSection *s)
 	attr_nonnull(1);
 
@@ -0,0 +1,130 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2026, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2026, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#include "taisei.h"
+
+#include "spatialgrid.h"
+#include "util.h"
+
+void spatialgrid_init(SpatialGrid *grid, Rect bounds, double cell_size) {
+	assert(cell_size > 0);
+
+	*grid = (SpatialGrid) {
+		.bounds = bounds,
+		.inv_cell_size = 1.0 / cell_size,
+		.cols = imax(1, ceil(rect_width(bounds) / cell_size)),
+		.rows = imax(1, ceil(rect_height(bounds) / cell_size)),
+	};
+
+	assert(grid->cols <= UINT16_MAX);
+	assert(grid->rows <= UINT16_MAX);
+
+	dynarray_ensure_capacity(&grid->cell_offsets, grid->cols * grid->rows + 1);
+	grid->cell_offsets.num_elements = grid->cols * grid->rows + 1;
+}
+
+void spatialgrid_free(SpatialGrid *grid) {
+	dynarray_free_data(&grid->entries);
+	dynarray_free_data(&grid->cell_ids);
+	dynarray_free_data(&grid->cell_offsets);
+}
+
+void spatialgrid_begin(SpatialGrid *grid) {
+	grid->entries.num_elements = 0;
+}
+
+static inline uint16_t cell_coord(double v, double origin, double inv_cell_size, uint num_cells, uint16_t nan_val) {
+	double c = (v - origin) * inv_cell_size;
+
+	if(UNLIKELY(isnan(c))) {
+		return nan_val;
+	}
+
+	if(c < 0) {
+		return 0;
+	}
+
+	if(c >= num_cells) {
+		return num_cells - 1;
+	}
+
+	return (uint16_t)c;
+}
+
+void spatialgrid_insert(SpatialGrid *grid, uint32_t id, Rect aabb) {
+	double inv = grid->inv_cell_size;
+	uint cols = grid->cols;
+	uint rows = grid->rows;
+
+	// NaN bounds are treated as unbounded in that direction.
+	*dynarray_append(&grid->entries) = (SpatialGridEntry) {
+		.id = id,
+		.x0 = cell_coord(aabb.left,   grid->bounds.left, inv, cols, 0),
+		.y0 = cell_coord(aabb.top,    grid->bounds.top,  inv, rows, 0),
+		.x1 = cell_coord(aabb.right,  grid->bounds.left, inv, cols, cols - 1),
+		.y1 = cell_coord(aabb.bottom, grid->bounds.top,  inv, rows, rows - 1),
+	};
+}
+
+void spatialgrid_build(SpatialGrid *grid) {
+	uint cols = grid->cols;
+	uint num_cells = cols * grid->rows;
+	uint32_t *offsets = grid->cell_offsets.data;
+
+	// Counting sort into a CSR layout; stable, so per-cell insertion order is preserved.
+
+	memset(offsets, 0, sizeof(*offsets) * (num_cells + 1));
+	uint32_t total = 0;
+
+	dynarray_foreach_elem(&grid->entries, SpatialGridEntry *e, {
+		assert(e->x0 <= e->x1);
+		assert(e->y0 <= e->y1);
+
+		for(uint y = e->y0; y <= e->y1; ++y) {
+			for(uint x = e->x0; x <= e->x1; ++x) {
+				++offsets[y * cols + x + 1];
+			}
+		}
+
+		total += (e->x1 - e->x0 + 1) * (e->y1 - e->y0 + 1);
+	});
+
+	for(uint i = 1; i <= num_cells; ++i) {
+		offsets[i] += offsets[i - 1];
+	}
+
+	assert(offsets[num_cells] == total);
+
+	dynarray_ensure_capacity(&grid->cell_ids, imax(1, total));
+	grid->cell_ids.num_elements = total;
+
+	// Use the start offsets as fill cursors, then shift them back afterwards.
+	uint32_t *ids = grid->cell_ids.data;
+
+	dynarray_foreach_elem(&grid->entries, SpatialGridEntry *e, {
+		for(uint y = e->y0; y <= e->y1; ++y) {
+			for(uint x = e->x0; x <= e->x1; ++x) {
+				ids[offsets[y * cols + x]++] = e->id;
+			}
+		}
+	});
+
+	memmove(offsets + 1, offsets, sizeof(*offsets) * num_cells);
+	offsets[0] = 0;
+}
+
+const uint32_t *spatialgrid_query_point(SpatialGrid *grid, cmplx p, uint *out_num_ids) {
+	double inv = grid->inv_cell_size;
+	uint x = cell_coord(creal(p), grid->bounds.left, inv, grid->cols, 0);
+	uint y = cell_coord(cimag(p), grid->bounds.top,  inv, grid->rows, 0);
+	uint cell = y * grid->cols + x;
+	uint32_t *offsets = grid->cell_offsets.data;
+
+	*out_num_ids = offsets[cell + 1] - offsets[cell];
+	return grid->cell_ids.data + offsets[cell];
+}
@@ -0,0 +1,58 @@
+/*
+ * This software is licensed under the terms of the MIT License.
+ * See COPYING for further information.
+ * ---
+ * Copyright (c) 2011-2026, Lukas Weber <laochailan@web.de>.
+ * Copyright (c) 2012-2026, Andrei Alexeyev <akari@taisei-project.org>.
+ */
+
+#pragma once
+#include "taisei.h"
+
+#include "geometry.h"
+#include "dynarray.h"
+
+/*
+ * A uniform grid broadphase over axis-aligned bounding boxes.
+ *
+ * Usage: spatialgrid_begin(), then spatialgrid_insert() for every object, then
+ * spatialgrid_build(). Objects are identified by an arbitrary uint32_t id, usually
+ * an index into some external array.
+ *
+ * Within each cell, ids are stored in insertion order. Anything outside the grid
+ * bounds is clamped into the border cells, so queries never miss objects that
+ * overlap the query point, no matter where they are.
+ */
+
+typedef struct SpatialGridEntry {
+	uint32_t id;
+	uint16_t x0, y0, x1, y1;
+} SpatialGridEntry;
+
+typedef struct SpatialGrid {
+	DYNAMIC_ARRAY(SpatialGridEntry) entries;
+	DYNAMIC_ARRAY(uint32_t) cell_ids;
+	DYNAMIC_ARRAY(uint32_t) cell_offsets;
+	Rect bounds;
+	double inv_cell_size;
+	uint cols, rows;
+} SpatialGrid;
+
+void spatialgrid_init(SpatialGrid *grid, Rect bounds, double cell_size)
+	attr_nonnull_all;
+
+void spatialgrid_free(SpatialGrid *grid)
+	attr_nonnull_all;
+
+void spatialgrid_begin(SpatialGrid *grid)
+	attr_nonnull_all;
+
+void spatialgrid_insert(SpatialGrid *grid, uint32_t id, Rect aabb)
+	attr_nonnull_all;
+
+void spatialgrid_build(SpatialGrid *grid)
+	attr_nonnull_all;
+
+// Returns the ids of all objects that may overlap point p, in insertion order.
+const uint32_t *spatialgrid_query_point(SpatialGrid *grid, cmplx p, uint *out_num_ids)
+	attr_nonnull_all;
@@ -64,6 +64,10 @@ int vfs_dir_list_order_ascending(const void *a, const void *b);
 int vfs_dir_list_order_descending(const void *a, const void *b);
 
 char* vfs_repr(const char *path, bool try_syspath) attr_nonnull(1) attr_nodiscard;
+
+// Returns the filesystem path that backs a VFS path, or NULL if there is none.
+// For files inside zip archives, this is a path into the archive that can't be opened directly.
+char* vfs_syspath(const char *path) attr_nonnull(1) attr_nodiscard;
 bool vfs_print_tree(SDL_RWops *dest, const char *path) attr_nonnull(1, 2);
 
 // these are defined in private.c, but need to be accessible from external code
@@ -178,6 +178,24 @@ void vfs_syspath_join(char *buf, size_t bufsize, const char *parent, const char
 	}
 }
 
+bool vfs_syspath_rename(const char *src, const char *dst) {
+	if(rename(src, dst) != 0) {
+		vfs_set_error("Can't rename %s to %s: %s", src, dst, strerror(errno));
+		return false;
+	}
+
+	return true;
+}
+
+bool vfs_syspath_remove(const char *path) {
+	if(remove(path) != 0) {
+		vfs_set_error("Can't remove %s: %s", path, strerror(errno));
+		return false;
+	}
+
+	return true;
+}
+
 static VFSNode *vfs_syspath_create_internal(char *path) {
 	vfs_syspath_normalize_inplace(path);
 	return &VFS_ALLOC(VFSSysPathNode, {
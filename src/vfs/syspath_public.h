@@ -23,3 +23,9 @@ void vfs_syspath_normalize(char *buf, size_t bufsize, const char *path);
 char *vfs_syspath_normalize_inplace(char *path);
 void vfs_syspath_join(char *buf, size_t bufsize, const char *parent, const char *child);
 char *vfs_syspath_join_alloc(const char *parent, const char *child);
+
+// Atomically replaces [dst] with [src] if possible; [dst] need not exist. Sets the VFS error on failure.
+bool vfs_syspath_rename(const char *src, const char *dst) attr_nonnull(1, 2);
+
+// Removes a file or an empty directory. Sets the VFS error on failure.
+bool vfs_syspath_remove(const char *path) attr_nonnull(1);
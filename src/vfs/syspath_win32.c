@@ -293,6 +293,39 @@ void vfs_syspath_join(char *buf, size_t bufsize, const char *parent, const char
 	}
 }
 
+bool vfs_syspath_rename(const char *src, const char *dst) {
+	wchar_t *wsrc = WIN_UTF8ToString((char*)src);
+	wchar_t *wdst = WIN_UTF8ToString((char*)dst);
+	bool ok = MoveFileEx(wsrc, wdst, MOVEFILE_REPLACE_EXISTING);
+
+	if(!ok) {
+		vfs_set_error_win32();
+	}
+
+	mem_free(wsrc);
+	mem_free(wdst);
+	return ok;
+}
+
+bool vfs_syspath_remove(const char *path) {
+	wchar_t *wpath = WIN_UTF8ToString((char*)path);
+	DWORD attrs = GetFileAttributes(wpath);
+	bool ok;
+
+	if(attrs != INVALID_FILE_ATTRIBUTES && (attrs & FILE_ATTRIBUTE_DIRECTORY)) {
+		ok = RemoveDirectory(wpath);
+	} else {
+		ok = DeleteFile(wpath);
+	}
+
+	if(!ok) {
+		vfs_set_error_win32();
+	}
+
+	mem_free(wpath);
+	return ok;
+}
+
 static bool vfs_syspath_validate(char *path) {
 	char *c = strchr(path, ':');
 